@@ -4,23 +4,38 @@
 #include <stdlib.h>
 #include <math.h>
 #include <limits.h>
+#include <float.h>
+#include <time.h>
 
 #include "fsnav.h"
 
 // core functions to be used in host application
 	// basic
 char fsnav_add_plugin(void(*newplugin)(void));                                // add plugin to the plugin execution list,                             input: pointer to plugin function,                       output: OK/not OK (1/0)
+char fsnav_add_plugin_ext(void(*init)(void*), void(*step)(void*), void(*terminate)(void*), void* context); // add plugin with separate callbacks, input: pointers to callbacks (NULL to skip) and context, output: OK/not OK (1/0)
+char fsnav_add_plugin_block(void(*init)(void*), size_t(*block)(void*, fsnav_imu_sample*, size_t), void(*terminate)(void*), void* context, char role); // add block input/output plugin, input: callbacks, context, role, output: OK/not OK (1/0)
 char fsnav_init      (char*                 );                                // initialize the bus, except for core,                                 input: configuration string (see description),           output: OK/not OK (1/0)
 char fsnav_step      (void                  );                                // step through the plugin execution list,                                                                                       output: OK/not OK (1/0)
+char fsnav_step_n    (size_t n              );                                // step through the plugin execution list n times, buffering block plugins, input: number of steps,                             output: OK/not OK (1/0)
 char fsnav_terminate (void                  );                                // terminate operation,                                                                                                          output: OK/not OK (1/0)
 	
 	// advanced scheduling
 char fsnav_remove_plugin    (void(*plugin   )(void)                        ); // remove all instances of the plugin from the plugin execution list,   input: pointer to plugin function,                       output: OK/not OK (1/0)
 char fsnav_replace_plugin   (void(*oldplugin)(void), void(*newplugin)(void)); // replace all instances of the plugin by another one,                  input: pointers to old and new plugin functions,         output: OK/not OK (1/0)
 char fsnav_schedule_plugin  (void(*newplugin)(void), int cycle, int shift  ); // add scheduled plugin to the plugin execution list,                   input: pointer to plugin function, cycle, shift,         output: OK/not OK (1/0)
+char fsnav_schedule_plugin_ext(void(*init)(void*), void(*step)(void*), void(*terminate)(void*), void* context, int cycle, int shift); // add scheduled plugin with separate callbacks, input: callbacks, context, cycle, shift, output: OK/not OK (1/0)
 char fsnav_reschedule_plugin(void(*plugin   )(void), int cycle, int shift  ); // reschedule all instances of the plugin in the plugin execution list, input: pointer to plugin function, new cycle, new shift, output: OK/not OK (1/0)
 char fsnav_suspend_plugin   (void(*plugin   )(void)                        ); // suspend all instances of the plugin in the plugin execution list,    input: pointer to plugin function,                       output: OK/not OK (1/0)
 char fsnav_resume_plugin    (void(*plugin   )(void)                        ); // resume all instances of the plugin in the plugin execution list,     input: pointer to plugin function,                       output: OK/not OK (1/0)
+char fsnav_balance_plugins  (char on                                       ); // turn on/off automatic shift assignment for scheduled plugins,       input: 1/0 for on/off,                                   output: OK/not OK (1/0)
+char fsnav_subscribe_plugin (void(*plugin   )(void), unsigned int topics   ); // call all instances of the plugin only when subscribed topics are signalled, input: pointer to plugin function, topics, output: OK/not OK (1/0)
+void fsnav_signal           (unsigned int topics                           ); // signal topics to subscribed plugins,                                input: topics (FSNAV_TOPIC_*)
+char fsnav_retire_plugin    (void(*plugin   )(void)                        ); // retire all instances of the plugin, removing them at the end of the step, input: pointer to plugin function,       output: OK/not OK (1/0)
+
+	// increment accumulators between plugin rates
+fsnav_accum* fsnav_attach_accum(void(*plugin)(void), size_t x_count                          ); // attach an increment accumulator to a consumer plugin, input: pointer to plugin function, number of application-specific quantities, output: pointer to the accumulator, NULL if failed
+void         fsnav_accumulate  (double dt, double* w, double* f, double* x, size_t x_count); // integrate a sample into all increment accumulators,   input: time step, angular rate, specific force (NULL if invalid), application-specific quantities and their number
+void         fsnav_reset_accum (fsnav_accum* acc                                           ); // reset an increment accumulator after reading,         input: pointer to the accumulator
 
 
 
@@ -30,16 +45,27 @@ char fsnav_resume_plugin    (void(*plugin   )(void)                        ); //
 static fsnav_struct fsnav_bus = {
 	FSNAV_BUS_VERSION,           // ver
 	fsnav_add_plugin,            // add_plugin
+	fsnav_add_plugin_ext,        // add_plugin_ext
+	fsnav_add_plugin_block,      // add_plugin_block
 	fsnav_init,                  // init
 	fsnav_step,                  // step
+	fsnav_step_n,                // step_n
 	fsnav_terminate,             // terminate
 	fsnav_remove_plugin,         // remove_plugin
 	fsnav_replace_plugin,        // replace_plugin
 	fsnav_schedule_plugin,       // schedule_plugin
+	fsnav_schedule_plugin_ext,   // schedule_plugin_ext
 	fsnav_reschedule_plugin,     // reschedule_plugin
 	fsnav_suspend_plugin,        // suspend plugin
 	fsnav_resume_plugin,         // resume plugin
-	{ NULL, 0, 0, UINT_MAX, 0 } // core.plugins, core.plugin_count, core.exit_plugin_id, core.host_termination
+	fsnav_balance_plugins,       // balance_plugins
+	fsnav_subscribe_plugin,      // subscribe_plugin
+	fsnav_signal,                // signal
+	fsnav_retire_plugin,         // retire_plugin
+	fsnav_attach_accum,          // attach_accum
+	fsnav_accumulate,            // accumulate
+	fsnav_reset_accum,           // reset_accum
+	{ NULL, 0, 0, UINT_MAX, 0, 0, 1, 0, 0, -1, 0, 0, NULL, 0 } // core.plugins, core.plugin_count, core.current_plugin_id, core.exit_plugin_id, core.host_termination, core.revision, core.block_size, core.balance, core.balance_pending, core.balance_clock, core.current_topics, core.retired_count, core.accums, core.accum_count
 };
 
 fsnav_struct* fsnav = &fsnav_bus;
@@ -62,6 +88,126 @@ void fsnav_free_null(void** ptr)
 	*ptr = NULL;
 }
 
+	/*
+		empty plugin callback, used in place of callbacks omitted when adding a plugin
+		input:
+			void* context --- plugin context pointer, not used
+	*/
+void fsnav_plugin_noop(void* context)
+{
+	(void)context;
+}
+
+	/*
+		check whether an execution list entry is an instance of a given plugin
+		input:
+			fsnav_plugin* entry  --- pointer to an execution list entry
+			plugin               --- pointer to a plugin function, or a step callback cast to void(*)(void) for plugins with separate callbacks
+		return value:
+			1 if the entry is an instance of the plugin
+			0 otherwise
+	*/
+char fsnav_plugin_match(fsnav_plugin* entry, void(*plugin)(void))
+{
+	if (entry->func != NULL)
+		return entry->func == plugin;
+	else if (entry->block != NULL)
+		return (void(*)(void))(entry->block) == plugin;
+	else
+		return (void(*)(void))(entry->step) == plugin;
+}
+
+	/*
+		make sure a block plugin buffer holds at least core.block_size samples
+		input:
+			fsnav_plugin* entry --- pointer to an execution list entry
+		return value:
+			1 if successful
+			0 otherwise (failed to allocate/reallocate memory)
+	*/
+char fsnav_plugin_block_reserve(fsnav_plugin* entry)
+{
+	fsnav_imu_sample* reallocated_pointer;
+
+	if (entry->sample_size >= fsnav->core.block_size)
+		return 1;
+
+	reallocated_pointer = (fsnav_imu_sample*)realloc((void*)(entry->samples), fsnav->core.block_size*sizeof(fsnav_imu_sample));
+	if (reallocated_pointer == NULL)
+		return 0;
+
+	entry->samples     = reallocated_pointer;
+	entry->sample_size = fsnav->core.block_size;
+	return 1;
+}
+
+	/*
+		emit samples buffered by a block output plugin
+		input:
+			fsnav_plugin* entry --- pointer to an execution list entry
+	*/
+void fsnav_plugin_block_flush(fsnav_plugin* entry)
+{
+	if (entry->block_role != FSNAV_BLOCK_OUTPUT || entry->sample_count == 0)
+		return;
+
+	entry->block(entry->context, entry->samples, entry->sample_count);
+	entry->sample_count = 0;
+}
+
+	/*
+		free increment accumulators of consumers no longer in the plugin execution list
+		note:
+			called after plugins are removed, replaced or retired, so that producers stop integrating orphaned accumulators
+	*/
+void fsnav_accum_drop_orphans(void)
+{
+	size_t i, j, k;
+
+	for (i = 0, j = 0; i < fsnav->core.accum_count; i++) {
+		for (k = 0; k < fsnav->core.plugin_count; k++)
+			if (fsnav_plugin_match(fsnav->core.plugins + k, fsnav->core.accums[i]->owner))
+				break;
+		if (k == fsnav->core.plugin_count) {
+			fsnav_free_null((void**)(&(fsnav->core.accums[i]->x)));
+			fsnav_free_null((void**)(&(fsnav->core.accums[i])));
+			continue;
+		}
+		fsnav->core.accums[j++] = fsnav->core.accums[i];
+	}
+	fsnav->core.accum_count = j;
+}
+
+	/*
+		remove retired plugins from the plugin execution list
+		note:
+			output buffers of retired block plugins are emitted before removal,
+			the execution list memory is kept allocated until the next reallocation
+	*/
+void fsnav_plugin_compact(void)
+{
+	size_t i, j;
+
+	for (i = 0, j = 0; i < fsnav->core.plugin_count; i++) {
+		if (fsnav->core.plugins[i].retired) {
+			fsnav_plugin_block_flush(fsnav->core.plugins + i);
+			fsnav_free_null((void**)(&(fsnav->core.plugins[i].samples)));
+			continue;
+		}
+		if (j < i)
+			fsnav->core.plugins[j] = fsnav->core.plugins[i];
+		j++;
+	}
+
+	if (j < fsnav->core.plugin_count) {
+		fsnav->core.plugin_count = j;
+		fsnav->core.revision++;
+		fsnav->core.balance_pending = 1;
+		fsnav_accum_drop_orphans();
+	}
+	fsnav->core.retired_count = 0;
+}
+
 	/* 
 		locate parameter group within a configuration string
 		input:
@@ -240,6 +386,8 @@ char fsnav_init_sol(fsnav_sol* sol, char* settings, const size_t len)
 	for (i = 0; i < 3; i++)
 		sol->rpy[i] = 0; // attitude angles
 	sol->rpy_valid  = 0;
+	sol->att_fresh  = FSNAV_SOL_Q | FSNAV_SOL_L | FSNAV_SOL_RPY; // all stored as is
+	sol->att_fast   = 0;
 	
 	// clock
 	sol->dt         = 0;
@@ -280,6 +428,96 @@ void fsnav_free_sol(fsnav_sol* sol)
 	fsnav_free_null((void**)(&(sol->metrics)));
 }
 
+	/*
+		mark attitude representations written by a plugin as up to date, and the others as stale
+		input:
+			fsnav_sol* sol   --- pointer to a navigation solution structure
+			const char fresh --- bit mask of the representations just written: FSNAV_SOL_Q | FSNAV_SOL_L | FSNAV_SOL_RPY
+		note:
+			to be called by attitude plugins after each update instead of converting to all representations,
+			stale ones are derived at most once per update by the first fsnav_sol_get_q/L/rpy call (memo);
+			a plugin writing attitude without the call must keep all three representations consistent
+	*/
+void fsnav_sol_set_att(fsnav_sol* sol, const char fresh)
+{
+	sol->att_fresh = fresh & (FSNAV_SOL_Q | FSNAV_SOL_L | FSNAV_SOL_RPY);
+}
+
+	/*
+		get attitude matrix, deriving it from the quaternion or angles if stale
+		input:
+			fsnav_sol* sol --- pointer to a navigation solution structure
+		return value:
+			pointer to sol->L, NULL if not valid
+	*/
+double* fsnav_sol_get_L(fsnav_sol* sol)
+{
+	if (!(sol->att_fresh & FSNAV_SOL_L)) {
+		if (sol->att_fresh & FSNAV_SOL_Q) {
+			if (sol->q_valid)
+				fsnav_linal_quat2mat(sol->L, sol->q);
+			sol->L_valid = sol->q_valid;
+		}
+		else if (sol->att_fresh & FSNAV_SOL_RPY) {
+			if (sol->rpy_valid)
+				fsnav_linal_rpy2mat(sol->L, sol->rpy);
+			sol->L_valid = sol->rpy_valid;
+		}
+		else
+			sol->L_valid = 0;
+		sol->att_fresh |= FSNAV_SOL_L;
+	}
+	return sol->L_valid ? sol->L : NULL;
+}
+
+	/*
+		get attitude quaternion, deriving it from the matrix if stale
+		input:
+			fsnav_sol* sol --- pointer to a navigation solution structure
+		return value:
+			pointer to sol->q, NULL if not valid
+	*/
+double* fsnav_sol_get_q(fsnav_sol* sol)
+{
+	double *L;
+
+	if (!(sol->att_fresh & FSNAV_SOL_Q)) {
+		L = fsnav_sol_get_L(sol);
+		if (L != NULL)
+			fsnav_linal_mat2quat(sol->q, L);
+		sol->q_valid = sol->L_valid;
+		sol->att_fresh |= FSNAV_SOL_Q;
+	}
+	return sol->q_valid ? sol->q : NULL;
+}
+
+	/*
+		get attitude angles, deriving them from the matrix if stale
+		input:
+			fsnav_sol* sol --- pointer to a navigation solution structure
+		return value:
+			pointer to sol->rpy, NULL if not valid
+		note:
+			fsnav_linal_mat2rpy_fast is used when sol->att_fast is set
+	*/
+double* fsnav_sol_get_rpy(fsnav_sol* sol)
+{
+	double *L;
+
+	if (!(sol->att_fresh & FSNAV_SOL_RPY)) {
+		L = fsnav_sol_get_L(sol);
+		if (L != NULL) {
+			if (sol->att_fast)
+				fsnav_linal_mat2rpy_fast(sol->rpy, L);
+			else
+				fsnav_linal_mat2rpy     (sol->rpy, L);
+		}
+		sol->rpy_valid = sol->L_valid;
+		sol->att_fresh |= FSNAV_SOL_RPY;
+	}
+	return sol->rpy_valid ? sol->rpy : NULL;
+}
+
 
 
 
@@ -311,7 +549,10 @@ void fsnav_init_imu_const()
 	*/
 char fsnav_init_imu(fsnav_imu* imu)
 {
+	const char tol_token[] = "geodetic_tolerance"; // token to look for in settings
+
 	size_t i;
+	char *cfgptr;
 
 	// validity flags
 	imu-> w_valid = 0;
@@ -334,6 +575,12 @@ char fsnav_init_imu(fsnav_imu* imu)
 	// drop the solution
 	if (!fsnav_init_sol(&(imu->sol), imu->cfg, imu->cfglength))
 		return 0;
+	// geodetic terms are derived on the first access
+	imu->geo.valid = 0;
+	cfgptr = fsnav_locate_token(tol_token, imu->cfg, imu->cfglength, '=');
+	imu->geo.tol = (cfgptr != NULL) ? atof(cfgptr) : 0;
+	if (!(imu->geo.tol >= 0) || !isfinite(imu->geo.tol))
+		imu->geo.tol = 0;
 
 	return 1;
 }
@@ -358,6 +605,52 @@ void fsnav_free_imu(void)
 	fsnav->imu = NULL;
 }
 
+	/*
+		get geodetic terms at the inertial solution position, deriving them if the position moved
+		input:
+			fsnav_imu* imu --- pointer to a IMU structure
+		return value:
+			pointer to imu->geo
+		note:
+			terms are derived from imu->sol.llh regardless of imu->sol.llh_valid, the caller checks validity;
+			latitude terms are derived at most once per position update, or once per imu->geo.tol meters along the meridian,
+			curvature radii are adjusted for height whenever height changes;
+			curvature radii use Taylor expansions in e^2*sin(lat)^2 within 0.5 m;
+			imu->geo.valid is to be dropped after changing fsnav->imu_const
+	*/
+fsnav_geo* fsnav_imu_get_geo(fsnav_imu* imu)
+{
+	fsnav_geo *geo = &(imu->geo);
+	double e2s2, e4s4; // e^2*sin(lat)^2, (e^2*sin(lat)^2)^2
+
+	// latitude terms
+	if (!geo->valid || fabs(imu->sol.llh[1] - geo->lat)*fsnav->imu_const.a > geo->tol) {
+		geo->lat   = imu->sol.llh[1];
+		geo->sphi  = sin(geo->lat);
+		geo->cphi  = cos(geo->lat);
+		geo->s2phi = 2*geo->sphi*geo->cphi;
+		geo->c2phi = (geo->cphi - geo->sphi)*(geo->cphi + geo->sphi);
+		e2s2 = fsnav->imu_const.e2*geo->sphi*geo->sphi;
+		e4s4 = e2s2*e2s2;
+		geo->Re = fsnav->imu_const.a*(1 + e2s2/2 + 3*e4s4/8);
+		geo->Rn = geo->Re*(1 - fsnav->imu_const.e2)*(1 + e2s2 + e4s4 + e2s2*e4s4);
+		geo->u[0] = 0;
+		geo->u[1] = fsnav->imu_const.u*geo->cphi;
+		geo->u[2] = fsnav->imu_const.u*geo->sphi;
+		geo->h     = imu->sol.llh[2];
+		geo->Re_h  = geo->Re + geo->h;
+		geo->Rn_h  = geo->Rn + geo->h;
+		geo->valid = 1;
+	}
+	// height adjustment
+	else if (imu->sol.llh[2] != geo->h) {
+		geo->h     = imu->sol.llh[2];
+		geo->Re_h  = geo->Re + geo->h;
+		geo->Rn_h  = geo->Rn + geo->h;
+	}
+	return geo;
+}
+
 
 
 
@@ -1062,8 +1355,18 @@ void fsnav_free()
 	size_t r;
 
 	// core
+	for (r = 0; r < fsnav->core.plugin_count; r++)
+		fsnav_free_null((void**)(&(fsnav->core.plugins[r].samples)));
 	fsnav_free_null((void**)(&(fsnav->core.plugins)));
 	fsnav->core.plugin_count = 0;
+	fsnav->core.retired_count = 0;
+	fsnav->core.revision++;
+	for (r = 0; r < fsnav->core.accum_count; r++) {
+		fsnav_free_null((void**)(&(fsnav->core.accums[r]->x)));
+		fsnav_free_null((void**)(&(fsnav->core.accums[r])));
+	}
+	fsnav_free_null((void**)(&(fsnav->core.accums)));
+	fsnav->core.accum_count = 0;
 
 	// configuration string
 	fsnav_free_null((void**)(&(fsnav->cfg)));
@@ -1112,10 +1415,38 @@ void fsnav_free()
 		return value: 
 			1 if successful
 			0 otherwise (failed to allocate/realocate memory, plugin limit reached)
+		note:
+			a single-function plugin is called in every mode and branches on fsnav->mode by itself,
+			the core acts as an adapter to the init/step/terminate callback interface
 	*/
 char fsnav_add_plugin(void(*newplugin)(void))
+{
+	if (!fsnav_add_plugin_ext(NULL, NULL, NULL, NULL))
+		return 0;
+
+	fsnav->core.plugins[fsnav->core.plugin_count-1].func = newplugin;
+
+	return 1;
+}
+
+	/* 
+		add plugin with separate init, step and terminate callbacks to the plugin execution list	
+		input:
+			init      --- pointer to init callback, called once in init mode, NULL to skip
+			step      --- pointer to step callback, called in regular operation mode, identifies the plugin in scheduling functions
+			terminate --- pointer to termination callback, called once in termination mode, NULL to skip
+			context   --- optional context pointer passed to all of the callbacks
+		return value: 
+			1 if successful
+			0 otherwise (failed to allocate/realocate memory, plugin limit reached)
+		note:
+			scheduling functions (remove_plugin, suspend_plugin, etc.) identify such plugins 
+			by the step callback cast to void(*)(void)
+	*/
+char fsnav_add_plugin_ext(void(*init)(void*), void(*step)(void*), void(*terminate)(void*), void* context)
 {
 	fsnav_plugin* reallocated_pointer;
+	fsnav_plugin* plugin;
 
 	if (fsnav->core.plugin_count + 1 >= UINT_MAX)
 		return 0;
@@ -1129,11 +1460,68 @@ char fsnav_add_plugin(void(*newplugin)(void))
 	else
 		fsnav->core.plugins = reallocated_pointer;
 
-	fsnav->core.plugins[fsnav->core.plugin_count].func  = newplugin;
-	fsnav->core.plugins[fsnav->core.plugin_count].cycle = 1;
-	fsnav->core.plugins[fsnav->core.plugin_count].shift = 0;
-	fsnav->core.plugins[fsnav->core.plugin_count].tick  = 0;
+	plugin = fsnav->core.plugins + fsnav->core.plugin_count;
+	plugin->func      = NULL;
+	plugin->init      = (init      != NULL) ? init      : fsnav_plugin_noop;
+	plugin->step      = (step      != NULL) ? step      : fsnav_plugin_noop;
+	plugin->terminate = (terminate != NULL) ? terminate : fsnav_plugin_noop;
+	plugin->context   = context;
+	plugin->block        = NULL;
+	plugin->block_role   = 0;
+	plugin->samples      = NULL;
+	plugin->sample_size  = 0;
+	plugin->sample_count = 0;
+	plugin->sample_next  = 0;
+	plugin->topics         = 0;
+	plugin->topics_pending = 0;
+	plugin->retired        = 0;
+	plugin->cost         = 0;
+	plugin->cost_count   = 0;
+	plugin->cost_runs    = 0;
+	plugin->cycle     = 1;
+	plugin->shift     = 0;
+	plugin->tick      = 0;
 	fsnav->core.plugin_count++;
+	fsnav->core.revision++;
+	fsnav->core.balance_pending = 1;
+
+	return 1;
+}
+
+	/*
+		add block input/output plugin to the plugin execution list
+		input:
+			init      --- pointer to init callback, or NULL
+			block     --- pointer to block callback: 
+			              input plugins fill up to n samples and return the number of samples filled,
+			              returning 0 when no more samples are available (setting fsnav->mode = -1 to terminate, if needed);
+			              output plugins emit n samples and return the number of samples emitted
+			terminate --- pointer to termination callback, or NULL
+			context   --- context pointer passed to callbacks
+			role      --- FSNAV_BLOCK_INPUT or FSNAV_BLOCK_OUTPUT
+		return value:
+			1 if successful
+			0 otherwise (invalid arguments, failed to allocate/realocate memory, plugin limit reached)
+		note:
+			in regular operation mode the core loads one buffered sample to fsnav->imu (input) 
+			or stores fsnav->imu to the buffer (output) at the plugin position on every step, 
+			calling the block callback when the buffer is empty (input) or full (output);
+			output buffers are also emitted at the end of step_n and before termination;
+			scheduling functions identify such plugins by the block callback cast to void(*)(void)
+	*/
+char fsnav_add_plugin_block(void(*init)(void*), size_t(*block)(void*, fsnav_imu_sample*, size_t), void(*terminate)(void*), void* context, char role)
+{
+	fsnav_plugin* plugin;
+
+	if (block == NULL || (role != FSNAV_BLOCK_INPUT && role != FSNAV_BLOCK_OUTPUT))
+		return 0;
+
+	if (!fsnav_add_plugin_ext(init, NULL, terminate, context))
+		return 0;
+
+	plugin = fsnav->core.plugins + fsnav->core.plugin_count - 1;
+	plugin->block      = block;
+	plugin->block_role = role;
 
 	return 1;
 }
@@ -1300,43 +1688,264 @@ char fsnav_init(char* cfg)
 	*/
 char fsnav_step(void)
 {
-	size_t i;
+	if (fsnav->mode > 0 && fsnav->core.balance)
+		fsnav_balance_step(); // rebalance scheduled plugins, if due
 
-	// loop through plugin execution list
-	for (fsnav->core.current_plugin_id = 0; fsnav->core.current_plugin_id < fsnav->core.plugin_count; fsnav->core.current_plugin_id++) {
-		i = fsnav->core.current_plugin_id;
+	return fsnav_step_from(0);
+}
 
-		if (fsnav->mode <= 0                                                                                    // init/termination mode
-			|| (fsnav->core.plugins[i].cycle > 0 && fsnav->core.plugins[i].tick == fsnav->core.plugins[i].shift)) // or the scheduled tick has come
-			fsnav->core.plugins[i].func();                                                                      // execute the current plugin
+	/*
+		step through the plugin execution list starting from a given entry, used by fsnav_step and by statically compiled pipelines to fall back to dynamic dispatch
+		input:
+			size_t first --- index of the first execution list entry to process
+		return value:
+			1 if successful (either staying in regular operation mode, or a termination is properly detected)
+			0 otherwise
+	*/
+char fsnav_step_from(size_t first)
+{
+	fsnav_plugin* plugin;
 
-		fsnav->core.plugins[i].tick++;                                  // current tick increment
-		if (fsnav->core.plugins[i].tick >= fsnav->core.plugins[i].cycle) // check to stay within the cycle
-			fsnav->core.plugins[i].tick = 0;                            // reset tick
+	// loop through plugin execution list
+	for (fsnav->core.current_plugin_id = first; fsnav->core.current_plugin_id < fsnav->core.plugin_count; fsnav->core.current_plugin_id++) {
+		plugin = fsnav->core.plugins + fsnav->core.current_plugin_id;
+
+		if (fsnav->mode > 0) {                                                // regular operation mode
+			if (FSNAV_PLUGIN_DUE(plugin)) {                                   // if the scheduled tick has come and subscribed topics, if any, were signalled
+				fsnav->core.current_topics = plugin->topics_pending;
+				plugin->topics_pending = 0;
+				if (fsnav->core.balance)
+					fsnav_balance_begin(fsnav->core.current_plugin_id);       // execution time measurement for load balancing
+				if (plugin->func != NULL)                                     // execute the current plugin
+					plugin->func();                                           // single-function plugin
+				else if (plugin->block != NULL)
+					fsnav_step_block_entry(fsnav->core.current_plugin_id);    // block plugin, buffered sample
+				else
+					plugin->step(plugin->context);                            // step callback only
+				if (fsnav->core.balance)
+					fsnav_balance_end(fsnav->core.current_plugin_id);
+			}
+		}
+		else if (plugin->retired)                                             // retired plugins are not called in init/termination mode
+			;
+		else if (plugin->func != NULL)                                        // init/termination mode
+			plugin->func();                                                   // single-function plugin branches on mode by itself
+		else if (fsnav->mode == 0)
+			plugin->init(plugin->context);                                    // init callback
+		else {
+			fsnav_plugin_block_flush(plugin);                                 // emit buffered output samples, if any
+			plugin->terminate(plugin->context);                               // termination callback
+		}
 
-		if (fsnav->core.exit_plugin_id == i)	{     // if termination was initiated by the current plugin on the previous loop
-			fsnav->core.exit_plugin_id = UINT_MAX; // set to default
-			fsnav->core.host_termination = 0;      // set to default
-			fsnav_free();                          // free memory
+		if (fsnav_step_entry_end(fsnav->core.current_plugin_id))
 			break;
-		}
+	}
 
-		if ((fsnav->mode < 0 || fsnav->core.host_termination == 1) && fsnav->core.exit_plugin_id == UINT_MAX) { // if termination was initiated by the current plugin on the current loop
-			if (fsnav->mode > 0)
-				fsnav->mode = -1;               // set mode to -1 for external termination cases
+	return fsnav_step_end();
+}
 
-			if (fsnav->mode != 0)
-				fsnav->core.exit_plugin_id = i; // set the index to use in the next loop
-		}
+	/*
+		map a plugin sequence onto the plugin execution list, used by statically compiled pipelines
+		input:
+			plugins        --- array of pointers to plugin functions, or step/block callbacks cast to void(*)(void) for plugins with separate callbacks
+			size_t n       --- number of plugins in the sequence
+		output:
+			size_t* map    --- array of n execution list indices of the sequence plugins, 
+			                   FSNAV_STEP_STATIC_ABSENT for plugins that were removed from the execution list
+		return value:
+			index of the first execution list entry not covered by the mapped sequence, 
+			the entries from this one on are to be processed by fsnav_step_from
+		note:
+			the execution list head is matched greedily as a subsequence of the sequence, 
+			so that removed and retired plugins leave the rest of the sequence compiled,
+			while entries added elsewhere fall to the dynamically dispatched tail;
+			the result holds as long as core.revision stays the same
+	*/
+size_t fsnav_step_static_map(void(**plugins)(void), const size_t n, size_t* map)
+{
+	size_t i, k;
+
+	for (i = 0, k = 0; k < n; k++)
+		if (i < fsnav->core.plugin_count && fsnav_plugin_match(fsnav->core.plugins + i, plugins[k]))
+			map[k] = i++;
+		else
+			map[k] = FSNAV_STEP_STATIC_ABSENT;
+
+	return i;
+}
+
+	/*
+		finalize an execution list entry after its plugin has been called: advance the tick and track termination
+		input:
+			size_t i --- execution list entry index
+		return value:
+			1 if the operation has terminated and the step is to be ended
+			0 otherwise
+	*/
+char fsnav_step_entry_end(size_t i)
+{
+	fsnav->core.plugins[i].tick++;                                  // current tick increment
+	if (fsnav->core.plugins[i].tick >= fsnav->core.plugins[i].cycle) // check to stay within the cycle
+		fsnav->core.plugins[i].tick = 0;                            // reset tick
+
+	if (fsnav->core.exit_plugin_id == i)	{     // if termination was initiated by the current plugin on the previous loop
+		fsnav->core.exit_plugin_id = UINT_MAX; // set to default
+		fsnav->core.host_termination = 0;      // set to default
+		fsnav_free();                          // free memory
+		return 1;
+	}
+
+	if ((fsnav->mode < 0 || fsnav->core.host_termination == 1) && fsnav->core.exit_plugin_id == UINT_MAX) { // if termination was initiated by the current plugin on the current loop
+		if (fsnav->mode > 0)
+			fsnav->mode = -1;               // set mode to -1 for external termination cases
+
+		if (fsnav->mode != 0)
+			fsnav->core.exit_plugin_id = i; // set the index to use in the next loop
 	}
 
+	return 0;
+}
+
+	/*
+		finalize a step through the plugin execution list
+		return value:
+			1 if successful (either staying in regular operation mode, or a termination is properly detected)
+			0 otherwise
+	*/
+char fsnav_step_end(void)
+{
 	if (fsnav->mode == 0) // if initialization ended
 		fsnav->mode = 1;  // set operation mode to regular operation
 
+	if (fsnav->core.retired_count > 0 && fsnav->mode >= 0 && fsnav->core.exit_plugin_id == UINT_MAX)
+		fsnav_plugin_compact(); // remove retired plugins, unless termination is pending
+
 	// success if either staying in regular operation mode, or a termination properly detected
 	return (fsnav->mode >= 0) || (fsnav->core.exit_plugin_id < UINT_MAX);
 }
 
+	/*
+		load a buffered sample to the bus (input plugins) or store the bus data to the buffer (output plugins) for a block plugin entry
+		input:
+			size_t i --- execution list entry index
+		note:
+			if an input plugin has no more samples, the bus measurements are marked invalid
+	*/
+void fsnav_step_block_entry(size_t i)
+{
+	fsnav_plugin*     entry = fsnav->core.plugins + i;
+	fsnav_imu_sample* sample;
+	size_t            j;
+
+	if (fsnav->imu == NULL)
+		return;
+
+	if (!fsnav_plugin_block_reserve(entry)) { // failed to allocate memory
+		fsnav->mode = -1;
+		return;
+	}
+
+	if (entry->block_role == FSNAV_BLOCK_INPUT) {
+		// refill the buffer
+		if (entry->sample_next >= entry->sample_count) {
+			entry->sample_count = entry->block(entry->context, entry->samples, entry->sample_size);
+			entry->sample_next  = 0;
+			if (entry->sample_count > entry->sample_size)
+				entry->sample_count = entry->sample_size;
+		}
+		// no more samples
+		if (entry->sample_next >= entry->sample_count) {
+			fsnav->imu->w_valid  = 0;
+			fsnav->imu->f_valid  = 0;
+			fsnav->imu->Tw_valid = 0;
+			fsnav->imu->Tf_valid = 0;
+			return;
+		}
+		// load the next sample
+		sample = entry->samples + entry->sample_next;
+		if (sample->t_valid)
+			fsnav->imu->t = sample->t;
+		for (j = 0; j < 3; j++) {
+			fsnav->imu->w [j] = sample->w [j];
+			fsnav->imu->f [j] = sample->f [j];
+			fsnav->imu->Tw[j] = sample->Tw[j];
+			fsnav->imu->Tf[j] = sample->Tf[j];
+		}
+		fsnav->imu->w_valid  = sample->w_valid;
+		fsnav->imu->f_valid  = sample->f_valid;
+		fsnav->imu->Tw_valid = sample->Tw_valid;
+		fsnav->imu->Tf_valid = sample->Tf_valid;
+		entry->sample_next++;
+	}
+	else if (entry->block_role == FSNAV_BLOCK_OUTPUT) {
+		// store the current sample
+		sample = entry->samples + entry->sample_count;
+		sample->t       = fsnav->imu->t;
+		sample->t_valid = 1;
+		for (j = 0; j < 3; j++) {
+			sample->w [j] = fsnav->imu->w [j];
+			sample->f [j] = fsnav->imu->f [j];
+			sample->Tw[j] = fsnav->imu->Tw[j];
+			sample->Tf[j] = fsnav->imu->Tf[j];
+		}
+		sample->w_valid     = fsnav->imu->w_valid;
+		sample->f_valid     = fsnav->imu->f_valid;
+		sample->Tw_valid    = fsnav->imu->Tw_valid;
+		sample->Tf_valid    = fsnav->imu->Tf_valid;
+		sample->sol         = fsnav->imu->sol;
+		sample->sol.metrics = NULL;
+		sample->sol.metrics_count = 0;
+		entry->sample_count++;
+		// emit the buffer when full
+		if (entry->sample_count >= entry->sample_size)
+			fsnav_plugin_block_flush(entry);
+	}
+}
+
+	/*
+		step through the plugin execution list n times, to be called by host application in a main loop for offline processing
+		input:
+			size_t n --- number of steps, also sets the minimum block buffer capacity for block plugins, 0 is treated as 1
+		return value:
+			1 if successful (either staying in regular operation mode, or a termination is properly detected)
+			0 otherwise
+	*/
+char fsnav_step_n(size_t n)
+{
+	return fsnav_step_n_ext(n, fsnav_step);
+}
+
+	/*
+		call a step function n times, used by fsnav_step_n and by statically compiled pipelines
+		input:
+			size_t n --- number of steps, also sets the minimum block buffer capacity for block plugins, 0 is treated as 1
+			step     --- pointer to a step function, e.g. fsnav_step
+		return value:
+			1 if successful (either staying in regular operation mode, or a termination is properly detected)
+			0 otherwise
+		note:
+			block output plugins emit their buffers at the end of the call
+	*/
+char fsnav_step_n_ext(size_t n, char(*step)(void))
+{
+	size_t k;
+
+	if (n == 0)
+		n = 1;
+	if (fsnav->core.block_size < n)
+		fsnav->core.block_size = n;
+
+	for (k = 0; k < n; k++)
+		if (!step())
+			return 0;
+
+	if (fsnav->mode > 0)
+		for (k = 0; k < fsnav->core.plugin_count; k++)
+			fsnav_plugin_block_flush(fsnav->core.plugins + k);
+
+	return 1;
+}
+
 	/*
 		terminate operation
 		return value:
@@ -1374,9 +1983,11 @@ char fsnav_remove_plugin(void(*plugin)(void))
 	fsnav_plugin* reallocated_pointer;
 
 	for (i = 0; i < fsnav->core.plugin_count; i++) { // go through the execution list
-		if (fsnav->core.plugins[i].func != plugin)   // if not the requested plugin, do nothing
+		if (!fsnav_plugin_match(fsnav->core.plugins + i, plugin)) // if not the requested plugin, do nothing
 			continue;
 		// otherwise, remove the current plugin from the execution list
+		fsnav_plugin_block_flush(fsnav->core.plugins + i);
+		fsnav_free_null((void**)(&(fsnav->core.plugins[i].samples)));
 		for (j = i+1; j < fsnav->core.plugin_count; j++) // copy all succeeding plugins one position lower
 			fsnav->core.plugins[j-1] = fsnav->core.plugins[j];
 		// reset the last one
@@ -1386,6 +1997,8 @@ char fsnav_remove_plugin(void(*plugin)(void))
 		fsnav->core.plugins[j].shift = 0;
 		fsnav->core.plugins[j].tick  = 0;
 		fsnav->core.plugin_count--;
+		fsnav->core.revision++;
+		fsnav->core.balance_pending = 1;
 		if (flag < 0xff)
 			flag++;
 	}
@@ -1397,6 +2010,8 @@ char fsnav_remove_plugin(void(*plugin)(void))
 		return 0;
 	}
 	fsnav->core.plugins = reallocated_pointer;
+	if (flag)
+		fsnav_accum_drop_orphans();
 
 	return flag;
 }
@@ -1416,11 +2031,14 @@ char fsnav_replace_plugin(void(*oldplugin)(void), void(*newplugin)(void))
 	char flag;
 
 	for (i = 0, flag = 0; i < fsnav->core.plugin_count; i++) {
-		if (fsnav->core.plugins[i].func != oldplugin)
+		if (!fsnav_plugin_match(fsnav->core.plugins + i, oldplugin))
 			continue;
-		fsnav->core.plugins[i].func = newplugin;
+		fsnav->core.plugins[i].func = newplugin; // the entry turns into a single-function plugin
+		fsnav->core.revision++;
 		flag = 1;
 	}
+	if (flag)
+		fsnav_accum_drop_orphans();
 
 	return flag;
 }
@@ -1438,11 +2056,36 @@ char fsnav_replace_plugin(void(*oldplugin)(void), void(*newplugin)(void))
 			0 otherwise (failed to allocate/realocate memory)
 	*/
 char fsnav_schedule_plugin(void(*newplugin)(void), int cycle, int shift)
+{
+	if (!fsnav_schedule_plugin_ext(NULL, NULL, NULL, NULL, cycle, shift))
+		return 0;
+
+	fsnav->core.plugins[fsnav->core.plugin_count-1].func = newplugin;
+
+	return 1;
+}
+
+	/*
+		add scheduled plugin with separate init, step and terminate callbacks to the plugin execution list
+		input:
+			init      --- pointer to init callback, NULL to skip
+			step      --- pointer to step callback, identifies the plugin in scheduling functions
+			terminate --- pointer to termination callback, NULL to skip
+			context   --- optional context pointer passed to all of the callbacks
+			cycle     --- repeating cycle (in ticks of main cycle),
+			              negative for suspended plugin,
+			              zero for the plugin to be turned off (for further rescheduling)
+			shift     --- shift from the beginning of the cycle, automatically shrunk to [0..cycle-1]
+		return value:
+			1 if successful
+			0 otherwise (failed to allocate/realocate memory)
+	*/
+char fsnav_schedule_plugin_ext(void(*init)(void*), void(*step)(void*), void(*terminate)(void*), void* context, int cycle, int shift)
 {
 	int abs_cycle;
 
 	// add to the execution list
-	if (!fsnav_add_plugin(newplugin))
+	if (!fsnav_add_plugin_ext(init, step, terminate, context))
 		return 0;
 	// shrink shift to [0..cycle-1]
 	abs_cycle = abs(cycle);
@@ -1491,10 +2134,11 @@ char fsnav_reschedule_plugin(void(*plugin)(void), int cycle, int shift)
 		shift = 0;
 	// go through execution list and set scheduling parameters, if found the plugin
 	for (i = 0; i < fsnav->core.plugin_count; i++) {
-		if (fsnav->core.plugins[i].func == plugin) {
+		if (fsnav_plugin_match(fsnav->core.plugins + i, plugin) && !fsnav->core.plugins[i].retired) {
 			fsnav->core.plugins[i].cycle = cycle;
 			fsnav->core.plugins[i].shift = shift;
 			fsnav->core.plugins[i].tick  = 0;
+			fsnav->core.balance_pending = 1;
 			flag = 1;
 		}
 	}
@@ -1516,10 +2160,12 @@ char fsnav_suspend_plugin(void(*plugin)(void))
 	char flag = 0;
 	// go through execution list and set cycle to negative, if found the plugin
 	for (i = 0; i < fsnav->core.plugin_count; i++) {
-		if (fsnav->core.plugins[i].func == plugin) {
+		if (fsnav_plugin_match(fsnav->core.plugins + i, plugin)) {
 			cycle = fsnav->core.plugins[i].cycle;
-			if (cycle > 0)
+			if (cycle > 0) {
 				fsnav->core.plugins[i].cycle = -cycle;
+				fsnav->core.balance_pending = 1;
+			}
 			flag = 1;
 		}
 	}
@@ -1541,10 +2187,83 @@ char fsnav_resume_plugin(void(*plugin)(void))
 	char flag = 0;
 	// go through execution list and set cycle to positive, if found the plugin
 	for (i = 0; i < fsnav->core.plugin_count; i++) {
-		if (fsnav->core.plugins[i].func == plugin) {
+		if (fsnav_plugin_match(fsnav->core.plugins + i, plugin)) {
 			cycle = fsnav->core.plugins[i].cycle;
-			if (cycle < 0)
+			if (cycle < 0) {
 				fsnav->core.plugins[i].cycle = -cycle;
+				fsnav->core.balance_pending = 1;
+			}
+			flag = 1;
+		}
+	}
+	return flag;
+}
+
+	/*
+		subscribe all instances of the plugin to bus topics, so that they are called only after the topics are signalled
+		input:
+			plugin --- pointer to a plugin function
+			topics --- bit mask of FSNAV_TOPIC_* values, 0 to unsubscribe (to be called on every scheduled tick)
+		return value:
+			1 if successful
+			0 otherwise (plugin not found)
+		note:
+			a subscribed plugin is called on its scheduled tick if any of its topics was signalled since its previous call,
+			the topics signalled are available to the plugin in fsnav->core.current_topics;
+			subscription only applies to regular operation mode, init and termination callbacks are called as usual
+	*/
+char fsnav_subscribe_plugin(void(*plugin)(void), unsigned int topics)
+{
+	size_t i;
+	char flag = 0;
+
+	for (i = 0; i < fsnav->core.plugin_count; i++) {
+		if (fsnav_plugin_match(fsnav->core.plugins + i, plugin)) {
+			fsnav->core.plugins[i].topics         = topics;
+			fsnav->core.plugins[i].topics_pending = 0;
+			flag = 1;
+		}
+	}
+	return flag;
+}
+
+	/*
+		signal bus topics to subscribed plugins, to be called by producer plugins after updating the bus data
+		input:
+			topics --- bit mask of FSNAV_TOPIC_* values
+	*/
+void fsnav_signal(unsigned int topics)
+{
+	size_t i;
+
+	for (i = 0; i < fsnav->core.plugin_count; i++)
+		fsnav->core.plugins[i].topics_pending |= fsnav->core.plugins[i].topics & topics;
+}
+
+	/*
+		retire all instances of the plugin, e.g. by a plugin that has completed its job such as initial alignment
+		input:
+			plugin --- pointer to a plugin function
+		return value:
+			1 if successful
+			0 otherwise (plugin not found)
+		note:
+			retired plugins are not called anymore, including termination mode, 
+			and are removed from the plugin execution list at the end of the current step;
+			unlike suspended plugins, retired ones cannot be resumed
+	*/
+char fsnav_retire_plugin(void(*plugin)(void))
+{
+	size_t i;
+	char flag = 0;
+
+	for (i = 0; i < fsnav->core.plugin_count; i++) {
+		if (fsnav_plugin_match(fsnav->core.plugins + i, plugin)) {
+			if (!fsnav->core.plugins[i].retired) {
+				fsnav->core.plugins[i].retired = 1;
+				fsnav->core.plugins[i].cycle   = 0;
+				fsnav->core.retired_count++;
+			}
 			flag = 1;
 		}
 	}
@@ -1555,6 +2274,176 @@ char fsnav_resume_plugin(void(*plugin)(void))
 
 
 
+// increment accumulators between plugin rates
+	/*
+		attach an increment accumulator to a consumer plugin, to be called by the consumer in init mode
+		input:
+			plugin  --- pointer to the consumer plugin function (step callback for plugins with separate callbacks)
+			x_count --- number of application-specific quantities to integrate, 0 for angular and velocity increments only
+		return value:
+			pointer to the accumulator, reset and valid until the consumer is removed, replaced or retired, or the bus memory is freed at termination
+			NULL if memory allocation failed
+		note:
+			each consumer gets its own accumulator, a repeated call returns the same one, reset and extended to x_count if needed;
+			accumulators are integrated by producers, e.g. fsnav_accumulate_imu plugin, at every step,
+			and are read and reset by the consumer on its own tick, so that plugins scheduled with cycle > 1 
+			get increments over all the samples in between
+	*/
+fsnav_accum* fsnav_attach_accum(void(*plugin)(void), size_t x_count)
+{
+	fsnav_accum  *acc = NULL;
+	fsnav_accum **reallocated_accums;
+	double       *reallocated_x;
+	size_t i;
+
+	// look for an accumulator attached to the plugin
+	for (i = 0; i < fsnav->core.accum_count; i++)
+		if (fsnav->core.accums[i]->owner == plugin) {
+			acc = fsnav->core.accums[i];
+			break;
+		}
+	// or add a new one
+	if (acc == NULL) {
+		reallocated_accums = (fsnav_accum**)realloc((void*)(fsnav->core.accums), (fsnav->core.accum_count + 1)*sizeof(fsnav_accum*));
+		if (reallocated_accums == NULL)
+			return NULL;
+		fsnav->core.accums = reallocated_accums;
+		acc = (fsnav_accum*)calloc(1, sizeof(fsnav_accum));
+		if (acc == NULL)
+			return NULL;
+		acc->owner = plugin;
+		fsnav->core.accums[fsnav->core.accum_count++] = acc;
+	}
+	// application-specific quantities
+	if (x_count > acc->x_count) {
+		reallocated_x = (double*)realloc((void*)(acc->x), x_count*sizeof(double));
+		if (reallocated_x == NULL)
+			return NULL;
+		acc->x       = reallocated_x;
+		acc->x_count = x_count;
+	}
+	for (i = 0; i < 3; i++)
+		acc->da[i] = 0;
+	fsnav_reset_accum(acc);
+	return acc;
+}
+
+	/*
+		integrate a sample into all increment accumulators, to be called by producer plugins at every step
+		input:
+			double  dt      --- time step, seconds
+			double* w       --- pointer to 3 x 1 angular rate, NULL if not valid
+			double* f       --- pointer to 3 x 1 specific force, NULL if not valid
+			double* x       --- pointer to application-specific quantities, NULL if none
+			size_t  x_count --- number of application-specific quantities, extra ones beyond an accumulator x_count are ignored
+		note:
+			da = w*dt, dv = f*dt,
+			c += (a + da_prev/6) x da/2 (coning), s += (a x dv + v x da)/2 (sculling), a += da, v += dv, 
+			where da_prev is the previous angular increment, possibly before the last reset
+	*/
+void fsnav_accumulate(double dt, double* w, double* f, double* x, size_t x_count)
+{
+	double da[3], dv[3], b[3], e[3];
+	fsnav_accum *acc;
+	size_t i, j;
+
+	for (i = 0; i < 3; i++) {
+		da[i] = (w != NULL) ? w[i]*dt : 0;
+		dv[i] = (f != NULL) ? f[i]*dt : 0;
+	}
+	for (j = 0; j < fsnav->core.accum_count; j++) {
+		acc = fsnav->core.accums[j];
+		// coning, c += (a + da_prev/6) x da/2
+		for (i = 0; i < 3; i++)
+			b[i] = acc->a[i] + acc->da[i]/6;
+		fsnav_linal_cross3x1(e, b, da);
+		for (i = 0; i < 3; i++) {
+			acc->c [i] += e[i]/2;
+			acc->da[i]  = da[i];
+		}
+		// sculling, s += (a x dv + v x da)/2
+		fsnav_linal_cross3x1(e, acc->a, dv);
+		for (i = 0; i < 3; i++)
+			acc->s[i] += e[i]/2;
+		fsnav_linal_cross3x1(e, acc->v, da);
+		for (i = 0; i < 3; i++) {
+			acc->s[i] += e[i]/2;
+			acc->a[i] += da[i];
+			acc->v[i] += dv[i];
+		}
+		// application-specific quantities
+		for (i = 0; i < acc->x_count && i < x_count && x != NULL; i++)
+			acc->x[i] += x[i]*dt;
+		// time, validity
+		acc->T += dt;
+		acc->n++;
+		if (w == NULL)
+			acc->w_valid = 0;
+		if (f == NULL)
+			acc->f_valid = 0;
+	}
+}
+
+	/*
+		reset an increment accumulator, to be called by the consumer after reading
+		input:
+			fsnav_accum* acc --- pointer to the accumulator
+		note:
+			the last angular increment is kept for coning compensation of the next interval
+	*/
+void fsnav_reset_accum(fsnav_accum* acc)
+{
+	size_t i;
+
+	acc->t0 = (fsnav->imu != NULL) ? fsnav->imu->t : fsnav->t;
+	acc->T  = 0;
+	acc->n  = 0;
+	for (i = 0; i < 3; i++)
+		acc->a[i] = acc->v[i] = acc->c[i] = acc->s[i] = 0;
+	for (i = 0; i < acc->x_count; i++)
+		acc->x[i] = 0;
+	acc->w_valid = 1;
+	acc->f_valid = 1;
+}
+
+	/*
+		fsnav_accumulate_imu - fsnav core plugin
+		integrates fsnav->imu->w and fsnav->imu->f into all increment accumulators at every step
+		uses:
+			fsnav->imu->t
+			fsnav->imu->w
+			fsnav->imu->w_valid
+			fsnav->imu->f
+			fsnav->imu->f_valid
+		changes:
+			increment accumulators attached by consumer plugins (fsnav->core.accums)
+		note:
+			to be placed after sensor preprocessing plugins (calibration, axes switching), and before the consumers
+	*/
+void fsnav_accumulate_imu(void)
+{
+	static double t0 = -1; // previous time
+
+	if (fsnav->imu == NULL)
+		return;
+
+	if (fsnav->mode == 0)     // init
+		t0 = -1;
+	else if (fsnav->mode < 0) // termination
+		return;
+	else {                    // main cycle
+		if (t0 < 0) { // first touch
+			t0 = fsnav->imu->t;
+			return;
+		}
+		fsnav_accumulate(fsnav->imu->t - t0, fsnav->imu->w_valid ? fsnav->imu->w : NULL, fsnav->imu->f_valid ? fsnav->imu->f : NULL, NULL, 0);
+		t0 = fsnav->imu->t;
+	}
+}
+
+
+
+
 // basic parsing	
 	/*
 		locate a token (and delimiter, when given) within a configuration string
@@ -1806,6 +2695,104 @@ void fsnav_linal_cross3x1(double* res, double* u, double* v)
 	res[2] = u[0]*v[1] - u[1]*v[0];
 }
 
+		/*
+			accumulate 4 x 4 block of products of 4 rows of one matrix and 4 rows (or columns) of another
+			input:
+				double*      t      --- pointer to 4 x 4 block, used as initial value when init = 0
+				double**     a      --- pointers to the first elements of 4 rows of the first matrix
+				const size_t ap     --- step between successive elements in the rows of the first matrix
+				double**     b      --- pointers to the first elements of 4 rows (columns) of the second matrix
+				const size_t bp     --- step between successive elements in the rows (columns) of the second matrix
+				const size_t len    --- number of elements, len >= 1 when init = 1
+				const char   init   --- 1 to start with the first product, 0 to continue the sums in t
+			output:
+				double* t --- pointer to 4 x 4 block, t[4*r+c] = t[4*r+c] + sum(a[r][p*ap]*b[c][p*bp])
+			note:
+				register tile of the blocked matrix products, the sums are accumulated in the same order as in element-wise loops
+		*/
+void fsnav_linal_tile4x4(double* t, double** a, const size_t ap, double** b, const size_t bp, const size_t len, const char init)
+{
+	double 
+		*a0 = a[0], *a1 = a[1], *a2 = a[2], *a3 = a[3], 
+		*b0 = b[0], *b1 = b[1], *b2 = b[2], *b3 = b[3],
+		x0, x1, x2, x3, y0, y1, y2, y3,
+		c00, c01, c02, c03, c10, c11, c12, c13, c20, c21, c22, c23, c30, c31, c32, c33;
+	size_t p, ka, kb;
+
+	if (init) {
+		c00 = a0[0]*b0[0], c01 = a0[0]*b1[0], c02 = a0[0]*b2[0], c03 = a0[0]*b3[0];
+		c10 = a1[0]*b0[0], c11 = a1[0]*b1[0], c12 = a1[0]*b2[0], c13 = a1[0]*b3[0];
+		c20 = a2[0]*b0[0], c21 = a2[0]*b1[0], c22 = a2[0]*b2[0], c23 = a2[0]*b3[0];
+		c30 = a3[0]*b0[0], c31 = a3[0]*b1[0], c32 = a3[0]*b2[0], c33 = a3[0]*b3[0];
+		p = 1, ka = ap, kb = bp;
+	}
+	else {
+		c00 = t[ 0], c01 = t[ 1], c02 = t[ 2], c03 = t[ 3];
+		c10 = t[ 4], c11 = t[ 5], c12 = t[ 6], c13 = t[ 7];
+		c20 = t[ 8], c21 = t[ 9], c22 = t[10], c23 = t[11];
+		c30 = t[12], c31 = t[13], c32 = t[14], c33 = t[15];
+		p = 0, ka = 0, kb = 0;
+	}
+	for (; p < len; p++, ka += ap, kb += bp) {
+		x0 = a0[ka], x1 = a1[ka], x2 = a2[ka], x3 = a3[ka];
+		y0 = b0[kb], y1 = b1[kb], y2 = b2[kb], y3 = b3[kb];
+		c00 += x0*y0, c01 += x0*y1, c02 += x0*y2, c03 += x0*y3;
+		c10 += x1*y0, c11 += x1*y1, c12 += x1*y2, c13 += x1*y3;
+		c20 += x2*y0, c21 += x2*y1, c22 += x2*y2, c23 += x2*y3;
+		c30 += x3*y0, c31 += x3*y1, c32 += x3*y2, c33 += x3*y3;
+	}
+	t[ 0] = c00, t[ 1] = c01, t[ 2] = c02, t[ 3] = c03;
+	t[ 4] = c10, t[ 5] = c11, t[ 6] = c12, t[ 7] = c13;
+	t[ 8] = c20, t[ 9] = c21, t[10] = c22, t[11] = c23;
+	t[12] = c30, t[13] = c31, t[14] = c32, t[15] = c33;
+}
+
+		/*
+			multiply matrices in 4 x 4 register tiles, for n >= FSNAV_LINAL_BLOCK_MIN
+			input:
+				double*      a      --- pointer to the first matrix
+				const size_t ar, ap --- steps between rows of res and between successive products in the first matrix
+				double*      b      --- pointer to the second matrix
+				const size_t bc, bp --- steps between columns of res and between successive products in the second matrix
+				const size_t n, m   --- dimensions of res
+				const size_t len    --- number of products in each element
+			output:
+				double* res --- pointer to a n x m matrix,
+				                res[i*m+j] = sum(a[i*ar + p*ap]*b[j*bc + p*bp]), p = 0..len-1
+			note:
+				common part of fsnav_linal_mmul, fsnav_linal_mmul1T and fsnav_linal_mmul2T, 
+				the rows and columns left over from the tiles are calculated element-wise
+		*/
+void fsnav_linal_mmul_blocked(double* res, double* a, const size_t ar, const size_t ap, double* b, const size_t bc, const size_t bp, const size_t n, const size_t m, const size_t len)
+{
+	size_t i, j, r, c, p, ka, kb, n4 = n - n%4, m4 = m - m%4;
+	double t[16], *ra[4], *rb[4];
+
+	for (i = 0; i < n; i += 4) {
+		for (j = 0; j < m; j += 4) {
+			if (i < n4 && j < m4) {
+				for (r = 0; r < 4; r++) {
+					ra[r] = a + (i+r)*ar;
+					rb[r] = b + (j+r)*bc;
+				}
+				fsnav_linal_tile4x4(t, ra, ap, rb, bp, len, 1);
+				for (r = 0; r < 4; r++)
+					for (c = 0; c < 4; c++)
+						res[(i+r)*m + j+c] = t[4*r+c];
+			}
+			else {
+				for (r = i; r < n && r < i+4; r++)
+					for (c = j; c < m && c < j+4; c++) {
+						ka = r*ar, kb = c*bc;
+						res[r*m+c] = a[ka]*b[kb];
+						for (ka += ap, kb += bp, p = 1; p < len; ka += ap, kb += bp, p++)
+							res[r*m+c] += a[ka]*b[kb];
+					}
+			}
+		}
+	}
+}
+
 		/*
 			multiply two matrices 
 			input:
@@ -1820,6 +2807,10 @@ void fsnav_linal_mmul(double* res, double* a, double* b, const size_t n, const s
 {
 	size_t i, j, k, k0, ka, kb, p;
 
+	if (n >= FSNAV_LINAL_BLOCK_MIN && m >= FSNAV_LINAL_BLOCK_MIN && n1 > 0) {
+		fsnav_linal_mmul_blocked(res, a, n1, 1, b, 1, m, n, m, n1);
+		return;
+	}
 	for (i = 0, k = 0, k0 = 0; i < n; i++, k0 += n1) {
 		for (j = 0; j < m; j++, k++) {
 			ka = k0;
@@ -1845,6 +2836,10 @@ void fsnav_linal_mmul1T(double* res, double* a, double* b, const size_t n, const
 {
 	size_t i, j, k, ka, kb, p;
 
+	if (m >= FSNAV_LINAL_BLOCK_MIN && n1 >= FSNAV_LINAL_BLOCK_MIN && n > 0) {
+		fsnav_linal_mmul_blocked(res, a, 1, m, b, 1, n1, m, n1, n);
+		return;
+	}
 	for (i = 0, k = 0; i < m; i++) {
 		for (j = 0; j < n1; j++, k++) {
 			ka = i;
@@ -1870,6 +2865,10 @@ void fsnav_linal_mmul2T(double* res, double* a, double* b, const size_t n, const
 {
 	size_t i, j, k, k0, ka, kb, p;
 
+	if (n >= FSNAV_LINAL_BLOCK_MIN && n1 >= FSNAV_LINAL_BLOCK_MIN && m > 0) {
+		fsnav_linal_mmul_blocked(res, a, m, 1, b, m, 1, n, n1, m);
+		return;
+	}
 	for (i = 0, k = 0, k0 = 0; i < n; i++, k0 += m) {
 		for (j = 0; j < n1; j++, k++) {
 			ka = k0;
@@ -1881,6 +2880,114 @@ void fsnav_linal_mmul2T(double* res, double* a, double* b, const size_t n, const
 	}
 }
 
+		/*
+			multiply 3x3 matrix by 3x1 vector
+			input:
+				double* a --- pointer to a 3x3 matrix
+				double* b --- pointer to a 3x1 vector
+			output:
+				double* res --- pointer to a 3x1 vector,
+				                res = a*b
+			note:
+				same as fsnav_linal_mmul(res, a, b, 3, 3, 1), unrolled,
+				overwriting input (double* res = double* b) is allowed
+		*/
+void fsnav_linal_mmul3x1(double* res, double* a, double* b)
+{
+	double b0 = b[0], b1 = b[1], b2 = b[2];
+
+	res[0] = a[0]*b0 + a[1]*b1 + a[2]*b2;
+	res[1] = a[3]*b0 + a[4]*b1 + a[5]*b2;
+	res[2] = a[6]*b0 + a[7]*b1 + a[8]*b2;
+}
+
+		/*
+			multiply transposed 3x3 matrix by 3x1 vector
+			input:
+				double* a --- pointer to a 3x3 matrix
+				double* b --- pointer to a 3x1 vector
+			output:
+				double* res --- pointer to a 3x1 vector,
+				                res = a^T*b
+			note:
+				same as fsnav_linal_mmul1T(res, a, b, 3, 3, 1), unrolled,
+				overwriting input (double* res = double* b) is allowed
+		*/
+void fsnav_linal_mmul1T3x1(double* res, double* a, double* b)
+{
+	double b0 = b[0], b1 = b[1], b2 = b[2];
+
+	res[0] = a[0]*b0 + a[3]*b1 + a[6]*b2;
+	res[1] = a[1]*b0 + a[4]*b1 + a[7]*b2;
+	res[2] = a[2]*b0 + a[5]*b1 + a[8]*b2;
+}
+
+		/*
+			multiply two 3x3 matrices
+			input:
+				double* a --- pointer to the first 3x3 matrix
+				double* b --- pointer to the second 3x3 matrix
+			output:
+				double* res --- pointer to a 3x3 matrix,
+				                res = a*b
+			note:
+				same as fsnav_linal_mmul(res, a, b, 3, 3, 3), unrolled
+		*/
+void fsnav_linal_mmul3x3(double* res, double* a, double* b)
+{
+	size_t i;
+
+	for (i = 0; i < 9; i += 3) {
+		res[i  ] = a[i]*b[0] + a[i+1]*b[3] + a[i+2]*b[6];
+		res[i+1] = a[i]*b[1] + a[i+1]*b[4] + a[i+2]*b[7];
+		res[i+2] = a[i]*b[2] + a[i+1]*b[5] + a[i+2]*b[8];
+	}
+}
+
+		/*
+			multiply two 3x3 matrices (first matrix is transposed)
+			input:
+				double* a --- pointer to the first 3x3 matrix
+				double* b --- pointer to the second 3x3 matrix
+			output:
+				double* res --- pointer to a 3x3 matrix,
+				                res = a^T*b
+			note:
+				same as fsnav_linal_mmul1T(res, a, b, 3, 3, 3), unrolled
+		*/
+void fsnav_linal_mmul1T3x3(double* res, double* a, double* b)
+{
+	size_t i;
+
+	for (i = 0; i < 3; i++) {
+		res[3*i  ] = a[i]*b[0] + a[i+3]*b[3] + a[i+6]*b[6];
+		res[3*i+1] = a[i]*b[1] + a[i+3]*b[4] + a[i+6]*b[7];
+		res[3*i+2] = a[i]*b[2] + a[i+3]*b[5] + a[i+6]*b[8];
+	}
+}
+
+		/*
+			multiply two 3x3 matrices (second matrix is transposed)
+			input:
+				double* a --- pointer to the first 3x3 matrix
+				double* b --- pointer to the second 3x3 matrix
+			output:
+				double* res --- pointer to a 3x3 matrix,
+				                res = a*b^T
+			note:
+				same as fsnav_linal_mmul2T(res, a, b, 3, 3, 3), unrolled
+		*/
+void fsnav_linal_mmul2T3x3(double* res, double* a, double* b)
+{
+	size_t i;
+
+	for (i = 0; i < 9; i += 3) {
+		res[i  ] = a[i]*b[0] + a[i+1]*b[1] + a[i+2]*b[2];
+		res[i+1] = a[i]*b[3] + a[i+1]*b[4] + a[i+2]*b[5];
+		res[i+2] = a[i]*b[6] + a[i+1]*b[7] + a[i+2]*b[8];
+	}
+}
+
 		/*
 			multiply 4x1 quaternions
 			input:
@@ -1897,6 +3004,90 @@ void fsnav_linal_qmul(double* res, double* q, double* r)
 	res[2] = q[0]*r[2] + q[2]*r[0] + q[3]*r[1] - q[1]*r[3];
 	res[3] = q[0]*r[3] + q[3]*r[0] + q[1]*r[2] - q[2]*r[1];
 }
+
+		/*
+			multiply 4x1 quaternions (first is conjugated)
+			input:
+				double* q --- pointer to the first 4x1 quaternion
+				double* r --- pointer to the second 4x1 quaternion
+			output:
+				double* res --- pointer to a 4x1 quaternion, 
+				                res = q~ x r, with res0, q0, r0 being scalar parts, q~ = [q0 -q1 -q2 -q3]
+		*/
+void fsnav_linal_qmul1C(double* res, double* q, double* r)
+{
+	res[0] = q[0]*r[0] + q[1]*r[1] + q[2]*r[2] + q[3]*r[3];
+	res[1] = q[0]*r[1] - q[1]*r[0] - q[2]*r[3] + q[3]*r[2];
+	res[2] = q[0]*r[2] - q[2]*r[0] - q[3]*r[1] + q[1]*r[3];
+	res[3] = q[0]*r[3] - q[3]*r[0] - q[1]*r[2] + q[2]*r[1];
+}
+
+		/*
+			multiply 4x1 quaternions (second is conjugated)
+			input:
+				double* q --- pointer to the first 4x1 quaternion
+				double* r --- pointer to the second 4x1 quaternion
+			output:
+				double* res --- pointer to a 4x1 quaternion, 
+				                res = q x r~, with res0, q0, r0 being scalar parts, r~ = [r0 -r1 -r2 -r3]
+		*/
+void fsnav_linal_qmul2C(double* res, double* q, double* r)
+{
+	res[0] =  q[0]*r[0] + q[1]*r[1] + q[2]*r[2] + q[3]*r[3];
+	res[1] = -q[0]*r[1] + q[1]*r[0] - q[2]*r[3] + q[3]*r[2];
+	res[2] = -q[0]*r[2] + q[2]*r[0] - q[3]*r[1] + q[1]*r[3];
+	res[3] = -q[0]*r[3] + q[3]*r[0] - q[1]*r[2] + q[2]*r[1];
+}
+
+		/*
+			multiply arrays of 4x1 quaternions
+			input:
+				double*      q --- pointer to n first 4x1 quaternions lined up one after another
+				double*      r --- pointer to n second 4x1 quaternions lined up one after another
+				const size_t n --- number of quaternions
+			output:
+				double* res --- pointer to n 4x1 quaternions lined up one after another,
+				                res_k = q_k x r_k, must not overlap q or r
+			note:
+				iterations are independent, so that the loop is vectorized across quaternions by the compiler
+		*/
+void fsnav_linal_qmul_batch(double* res, double* q, double* r, const size_t n)
+{
+	size_t k;
+
+	for (k = 0; k < 4*n; k += 4) {
+		res[k  ] = q[k]*r[k  ] - q[k+1]*r[k+1] - q[k+2]*r[k+2] - q[k+3]*r[k+3];
+		res[k+1] = q[k]*r[k+1] + q[k+1]*r[k  ] + q[k+2]*r[k+3] - q[k+3]*r[k+2];
+		res[k+2] = q[k]*r[k+2] + q[k+2]*r[k  ] + q[k+3]*r[k+1] - q[k+1]*r[k+3];
+		res[k+3] = q[k]*r[k+3] + q[k+3]*r[k  ] + q[k+1]*r[k+2] - q[k+2]*r[k+1];
+	}
+}
+
+		/*
+			normalize 4x1 quaternion
+			input:
+				double* q --- pointer to a 4x1 quaternion
+			output:
+				double* q --- pointer to the normalized quaternion, |q| = 1, unchanged if zero or not finite
+			note:
+				when |q|^2 is within 2^-8 of 1, as it is after rounding errors of successive products,
+				q is multiplied by (3 - |q|^2)/2, the first Newton step for 1/sqrt(|q|^2), with residual error of 3/8*(|q|^2 - 1)^2,
+				otherwise by 1/sqrt(|q|^2)
+		*/
+void fsnav_linal_qnormalize(double* q)
+{
+	const double eps = 1.0/0x0100; // 2^-8
+	double n2, k;
+
+	n2 = q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3];
+	if (fabs(n2 - 1) < eps)
+		k = (3 - n2)/2;
+	else if (n2 > 0 && n2 <= DBL_MAX)
+		k = 1/sqrt(n2);
+	else
+		return;
+	q[0] *= k, q[1] *= k, q[2] *= k, q[3] *= k;
+}
 	
 	// space rotation representation
 		/*
@@ -2001,6 +3192,31 @@ void fsnav_linal_rpy2mat(double* R, double* rpy)
 	R[6] =  sr*sp*sy + cr*cy; R[7] =  sr*sp*cy - cr*sy; R[8] = -sr*cp;
 }
 
+		// fsnav_linal_mat2rpy body, shared by the reference routine and the fast one
+#define FSNAV_LINAL_MAT2RPY_BODY(atan2_) {                                                              \
+	const double pi2 = 6.283185307179586476925286766559005768; /* pi*2, IEEE-754 quadruple precision */ \
+	double dp, dm;                                                                                      \
+                                                                                                        \
+	rpy[1] = atan2_(R[2], sqrt(R[5]*R[5] + R[8]*R[8])); /* pitch angle */                               \
+                                                                                                        \
+	if (fabs(R[2]) < 0.5) {          /* pitch magnitude below 30 deg */                                 \
+		rpy[0] = -atan2_(R[8], R[5]); /* roll angle */                                                  \
+		rpy[2] =  atan2_(R[0], R[1]); /* yaw  angle */                                                  \
+	}                                                                                                   \
+	else {                           /* pitch magnitude over 30 deg */                                  \
+		dp =  atan2_(R[3]-R[7], R[6]+R[4]);                                                             \
+		dm = -atan2_(R[3]+R[7], R[6]-R[4]);                                                             \
+                                                                                                        \
+		if (R[0] <= 0 && -R[8] <= 0 && dp > 0)      dp -= pi2;                                          \
+		else if (R[0] >= 0 && -R[8] >= 0 && dp < 0) dp += pi2;                                          \
+		else if (R[0] <= 0 && -R[8] >= 0 && dm > 0) dm -= pi2;                                          \
+		else if (R[0] >= 0 && -R[8] <= 0 && dm < 0) dm += pi2;                                          \
+                                                                                                        \
+		rpy[0] = (dp - dm)/2; /* roll angle */                                                          \
+		rpy[2] = (dp + dm)/2; /* yaw  angle */                                                          \
+	}                                                                                                   \
+}
+
 		/*
 			calculate roll, pitch and yaw corresponding to 3x3 transition matrix R from E-N-U
 			input:
@@ -2009,29 +3225,7 @@ void fsnav_linal_rpy2mat(double* R, double* rpy)
 				double* rpy --- pointer to a roll, pitch and yaw (radians, airborne frame: X longitudinal, Z right-wing)
 		*/
 void fsnav_linal_mat2rpy(double* rpy, double* R)
-{
-	const double pi2 = 6.283185307179586476925286766559005768; // pi*2, IEEE-754 quadruple precision
-	double dp, dm;
-
-	rpy[1] = atan2(R[2], sqrt(R[5]*R[5] + R[8]*R[8])); // pitch angle
-
-	if (fabs(R[2]) < 0.5) {          // pitch magnitude below 30 deg
-		rpy[0] = -atan2(R[8], R[5]); // roll angle
-		rpy[2] =  atan2(R[0], R[1]); // yaw  angle
-	}
-	else {                           // pitch magnitude over 30 deg
-		dp =  atan2(R[3]-R[7], R[6]+R[4]);
-		dm = -atan2(R[3]+R[7], R[6]-R[4]);
-
-		if (R[0] <= 0 && -R[8] <= 0 && dp > 0)      dp -= pi2;
-		else if (R[0] >= 0 && -R[8] >= 0 && dp < 0) dp += pi2;
-		else if (R[0] <= 0 && -R[8] >= 0 && dm > 0) dm -= pi2;
-		else if (R[0] >= 0 && -R[8] <= 0 && dm < 0) dm += pi2;
-
-		rpy[0] = (dp - dm)/2; // roll angle
-		rpy[2] = (dp + dm)/2; // yaw  angle
-	}
-}
+FSNAV_LINAL_MAT2RPY_BODY(atan2)
 
 		/*
 			calculate 3x3 rotation matrix R for 3x1 Euler vector e via Rodrigues' formula
@@ -2075,23 +3269,262 @@ void fsnav_linal_eul2mat(double* R, double* e)
 	R[6] =  e[1]*s + e[2]*e[0]*c; R[7] = -e[0]*s + e[1]*e[2]*c; R[8] =  1 - (e1 + e2)*c;
 }
 
-	// routines for n x n upper-triangular matrices lined up in one-dimensional array
 		/*
-			convert index for upper-triangular matrix lined up in one-dimensional array: (i,j) -> k
+			calculate quaternion q for 3x1 Euler vector e
 			input:
-				const size_t i, j --- row and column indexes in upper-triangular matrix,
-				                      i,j = 0,1,...,n-1
-				const size_t n    --- upper-triangular matrix dimension
+				double* e --- pointer to a 3x1 Euler vector
 			output:
-				size_t* k --- pointer to an index in one-dimensional array,
-				              k = 0,1,...,[n*(n+1)/2]-1
+				double* q --- pointer to a quaternion with q0 being scalar part,
+				              q = [cos(|e|/2) e*sin(|e|/2)/|e|], so that fsnav_linal_quat2mat(q) = fsnav_linal_eul2mat(e)
 		*/
-void fsnav_linal_u_ij2k(size_t* k, const size_t i, const size_t j, const size_t n)
+void fsnav_linal_eul2quat(double* q, double* e)
 {
-	*k = i*(2*n - 1 - i)/2 + j;
-}
+	const double eps = 1.0/0x0100; // 2^-8, guaranteed non-zero value in IEEE754 half-precision format
 
-		/*
+	double
+		e0, e02, // |e|, |e|^2
+		s;       // sin(|e|/2)/|e|
+
+	// |e|^2, |e|
+	e02 = e[0]*e[0] + e[1]*e[1] + e[2]*e[2];
+	e0 = sqrt(e02);
+	// cos(|e|/2), sin(|e|/2)/|e|
+	if (e0 > eps) {
+		q[0] = cos(e0/2);
+		s    = sin(e0/2)/e0;
+	}
+	else {
+		// Taylor expansion up to 6-th degree terms in |e|, the next ones are below 2^-60
+		q[0] = 1   - e02/8 *(1 - e02/48 *(1 - e02/120));
+		s    = 0.5 - e02/48*(1 - e02/80 *(1 - e02/168));
+	}
+	q[1] = e[0]*s;
+	q[2] = e[1]*s;
+	q[3] = e[2]*s;
+}
+
+		/*
+			calculate 3x3 rotation matrix R for 3x1 Euler vector e via Rodrigues' formula, polynomial approximations
+			input:
+				double* e --- pointer to a 3x1 Euler vector
+			output:
+				double* R --- pointer to a 3x3 rotation matrix,
+				              R = E + sin|e|/|e|*[e,] + (1-cos|e|)/|e|^2*[e,]^2
+			note:
+				for |e| <= 1, sin|e|/|e| and (1-cos|e|)/|e|^2 are minimax polynomials in |e|^2 (degrees 7 and 6),
+				with approximation errors below 9e-20 and 6e-18, so that no square root, division or libm call is involved 
+				and the elements are within 4e-16 of the exact values (tests/test_linal_fast.c);
+				for |e| > 1 fsnav_linal_eul2mat is called
+		*/
+void fsnav_linal_eul2mat_fast(double* R, double* e)
+{
+	double
+		e02,        // |e|^2
+		e1, e2, e3, // e[i]^2
+		s, c;       // sin|e|/|e|, (1 - cos|e|)/|e|^2
+
+	// e[i]^2, |e|^2
+	e1 = e[0]*e[0], e2 = e[1]*e[1], e3 = e[2]*e[2];
+	e02 = e1 + e2 + e3;
+	if (!(e02 <= 1)) { // including NaN
+		fsnav_linal_eul2mat(R, e);
+		return;
+	}
+	// sin|e|/|e|, (1 - cos|e|)/|e|^2, minimax over 0 <= |e|^2 <= 1
+	s = 1 + e02*(-1.66666666666666657e-01 + e02*( 8.33333333333310597e-03 + e02*(-1.98412698410875354e-04 
+	      + e02*( 2.75573191523258506e-06 + e02*(-2.50520930861430735e-08 + e02*( 1.60572335147523014e-10 
+	      + e02*(-7.53549314239875728e-13)))))));
+	c = 0.5 + e02*(-4.16666666666661023e-02 + e02*( 1.38888888887985082e-03 + e02*(-2.48015872473264624e-05 
+	        + e02*( 2.75573037084355353e-07 + e02*(-2.08744785225878624e-09 + e02*  1.13046397571159121e-11)))));
+
+	// rotation matrix
+	R[0] =  1 - (e2 + e3)*c;      R[1] =  e[2]*s + e[0]*e[1]*c; R[2] = -e[1]*s + e[2]*e[0]*c;
+	R[3] = -e[2]*s + e[0]*e[1]*c; R[4] =  1 - (e3 + e1)*c;      R[5] =  e[0]*s + e[1]*e[2]*c;
+	R[6] =  e[1]*s + e[2]*e[0]*c; R[7] = -e[0]*s + e[1]*e[2]*c; R[8] =  1 - (e1 + e2)*c;
+}
+
+		/*
+			calculate quaternion q for 3x1 Euler vector e, polynomial approximations
+			input:
+				double* e --- pointer to a 3x1 Euler vector
+			output:
+				double* q --- pointer to a quaternion with q0 being scalar part,
+				              q = [cos(|e|/2) e*sin(|e|/2)/|e|]
+			note:
+				for |e| <= 1, cos(|e|/2) and sin(|e|/2)/|e| are Taylor polynomials in |e|^2 of degree 7, 
+				with truncation errors below 8e-19 and 3e-20, so that no square root, division or libm call is involved;
+				for |e| > 1 fsnav_linal_eul2quat is called
+		*/
+void fsnav_linal_eul2quat_fast(double* q, double* e)
+{
+	double 
+		e02, // |e|^2
+		s;   // sin(|e|/2)/|e|
+
+	// |e|^2
+	e02 = e[0]*e[0] + e[1]*e[1] + e[2]*e[2];
+	if (!(e02 <= 1)) { // including NaN
+		fsnav_linal_eul2quat(q, e);
+		return;
+	}
+	// cos(|e|/2), sin(|e|/2)/|e|
+	q[0] = 1 + e02*(-1.25000000000000000e-01 + e02*( 2.60416666666666652e-03 + e02*(-2.17013888888888897e-05 
+	         + e02*( 9.68812003968253967e-08 + e02*(-2.69114445546737190e-10 + e02*( 5.09686449899123540e-13 
+	         + e02*(-7.00118749861433381e-16)))))));
+	s  = 0.5 + e02*(-2.08333333333333322e-02 + e02*( 2.60416666666666663e-04 + e02*(-1.55009920634920635e-06 
+	         + e02*( 5.38228891093474463e-09 + e02*(-1.22324747975789650e-11 + e02*( 1.96033249961201335e-14 
+	         + e02*(-2.33372916620477796e-17)))))));
+	q[1] = e[0]*s;
+	q[2] = e[1]*s;
+	q[3] = e[2]*s;
+}
+
+		/*
+			calculate quaternions for an array of 3x1 Euler vectors
+			input:
+				double*      e    --- pointer to n 3x1 Euler vectors lined up one after another
+				const size_t n    --- number of vectors
+				const char   fast --- 1 for fsnav_linal_eul2quat_fast, 0 for fsnav_linal_eul2quat
+			output:
+				double* q --- pointer to n quaternions lined up one after another
+			note:
+				with fast = 1 and all |e| <= 1, the loop is branch-free and vectorized across vectors by the compiler
+		*/
+void fsnav_linal_eul2quat_batch(double* q, double* e, const size_t n, const char fast)
+{
+	double e02, s;
+	size_t i;
+
+	if (fast) {
+		for (i = 0; i < n; i++)
+			if (!(e[3*i]*e[3*i] + e[3*i+1]*e[3*i+1] + e[3*i+2]*e[3*i+2] <= 1))
+				break;
+		if (i < n) { // large angles or NaN
+			for (i = 0; i < n; i++)
+				fsnav_linal_eul2quat_fast(q + 4*i, e + 3*i);
+			return;
+		}
+		for (i = 0; i < n; i++) {
+			e02 = e[3*i]*e[3*i] + e[3*i+1]*e[3*i+1] + e[3*i+2]*e[3*i+2];
+			q[4*i] = 1 + e02*(-1.25000000000000000e-01 + e02*( 2.60416666666666652e-03 + e02*(-2.17013888888888897e-05 
+			           + e02*( 9.68812003968253967e-08 + e02*(-2.69114445546737190e-10 + e02*( 5.09686449899123540e-13 
+			           + e02*(-7.00118749861433381e-16)))))));
+			s  = 0.5 + e02*(-2.08333333333333322e-02 + e02*( 2.60416666666666663e-04 + e02*(-1.55009920634920635e-06 
+			           + e02*( 5.38228891093474463e-09 + e02*(-1.22324747975789650e-11 + e02*( 1.96033249961201335e-14 
+			           + e02*(-2.33372916620477796e-17)))))));
+			q[4*i+1] = e[3*i  ]*s;
+			q[4*i+2] = e[3*i+1]*s;
+			q[4*i+3] = e[3*i+2]*s;
+		}
+	}
+	else
+		for (i = 0; i < n; i++)
+			fsnav_linal_eul2quat(q + 4*i, e + 3*i);
+}
+
+		/*
+			calculate 3x3 rotation matrices for an array of 3x1 Euler vectors via Rodrigues' formula
+			input:
+				double*      e    --- pointer to n 3x1 Euler vectors lined up one after another
+				const size_t n    --- number of vectors
+				const char   fast --- 1 for fsnav_linal_eul2mat_fast, 0 for fsnav_linal_eul2mat
+			output:
+				double* R --- pointer to n 3x3 rotation matrices lined up one after another
+		*/
+void fsnav_linal_eul2mat_batch(double* R, double* e, const size_t n, const char fast)
+{
+	size_t i;
+
+	if (fast)
+		for (i = 0; i < n; i++)
+			fsnav_linal_eul2mat_fast(R + 9*i, e + 3*i);
+	else
+		for (i = 0; i < n; i++)
+			fsnav_linal_eul2mat(R + 9*i, e + 3*i);
+}
+
+		/*
+			calculate arctangent of y/x in the range of -pi..pi, polynomial approximation
+			input:
+				double y --- numerator
+				double x --- denominator
+			return value:
+				atan2(y, x), radians
+			note:
+				the argument is reduced to |a| <= tan(pi/12) by a = min(|x|,|y|)/max(|x|,|y|) and atan(a) = pi/6 + atan((a*sqrt(3) - 1)/(a + sqrt(3))),
+				then atan(a)/a is a minimax polynomial in a^2 of degree 8 with relative approximation error below 2e-17;
+				the result is within 6e-16 rad of the exact value (tests/test_linal_fast.c), atan2 from libm is called for zero, infinite or NaN arguments
+		*/
+double fsnav_linal_atan2_fast(double y, double x)
+{
+	const double
+		pi   = 3.141592653589793238462643383279502884, // IEEE-754 quadruple precision
+		sq3  = 1.732050807568877293527446341505872367, // sqrt(3)
+		tg15 = 0.267949192431122706472553658494127633; // tan(pi/12) = 2 - sqrt(3)
+	double ax = fabs(x), ay = fabs(y), a, z, r;
+
+	if (!(ax > 0 && ay > 0) || !(ax + ay <= DBL_MAX)) // zeros (signed), infinities, NaN
+		return atan2(y, x);
+	// a = min/max, 0 <= a <= 1
+	a = (ay > ax) ? ax/ay : ay/ax;
+	// reduction to |a| <= tan(pi/12)
+	if (a > tg15) {
+		a = (a*sq3 - 1)/(a + sq3);
+		r = pi/6;
+	}
+	else
+		r = 0;
+	// atan(a) = a*(1 + a^2*P(a^2))
+	z = a*a;
+	r += a + a*z*(-3.33333333333299286e-01 + z*( 1.99999999987294563e-01 + z*(-1.42857141028264245e-01 
+	   + z*( 1.11110978981027037e-01 + z*(-9.09037114352910791e-02 + z*( 7.67936871840721597e-02 
+	   + z*(-6.48319375600108494e-02 + z*  4.43895245061651580e-02)))))));
+	// octant, quadrant
+	if (ay > ax)
+		r = pi/2 - r;
+	if (x < 0)
+		r = pi - r;
+	return (y < 0) ? -r : r;
+}
+
+		/*
+			calculate roll, pitch and yaw corresponding to 3x3 transition matrix R from E-N-U, polynomial approximations
+			input:
+				double* R --- pointer to a 3x3 transition matrix R from E-N-U
+			output:
+				double* rpy --- pointer to a roll, pitch and yaw (radians, airborne frame: X longitudinal, Z right-wing)
+			note:
+				same as fsnav_linal_mat2rpy with fsnav_linal_atan2_fast instead of atan2,
+				the angles are within 1.5e-15 rad of fsnav_linal_mat2rpy, pitch close to +-90 deg included (tests/test_linal_fast.c)
+		*/
+void fsnav_linal_mat2rpy_fast(double* rpy, double* R)
+FSNAV_LINAL_MAT2RPY_BODY(fsnav_linal_atan2_fast)
+
+	// routines for n x n upper-triangular matrices lined up in one-dimensional array
+		// sizes that small-matrix routines are compiled for with a constant n, letting the compiler unroll the loops and fold the packed index arithmetic;
+		// the generic routines dispatch these sizes to the specialized instances, which perform exactly the same operations in the same order;
+		// each routine is specialized only up to the size it measurably gains at, see tests/bench_linal_sizes
+#define FSNAV_LINAL_SIZES(X)        X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15) X(16) // up to FSNAV_LINAL_SIZE_MAX
+#define FSNAV_LINAL_SIZES_CHOL(X)   X(2) X(3)                                                                         // up to FSNAV_LINAL_CHOL_SIZE_MAX
+#define FSNAV_LINAL_SIZES_UPDATE(X) X(2) X(3) X(4) X(5) X(6) X(7) X(8)                                               // up to FSNAV_LINAL_UPDATE_SIZE_MAX
+#define FSNAV_LINAL_SIZES_CAT(name, N) name##N
+
+		/*
+			convert index for upper-triangular matrix lined up in one-dimensional array: (i,j) -> k
+			input:
+				const size_t i, j --- row and column indexes in upper-triangular matrix,
+				                      i,j = 0,1,...,n-1
+				const size_t n    --- upper-triangular matrix dimension
+			output:
+				size_t* k --- pointer to an index in one-dimensional array,
+				              k = 0,1,...,[n*(n+1)/2]-1
+		*/
+void fsnav_linal_u_ij2k(size_t* k, const size_t i, const size_t j, const size_t n)
+{
+	*k = i*(2*n - 1 - i)/2 + j;
+}
+
+		/*
 			convert index for upper-triangular matrix lined up in one-dimensional array: k -> (i,j)
 			input:
 				const size_t k --- index in one-dimensional array,
@@ -2218,6 +3651,44 @@ void fsnav_linal_mul_u(double* res, double* v, double* u, const size_t m, const
 	}		
 }
 
+		/*
+			multiply 3x3 upper-triangular matrix lined up in one-dimensional array of 6 x 1 by 3x1 vector
+			input:
+				double* u --- pointer to an upper-triangular 3x3 matrix lined up in one-dimensional array of 6 x 1
+				double* v --- pointer to a 3x1 vector
+			output:
+				double* res --- pointer to a 3x1 vector,
+				                res = U*v
+			note:
+				same as fsnav_linal_u_mul(res, u, v, 3, 1), unrolled,
+				overwriting input (double* res = double* v) is allowed
+		*/
+void fsnav_linal_u_mul3x1(double* res, double* u, double* v)
+{
+	res[0] = u[0]*v[0] + u[1]*v[1] + u[2]*v[2];
+	res[1] = u[3]*v[1] + u[4]*v[2];
+	res[2] = u[5]*v[2];
+}
+
+		/*
+			multiply transposed 3x3 upper-triangular matrix lined up in one-dimensional array of 6 x 1 by 3x1 vector
+			input:
+				double* u --- pointer to an upper-triangular 3x3 matrix lined up in one-dimensional array of 6 x 1
+				double* v --- pointer to a 3x1 vector
+			output:
+				double* res --- pointer to a 3x1 vector,
+				                res = U^T*v, or res^T = v^T*U
+			note:
+				same as fsnav_linal_uT_mul(res, u, v, 3, 1) and fsnav_linal_mul_u(res, v, u, 1, 3), unrolled,
+				overwriting input (double* res = double* v) is allowed
+		*/
+void fsnav_linal_uT_mul3x1(double* res, double* u, double* v)
+{
+	res[2] = v[2]*u[5] + v[1]*u[4] + v[0]*u[2];
+	res[1] = v[1]*u[3] + v[0]*u[1];
+	res[0] = v[0]*u[0];
+}
+
 		/* 
 			multiply a regular matrix by itself transposed, storing upper part of the result lined up in one-dimensional array of n(n+1)/2 x 1 
 			input:
@@ -2230,9 +3701,37 @@ void fsnav_linal_mul_u(double* res, double* v, double* u, const size_t m, const
 		*/
 void fsnav_linal_msq2T_u(double* res, double* v, const size_t n, const size_t m)
 {
-	size_t i, i1, j, k, im, i1m;
+	size_t i, i1, j, k, im, i1m, r, c, n4;
+	double t[16], *ra[4], *rb[4];
+
+	// 4 x 4 tiles on and above the diagonal, for large matrices
+	if (n >= FSNAV_LINAL_BLOCK_MIN) {
+		n4 = n - n%4;
+		for (i = 0; i < n4; i += 4) {
+			for (r = 0; r < 4; r++)
+				ra[r] = v + (i+r)*m;
+			for (i1 = i; i1 < n4; i1 += 4) {
+				for (r = 0; r < 4; r++) {
+					rb[r] = v + (i1+r)*m;
+					t[4*r] = t[4*r+1] = t[4*r+2] = t[4*r+3] = 0;
+				}
+				fsnav_linal_tile4x4(t, ra, 1, rb, 1, m, 0);
+				for (r = 0; r < 4; r++)
+					for (c = (i1 == i) ? r : 0, k = (i+r)*(2*n-1-(i+r))/2 + i1+c; c < 4; c++, k++)
+						res[k] = t[4*r+c];
+			}
+			// columns left over from the tiles
+			for (r = i; r < i+4; r++)
+				for (i1 = n4, im = r*m, k = r*(2*n-1-r)/2 + i1; i1 < n; i1++, k++)
+					for (j = 0, i1m = i1*m, res[k] = 0; j < m; j++)
+						res[k] += v[im + j]*v[i1m + j];
+		}
+	}
+	else
+		n4 = 0;
 
-	for (i = 0, i1 = 0, k = 0; i < n; i++)
+	// element-wise, rows left over from the tiles
+	for (i = n4, i1 = 0, k = n4*(2*n+1-n4)/2; i < n; i++)
 		for (i1 = i, im = i*m; i1 < n; i1++, k++)
 			for (j = 0, i1m = i1*m, res[k] = 0; j < m; j++)
 				res[k] += v[im + j]*v[i1m + j];
@@ -2288,6 +3787,91 @@ void fsnav_linal_u_inv(double* res, double* u, const size_t n)
 	}
 }
 
+		// fsnav_linal_uuT body, shared by the generic routine and its size-specialized instances
+#define FSNAV_LINAL_UUT_BODY(n) {                             \
+	size_t i, j, k, p, q, r;                                  \
+                                                              \
+	for (i = 0, k = 0; i < n; i++) {                          \
+		for (j = i; j < n; j++, k++) {                        \
+			fsnav_linal_u_ij2k(&p, j, j, n);                  \
+			res[k] = u[k]*u[p];                               \
+			for (q = k+1, p++, r = j+1; r < n; q++, p++, r++) \
+				res[k] += u[q]*u[p];                          \
+		}                                                     \
+	}                                                         \
+}
+#define FSNAV_LINAL_UUT_N(N)   static void FSNAV_LINAL_SIZES_CAT(fsnav_linal_uuT_, N)(double* res, double* u) FSNAV_LINAL_UUT_BODY(N)
+#define FSNAV_LINAL_UUT_PTR(N) FSNAV_LINAL_SIZES_CAT(fsnav_linal_uuT_, N),
+FSNAV_LINAL_SIZES(FSNAV_LINAL_UUT_N)
+static void(*const fsnav_linal_uuT_n[])(double*, double*) = { FSNAV_LINAL_SIZES(FSNAV_LINAL_UUT_PTR) };
+
+		/*
+			calculate square (with transposition) of upper-triangular matrix in 4 x 4 register tiles, for n >= FSNAV_LINAL_BLOCK_MIN
+			input:
+				double* u      --- pointer to an upper-triangular matrix 
+				                   lined up in one-dimensional array of n(n+1)/2 x 1
+				const size_t n --- dimension
+			output:
+				double* res --- pointer to a symmetric matrix
+				                lined up in one-dimensional array of n(n+1)/2 x 1,
+				                res = U*U^T
+			note:
+				overwriting input (double* res = double* u) is allowed, as the tiles are stored row by row, left to right,
+				and each one reads the elements of U to the right of its first column only;
+				the diagonal tiles and the rows and columns left over are calculated element-wise
+		*/
+void fsnav_linal_uuT_blocked(double* res, double* u, const size_t n)
+{
+	size_t i, j, k, p, q, r, c, i0, j0, n4 = n - n%4;
+	double t[16], *ra[4], *rb[4];
+
+	for (i0 = 0; i0 < n; i0 += 4) {
+		// diagonal tile (or rows left over), element-wise
+		for (i = i0; i < n && i < i0+4; i++) {
+			for (j = i, k = i*(2*n-1-i)/2 + j; j < n && (j < i0+4 || i0 >= n4); j++, k++) {
+				fsnav_linal_u_ij2k(&p, j, j, n);
+				res[k] = u[k]*u[p];
+				for (q = k+1, p++, r = j+1; r < n; q++, p++, r++)
+					res[k] += u[q]*u[p];
+			}
+		}
+		if (i0 >= n4)
+			break;
+		// tiles to the right of the diagonal
+		for (j0 = i0+4; j0 < n4; j0 += 4) {
+			for (r = 0; r < 4; r++) {
+				ra[r] = u + (i0+r)*(2*n-1-(i0+r))/2; // U(i,j) = ra[j]
+				rb[r] = u + (j0+r)*(2*n-1-(j0+r))/2;
+			}
+			// triangular head, U(j,p) = 0 for p < j
+			for (c = 0; c < 4; c++)
+				for (r = 0; r < 4; r++) {
+					t[4*r+c] = ra[r][j0+c]*rb[c][j0+c];
+					for (p = j0+c+1; p < j0+4; p++)
+						t[4*r+c] += ra[r][p]*rb[c][p];
+				}
+			// the rest
+			for (r = 0; r < 4; r++) {
+				ra[r] += j0+4;
+				rb[r] += j0+4;
+			}
+			fsnav_linal_tile4x4(t, ra, 1, rb, 1, n-j0-4, 0);
+			for (r = 0; r < 4; r++)
+				for (c = 0, k = (i0+r)*(2*n-1-(i0+r))/2 + j0; c < 4; c++, k++)
+					res[k] = t[4*r+c];
+		}
+		// columns left over
+		for (i = i0; i < i0+4; i++) {
+			for (j = n4, k = i*(2*n-1-i)/2 + j; j < n; j++, k++) {
+				fsnav_linal_u_ij2k(&p, j, j, n);
+				res[k] = u[k]*u[p];
+				for (q = k+1, p++, r = j+1; r < n; q++, p++, r++)
+					res[k] += u[q]*u[p];
+			}
+		}
+	}
+}
+
 		/*
 			calculate square (with transposition) of upper-triangular matrix lined up in one-dimensional array of n(n+1)/2 x 1
 			input:
@@ -2303,17 +3887,38 @@ void fsnav_linal_u_inv(double* res, double* u, const size_t n)
 		*/
 void fsnav_linal_uuT(double* res, double* u, const size_t n)
 {
-	size_t i, j, k, p, q, r;
-
-	for (i = 0, k = 0; i < n; i++) {
-		for (j = i; j < n; j++, k++) {
-			fsnav_linal_u_ij2k(&p, j, j, n);
-			res[k] = u[k]*u[p];
-			for (q = k+1, p++, r = j+1; r < n; q++, p++, r++)
-				res[k] += u[q]*u[p];
-		}
+	if (n >= FSNAV_LINAL_SIZE_MIN && n <= FSNAV_LINAL_SIZE_MAX) {
+		fsnav_linal_uuT_n[n - FSNAV_LINAL_SIZE_MIN](res, u);
+		return;
 	}
+	if (n >= FSNAV_LINAL_BLOCK_MIN) {
+		fsnav_linal_uuT_blocked(res, u, n);
+		return;
+	}
+	FSNAV_LINAL_UUT_BODY(n)
+}
+
+		// fsnav_linal_chol body, shared by the generic routine and its size-specialized instances
+#define FSNAV_LINAL_CHOL_BODY(n) {                            \
+	size_t i, j, k, k0, p, q, p0;                             \
+	double s;                                                 \
+                                                              \
+	for (j = 0, k0 = n*(n+1)/2 - 1; j < n; k0 -= j+2, j++) {  \
+		p0 = k0+j;                                            \
+		for (p = k0+1, s = 0; p <= p0; p++)                   \
+			s += S[p]*S[p];                                   \
+		S[k0] = sqrt(P[k0] - s);                              \
+		for (i = j+1, k = k0-j-1; i < n; k -= i+1, i++) {     \
+			for (p = k0+1, q = k+1, s = 0; p <= p0; p++, q++) \
+				s += S[p]*S[q];                               \
+			S[k] = (S[k0] == 0) ? 0 : (P[k] - s)/S[k0];       \
+		}                                                     \
+	}                                                         \
 }
+#define FSNAV_LINAL_CHOL_N(N)   static void FSNAV_LINAL_SIZES_CAT(fsnav_linal_chol_, N)(double* S, double* P) FSNAV_LINAL_CHOL_BODY(N)
+#define FSNAV_LINAL_CHOL_PTR(N) FSNAV_LINAL_SIZES_CAT(fsnav_linal_chol_, N),
+FSNAV_LINAL_SIZES_CHOL(FSNAV_LINAL_CHOL_N)
+static void(*const fsnav_linal_chol_n[])(double*, double*) = { FSNAV_LINAL_SIZES_CHOL(FSNAV_LINAL_CHOL_PTR) };
 
 		/*
 			calculate Cholesky upper-triangular factorization P = S*S^T,
@@ -2330,23 +3935,38 @@ void fsnav_linal_uuT(double* res, double* u, const size_t n)
 		*/
 void fsnav_linal_chol(double* S, double* P, const size_t n)
 {
-	size_t i, j, k, k0, p, q, p0;
-	double s;
-
-	for (j = 0, k0 = n*(n+1)/2 - 1; j < n; k0 -= j+2, j++) {
-		p0 = k0+j;
-		for (p = k0+1, s = 0; p <= p0; p++)
-			s += S[p]*S[p];
-		S[k0] = sqrt(P[k0] - s);
-		for (i = j+1, k = k0-j-1; i < n; k -= i+1, i++) {
-			for (p = k0+1, q = k+1, s = 0; p <= p0; p++, q++)
-				s += S[p]*S[q];
-			S[k] = (S[k0] == 0) ? 0 : (P[k] - s)/S[k0];
-		}
+	if (n >= FSNAV_LINAL_SIZE_MIN && n <= FSNAV_LINAL_CHOL_SIZE_MAX) {
+		fsnav_linal_chol_n[n - FSNAV_LINAL_SIZE_MIN](S, P);
+		return;
 	}
+	FSNAV_LINAL_CHOL_BODY(n)
 }
 
 	// square root Kalman filtering
+		// fsnav_linal_check_measurement_residual body, shared by the generic routine and its size-specialized instances
+#define FSNAV_LINAL_CHECK_RESIDUAL_BODY(n) {             \
+	size_t i, j, k;                                      \
+                                                         \
+	double s;                                            \
+                                                         \
+	sigma = sigma*sigma;                                 \
+	for (i = 0; i < n; i++) {                            \
+		/* dz = z - h*x: residual */                     \
+		z -= h[i]*x[i];                                  \
+		/* s = h*S*S^T*h^T: predicted variance */        \
+		for (j = 0, k = i, s = 0; j <= i; j++, k += n-j) \
+			s += h[j]*S[k];                              \
+		sigma += s*s;                                    \
+	}                                                    \
+	sigma = sqrt(sigma);                                 \
+                                                         \
+	return (fabs(z) < k_sigma*sigma) ? 1 : 0;            \
+}
+#define FSNAV_LINAL_CHECK_RESIDUAL_N(N)   static char FSNAV_LINAL_SIZES_CAT(fsnav_linal_check_measurement_residual_, N)(double* x, double* S, double z, double* h, double sigma, double k_sigma) FSNAV_LINAL_CHECK_RESIDUAL_BODY(N)
+#define FSNAV_LINAL_CHECK_RESIDUAL_PTR(N) FSNAV_LINAL_SIZES_CAT(fsnav_linal_check_measurement_residual_, N),
+FSNAV_LINAL_SIZES(FSNAV_LINAL_CHECK_RESIDUAL_N)
+static char(*const fsnav_linal_check_measurement_residual_n[])(double*, double*, double, double*, double, double) = { FSNAV_LINAL_SIZES(FSNAV_LINAL_CHECK_RESIDUAL_PTR) };
+
 		/*
 			check measurement residual magnitude against predicted covariance level
 			input:
@@ -2365,23 +3985,63 @@ void fsnav_linal_chol(double* S, double* P, const size_t n)
 		*/
 char fsnav_linal_check_measurement_residual(double* x, double* S, double z, double* h, double sigma, double k_sigma, const size_t n)
 {
-	size_t i, j, k;
-
-	double s;
-
-	sigma = sigma*sigma;
-	for (i = 0; i < n; i++) {
-		// dz = z - h*x: residual
-		z -= h[i]*x[i];
-		// s = h*S*S^T*h^T: predicted variance 
-		for (j = 0, k = i, s = 0; j <= i; j++, k += n-j)
-			s += h[j]*S[k];
-		sigma += s*s;
-	}
-	sigma = sqrt(sigma);
+	if (n >= FSNAV_LINAL_SIZE_MIN && n <= FSNAV_LINAL_SIZE_MAX)
+		return fsnav_linal_check_measurement_residual_n[n - FSNAV_LINAL_SIZE_MIN](x, S, z, h, sigma, k_sigma);
+	FSNAV_LINAL_CHECK_RESIDUAL_BODY(n)
+}
 
-	return (fabs(z) < k_sigma*sigma) ? 1 : 0;
+		// fsnav_linal_kalman_update body, shared by the generic routine and its size-specialized instances
+#define FSNAV_LINAL_KALMAN_UPDATE_BODY(n) {                                         \
+	double d, d1, sd, sd1, f, e;                                                    \
+	size_t i, j, k;                                                                 \
+                                                                                    \
+	/* e0 stored in K */                                                            \
+	for (i = 0; i < n; i++)                                                         \
+		K[i] = 0;                                                                   \
+                                                                                    \
+	/* d0, sqrt(d0) */                                                              \
+	d  = sigma*sigma;                                                               \
+	sd = sqrt(d);                                                                   \
+                                                                                    \
+	/* S */                                                                         \
+	for (i = 0; i < n; i++) {                                                       \
+		/* f = S^T*h */                                                             \
+		f = S[i]*h[0];                                                              \
+		for (j = 1, k = i+n-1; j <= i; j++, k += n-j)                               \
+			f += S[k]*h[j];                                                         \
+		if (f == 0)                                                                 \
+			continue; /* optimization for sparse matrices */                        \
+		/* d, sqrt(d) of the previous row is reused */                              \
+		d1 = d + f*f;                                                               \
+		sd1 = sqrt(d1);                                                             \
+		/* S^+, e */                                                                \
+		for (j = 0, k = i; j <= i; j++, k += n-j) {                                 \
+			e = K[j];                                                               \
+			K[j] += S[k]*f;                                                         \
+			S[k] *= sd/sd1;                                                         \
+			if (e != 0)               /* optimization for degenerate case */        \
+				S[k] -= e*f/(sd*sd1); /* d = 0 (sigma = 0) allowed only if e = 0 */ \
+		}                                                                           \
+		d  = d1;                                                                    \
+		sd = sd1;                                                                   \
+                                                                                    \
+		/* dz */                                                                    \
+		z -= h[i]*x[i];                                                             \
+	}                                                                               \
+                                                                                    \
+	/* K, x */                                                                      \
+	for (i = 0; i < n; i++) {                                                       \
+		if (K[i] != 0) { /* optimization for degenerate case */                     \
+			K[i] /= d;   /* d = 0 (sigma = 0) allowed only for K[i] = 0 */          \
+			x[i] += K[i]*z;                                                         \
+		}                                                                           \
+	}                                                                               \
+	return z;                                                                       \
 }
+#define FSNAV_LINAL_KALMAN_UPDATE_N(N)   static double FSNAV_LINAL_SIZES_CAT(fsnav_linal_kalman_update_, N)(double* x, double* S, double* K, double z, double* h, double sigma) FSNAV_LINAL_KALMAN_UPDATE_BODY(N)
+#define FSNAV_LINAL_KALMAN_UPDATE_PTR(N) FSNAV_LINAL_SIZES_CAT(fsnav_linal_kalman_update_, N),
+FSNAV_LINAL_SIZES_UPDATE(FSNAV_LINAL_KALMAN_UPDATE_N)
+static double(*const fsnav_linal_kalman_update_n[])(double*, double*, double*, double, double*, double) = { FSNAV_LINAL_SIZES_UPDATE(FSNAV_LINAL_KALMAN_UPDATE_PTR) };
 
 		/*
 			perform square root Kalman filter update phase
@@ -2402,28 +4062,152 @@ char fsnav_linal_check_measurement_residual(double* x, double* S, double z, doub
 				measurement residual before update
 		*/
 double fsnav_linal_kalman_update(double* x, double* S, double* K, double z, double* h, double sigma, const size_t n)
+{
+	if (n >= FSNAV_LINAL_SIZE_MIN && n <= FSNAV_LINAL_UPDATE_SIZE_MAX)
+		return fsnav_linal_kalman_update_n[n - FSNAV_LINAL_SIZE_MIN](x, S, K, z, h, sigma);
+	FSNAV_LINAL_KALMAN_UPDATE_BODY(n)
+}
+
+		// fsnav_linal_kalman_update_gated body, shared by the generic routine and its size-specialized instances
+#define FSNAV_LINAL_KALMAN_UPDATE_GATED_BODY(n) {                                   \
+	double d, d1, sd, sd1, f, e;                                                    \
+	size_t i, j, k;                                                                 \
+                                                                                    \
+	/* f = S^T*h stored in K, d = h*S*S^T*h^T + sigma^2, dz = z - h*x */            \
+	d = sigma*sigma;                                                                \
+	for (i = 0; i < n; i++) {                                                       \
+		f = S[i]*h[0];                                                              \
+		for (j = 1, k = i+n-1; j <= i; j++, k += n-j)                               \
+			f += S[k]*h[j];                                                         \
+		K[i] = f;                                                                   \
+		d += f*f;                                                                   \
+		z -= h[i]*x[i];                                                             \
+	}                                                                               \
+                                                                                    \
+	/* gate */                                                                      \
+	if (nu != NULL)                                                                 \
+		*nu = (d > 0) ? z/sqrt(d) : 0;                                              \
+	if (!(fabs(z) < k_sigma*sqrt(d)))                                               \
+		return 0;                                                                   \
+                                                                                    \
+	/* d0, sqrt(d0) */                                                              \
+	d  = sigma*sigma;                                                               \
+	sd = sqrt(d);                                                                   \
+                                                                                    \
+	/* S, e stored in K over the already processed rows */                          \
+	for (i = 0; i < n; i++) {                                                       \
+		f = K[i];                                                                   \
+		K[i] = 0;                                                                   \
+		if (f == 0)                                                                 \
+			continue; /* optimization for sparse matrices */                        \
+		d1 = d + f*f;                                                               \
+		sd1 = sqrt(d1);                                                             \
+		for (j = 0, k = i; j <= i; j++, k += n-j) {                                 \
+			e = K[j];                                                               \
+			K[j] += S[k]*f;                                                         \
+			S[k] *= sd/sd1;                                                         \
+			if (e != 0)               /* optimization for degenerate case */        \
+				S[k] -= e*f/(sd*sd1); /* d = 0 (sigma = 0) allowed only if e = 0 */ \
+		}                                                                           \
+		d  = d1;                                                                    \
+		sd = sd1;                                                                   \
+	}                                                                               \
+                                                                                    \
+	/* K, x */                                                                      \
+	for (i = 0; i < n; i++) {                                                       \
+		if (K[i] != 0) { /* optimization for degenerate case */                     \
+			K[i] /= d;   /* d = 0 (sigma = 0) allowed only for K[i] = 0 */          \
+			x[i] += K[i]*z;                                                         \
+		}                                                                           \
+	}                                                                               \
+	return 1;                                                                       \
+}
+#define FSNAV_LINAL_KALMAN_UPDATE_GATED_N(N)   static char FSNAV_LINAL_SIZES_CAT(fsnav_linal_kalman_update_gated_, N)(double* x, double* S, double* K, double* nu, double z, double* h, double sigma, double k_sigma) FSNAV_LINAL_KALMAN_UPDATE_GATED_BODY(N)
+#define FSNAV_LINAL_KALMAN_UPDATE_GATED_PTR(N) FSNAV_LINAL_SIZES_CAT(fsnav_linal_kalman_update_gated_, N),
+FSNAV_LINAL_SIZES(FSNAV_LINAL_KALMAN_UPDATE_GATED_N)
+static char(*const fsnav_linal_kalman_update_gated_n[])(double*, double*, double*, double*, double, double*, double, double) = { FSNAV_LINAL_SIZES(FSNAV_LINAL_KALMAN_UPDATE_GATED_PTR) };
+
+		/*
+			perform square root Kalman filter update phase if measurement residual passes the gate
+			input:
+				double*      x       --- pointer to a current estimate of n x 1 state vector
+				double*      S       --- pointer to an upper-truangular part of the Cholesky factor of current covariance matrix
+				                         lined in one-dimensional array n(n+1)/2 x 1
+				double       z       --- scalar measurement value
+				double*      h       --- pointer to a linear measurement model matrix, so that z = h*x + r
+				double       sigma   --- measurement error a priori standard deviation, so that sigma = sqrt(E[r^2])
+				double       k_sigma --- confidence coefficient, 3 for 3-sigma (99.7%), 2 for 2-sigma (95%), etc.
+				const size_t n       --- state vector size
+			output:
+				double* x  --- pointer to an updated estimate of state vector (overwrites input, unchanged if rejected)
+				double* S  --- pointer to an upper-truangular part of the Cholesky factor of updated covariance matrix
+				               lined in one-dimensional array n(n+1)/2 x 1 (overwrites input, unchanged if rejected)
+				double* K  --- pointer to a Kalman gain (S^T*h if rejected)
+				double* nu --- pointer to normalized residual (z - h*x)/sqrt(h*S*S^T*h^T + sigma^2), may be NULL
+			return value:
+				1 if measurement residual magnitude lies below the predicted covariance level and the update is performed,
+				  i.e. |z - h*x| < k_sigma*sqrt(h*S*S^T*h^T + sigma^2)
+				0 otherwise
+			note:
+				same as fsnav_linal_check_measurement_residual followed by fsnav_linal_kalman_update, 
+				with S^T*h calculated once for both
+		*/
+char fsnav_linal_kalman_update_gated(double* x, double* S, double* K, double* nu, double z, double* h, double sigma, double k_sigma, const size_t n)
+{
+	if (n >= FSNAV_LINAL_SIZE_MIN && n <= FSNAV_LINAL_SIZE_MAX)
+		return fsnav_linal_kalman_update_gated_n[n - FSNAV_LINAL_SIZE_MIN](x, S, K, nu, z, h, sigma, k_sigma);
+	FSNAV_LINAL_KALMAN_UPDATE_GATED_BODY(n)
+}
+
+		/*
+			perform square root Kalman filter update phase for a sparse measurement model
+			input:
+				double*      x     --- pointer to a current estimate of n x 1 state vector
+				double*      S     --- pointer to an upper-truangular part of the Cholesky factor of current covariance matrix
+				                       lined in one-dimensional array n(n+1)/2 x 1
+				double       z     --- scalar measurement value
+				size_t*      hi    --- pointer to nz x 1 indices of nonzero elements of linear measurement model matrix h,
+				                       so that z = h*x + r, in ascending order
+				double*      hv    --- pointer to nz x 1 values of nonzero elements of h
+				const size_t nz    --- number of nonzero elements of h
+				double       sigma --- measurement error a priori standard deviation, so that sigma = sqrt(E[r^2])
+				const size_t n     --- state vector size
+			output:
+				double* x --- pointer to an updated estimate of state vector (overwrites input)
+				double* S --- pointer to an upper-truangular part of the Cholesky factor of updated covariance matrix
+				              lined in one-dimensional array n(n+1)/2 x 1 (overwrites input)
+				double* K --- pointer to a Kalman gain
+			return value:
+				measurement residual before update
+			note:
+				gives the same result as fsnav_linal_kalman_update with dense h,
+				rows of S above the first nonzero element of h are skipped, and S^T*h takes nz multiplications per column
+		*/
+double fsnav_linal_kalman_update_sparse(double* x, double* S, double* K, double z, size_t* hi, double* hv, const size_t nz, double sigma, const size_t n)
 {
 	double d, d1, sd, sd1, f, e;
-	size_t i, j, k;
+	size_t i, j, k, p, q;
 
 	// e0 stored in K
 	for (i = 0; i < n; i++)
 		K[i] = 0;
 
-	// d0
-	d = sigma*sigma;
-
-	// S
-	for (i = 0; i < n; i++) {
-		// f = S^T*h
-		f = S[i]*h[0];
-		for (j = 1, k = i+n-1; j <= i; j++, k += n-j)
-			f += S[k]*h[j];
+	// d0, sqrt(d0)
+	d  = sigma*sigma;
+	sd = sqrt(d);
+
+	// S, starting from the first nonzero element of h, as f = 0 before it
+	for (i = (nz > 0) ? hi[0] : n, p = 0; i < n; i++) {
+		// p = number of nonzero elements of h up to i-th
+		while (p < nz && hi[p] <= i)
+			p++;
+		// f = S^T*h over nonzero elements of h
+		for (q = 0, f = 0; q < p; q++)
+			f += S[hi[q]*(2*n-1-hi[q])/2 + i]*hv[q];
 		if (f == 0)
 			continue; // optimization for sparse matrices
-		// d
+		// d, sqrt(d) of the previous row is reused
 		d1 = d + f*f;
-		sd = sqrt(d);
 		sd1 = sqrt(d1);
 		// S^+, e
 		for (j = 0, k = i; j <= i; j++, k += n-j) {
@@ -2433,10 +4217,12 @@ double fsnav_linal_kalman_update(double* x, double* S, double* K, double z, doub
 			if (e != 0)               // optimization for degenerate case
 				S[k] -= e*f/(sd*sd1); // d = 0 (sigma = 0) allowed only if e = 0
 		}
-		d = d1;
+		d  = d1;
+		sd = sd1;
 
 		// dz
-		z -= h[i]*x[i];
+		if (hi[p-1] == i)
+			z -= hv[p-1]*x[i];
 	}
 
 	// K, x
@@ -2449,6 +4235,70 @@ double fsnav_linal_kalman_update(double* x, double* S, double* K, double z, doub
 	return z;
 }
 
+		/*
+			perform square root Kalman filter update phase for a vector measurement with correlated noise
+			input:
+				double*      x --- pointer to a current estimate of n x 1 state vector
+				double*      S --- pointer to an upper-truangular part of the Cholesky factor of current covariance matrix
+				                   lined in one-dimensional array n(n+1)/2 x 1
+				double*      z --- pointer to m x 1 measurement vector
+				double*      H --- pointer to m x n linear measurement model matrix, so that z = H*x + r
+				double*      R --- pointer to an upper-triangular part of the Cholesky factor of measurement error covariance, 
+				                   E[r*r^T] = R*R^T, lined in one-dimensional array m(m+1)/2 x 1, 
+				                   or NULL for measurement errors that are already uncorrelated with unit variance
+				const size_t n --- state vector size
+				const size_t m --- measurement vector size
+			output:
+				double* x --- pointer to an updated estimate of state vector (overwrites input)
+				double* S --- pointer to an upper-truangular part of the Cholesky factor of updated covariance matrix
+				              lined in one-dimensional array n(n+1)/2 x 1 (overwrites input)
+				double* K --- pointer to m x n matrix of Kalman gains, one row per whitened measurement component
+				double* z --- whitened measurement residuals, each one before its component update (overwrites input)
+				double* H --- whitened measurement model matrix R^-1*H (overwrites input)
+			return value:
+				1 if successful
+				0 otherwise (singular measurement error covariance factor)
+			note:
+				the measurement is decorrelated by triangular solve, z = R^-1*z, H = R^-1*H, 
+				then the whitened components with unit variance errors are processed one by one 
+				with size-specialized scalar update kernels selected once for all of the components;
+				for diagonal R this is equivalent to m calls of fsnav_linal_kalman_update with sigma = R_ii
+		*/
+char fsnav_linal_kalman_update_vector(double* x, double* S, double* K, double* z, double* H, double* R, const size_t n, const size_t m)
+{
+	double(*update)(double*, double*, double*, double, double*, double);
+	size_t i, j, k, k0, r;
+
+	// whitening: R*z' = z, R*H' = H, back substitution
+	if (R != NULL) {
+		for (r = m, k0 = m*(m+1)/2; r-- > 0; ) {
+			k0 -= m-r; // R_rr index
+			if (R[k0] == 0)
+				return 0;
+			for (j = r+1, k = k0+1; j < m; j++, k++) {
+				z[r] -= R[k]*z[j];
+				for (i = 0; i < n; i++)
+					H[r*n+i] -= R[k]*H[j*n+i];
+			}
+			z[r] /= R[k0];
+			for (i = 0; i < n; i++)
+				H[r*n+i] /= R[k0];
+		}
+	}
+
+	// sequential updates with whitened components, sigma = 1
+	if (n >= FSNAV_LINAL_SIZE_MIN && n <= FSNAV_LINAL_UPDATE_SIZE_MAX) {
+		update = fsnav_linal_kalman_update_n[n - FSNAV_LINAL_SIZE_MIN];
+		for (r = 0; r < m; r++)
+			z[r] = update(x, S, K + r*n, z[r], H + r*n, 1);
+	}
+	else
+		for (r = 0; r < m; r++)
+			z[r] = fsnav_linal_kalman_update(x, S, K + r*n, z[r], H + r*n, 1, n);
+
+	return 1;
+}
+
 		/*
 			perform square root Kalman filter prediction phase: identity state transition, scalar process noise covariance
 			Q = q^2*I = E[(x_i - x_i-1)*(x_i - x_i-1)^T]
@@ -2651,3 +4501,821 @@ void fsnav_linal_kalman_predict_U(double* x, double* S, double* U, double* Q, co
 	}
 	fsnav_linal_chol(S, S, n);           // P = S*S^T
 }
+
+		/*
+			perform square root Kalman filter prediction phase: general state transition, factor-form (triangularization) update
+			x_i = F*x_i-1,   E[(x_i - F*x_i-1)*(x_i - F*x_i-1)^T] = G*Q*G^T,   Q = Qh*Qh^T
+			the predicted factor is found from [F*S | G*Qh]*T = [S+ | 0] with orthogonal T (Householder reflections),
+			so that S+*S+^T = F*S*S^T*F^T + G*Q*G^T without forming the covariance matrix
+			input:
+				double*      x  --- pointer to a current estimate of n x 1 state vector, or NULL to propagate the covariance only
+				double*      S  --- pointer to an upper-truangular part of the Cholesky factor of current covariance matrix
+				                    lined in one-dimensional array n(n+1)/2 x 1
+				double*      F  --- pointer to a regular n x n state transition matrix, or NULL for identity,
+				                    zero elements are skipped, so block-sparse transitions cost in proportion to their nonzero blocks
+				double*      G  --- pointer to a regular n x m process noise input matrix, or NULL for G = [I; 0] (noise in the first m states)
+				double*      Qh --- pointer to an upper-triangular part of a Cholesky factor of m x m process noise covariance, Q = Qh*Qh^T,
+				                    lined in one-dimensional array m(m+1)/2 x 1
+				double*      A  --- pointer to a workspace of n x (n+m) elements
+				const size_t n  --- state vector size
+				const size_t m  --- process noise vector size
+			output:
+				double* x --- pointer to a predicted estimate of state vector (overwrites input)
+				double* S --- pointer to an upper-truangular part of the Cholesky factor of predicted covariance matrix
+				              lined in one-dimensional array n(n+1)/2 x 1 (overwrites input)
+		*/
+void fsnav_linal_kalman_predict_F(double* x, double* S, double* F, double* G, double* Qh, double* A, const size_t n, const size_t m)
+{
+	const size_t c = n+m; // workspace row length
+	size_t i, j, k, p, r, kj, lo, nlo, hi;
+	double a, b, s;
+	double *Ai, *Ar;
+
+	// x = F*x, first row of the workspace as a temporary
+	if (x != NULL && F != NULL) {
+		for (i = 0; i < n; i++)
+			for (j = 0, A[i] = 0; j < n; j++)
+				if (F[i*n+j] != 0)
+					A[i] += F[i*n+j]*x[j];
+		for (i = 0; i < n; i++)
+			x[i] = A[i];
+	}
+
+	// A = [F*S | G*Qh]
+	for (i = 0; i < n*c; i++)
+		A[i] = 0;
+	for (i = 0; i < n; i++) {
+		Ai = A + i*c;
+		for (k = 0, kj = 0; k < n; k++) {                // S row k holds S_kj, j = k..n-1
+			a = (F == NULL) ? (i == k) : F[i*n+k];
+			if (a == 0) {
+				kj += n-k;
+				continue;                               // skip zero elements of F
+			}
+			for (j = k; j < n; j++, kj++)
+				Ai[j] += a*S[kj];
+		}
+		for (k = 0, kj = 0; k < m; k++) {               // Qh row k holds Qh_kj, j = k..m-1
+			a = (G == NULL) ? (i == k) : G[i*m+k];
+			if (a == 0) {
+				kj += m-k;
+				continue;
+			}
+			for (j = k; j < m; j++, kj++)
+				Ai[n+j] += a*Qh[kj];
+		}
+	}
+
+	// A*T = [S+ | 0], Householder reflections from the last row up, 
+	// each one folding row i into column i over columns 0..i and n..n+m-1, the columns i+1..n-1 being already final;
+	// zeros at the ends of row i are skipped, as the reflection vector is zero there,
+	// so that upper-triangular F*S and noise in a few states cost far less than O(n^2*(n+m))
+	for (i = n; i-- > 0; ) {
+		Ai = A + i*c;
+		for (lo = 0; lo < i && Ai[lo] == 0; lo++);
+		for (hi = c; hi > n && Ai[hi-1] == 0; hi--);
+		for (nlo = n; nlo < hi && Ai[nlo] == 0; nlo++);
+		// s = |A_i|^2 over the active columns except for i
+		for (j = lo, s = 0; j < i; j++)
+			s += Ai[j]*Ai[j];
+		for (j = nlo; j < hi; j++)
+			s += Ai[j]*Ai[j];
+		if (s == 0) {                                   // nothing to fold, keep the sign of the diagonal
+			if (Ai[i] < 0)
+				for (r = 0; r <= i; r++)
+					A[r*c+i] = -A[r*c+i];
+			continue;
+		}
+		s += Ai[i]*Ai[i];
+		// v = A_i - a*e_i, a = -sign(A_ii)*|A_i|, stored in place of A_i
+		a = (Ai[i] > 0) ? -sqrt(s) : sqrt(s);
+		Ai[i] -= a;
+		b = s - a*(Ai[i] + a);                          // b = v^T*v/2 = |A_i|^2 - a*A_ii, A_ii = v_i + a
+		// A_r = A_r - (A_r*v)/b*v for the rows above
+		for (r = 0; r < i; r++) {
+			Ar = A + r*c;
+			for (j = lo, s = 0; j <= i; j++)
+				s += Ar[j]*Ai[j];
+			for (j = nlo; j < hi; j++)
+				s += Ar[j]*Ai[j];
+			if (s == 0)
+				continue;
+			s /= b;
+			for (j = lo; j <= i; j++)
+				Ar[j] -= s*Ai[j];
+			for (j = nlo; j < hi; j++)
+				Ar[j] -= s*Ai[j];
+		}
+		// row i folded to a*e_i, positive diagonal by column sign flip
+		for (j = lo; j < i; j++)
+			Ai[j] = 0;
+		for (j = nlo; j < hi; j++)
+			Ai[j] = 0;
+		Ai[i] = a;
+		if (a < 0)
+			for (r = 0; r <= i; r++)
+				A[r*c+i] = -A[r*c+i];
+	}
+
+	// S+ = upper-triangular part of the first n columns
+	for (i = 0, p = 0; i < n; i++)
+		for (j = i; j < n; j++, p++)
+			S[p] = A[i*c+j];
+}
+
+	// U-D factor Kalman filtering, P = U*D*U^T
+		/*
+			calculate U-D factorization P = U*D*U^T, where P is symmetric positive-semidefinite matrix
+			input:
+				double*      P --- pointer to an upper-triangular part of symmetric n x n matrix P
+				                   lined in one-dimensional array n(n+1)/2 x 1
+				const size_t n --- dimension
+			output:
+				double* U --- pointer to a unit upper-triangular factor U lined in one-dimensional array n(n+1)/2 x 1,
+				              with ones on the diagonal
+				double* D --- pointer to n x 1 diagonal factor D
+			note:
+				overwriting input (double* P = double* U) is allowed
+		*/
+void fsnav_linal_ud(double* U, double* D, double* P, const size_t n)
+{
+	size_t i, j, k, kj, ki, kk, k0;
+	double s;
+
+	for (j = n; j-- > 0; ) {
+		k0 = j*(2*n-j+1)/2; // U_jj index
+		// D_j = P_jj - sum(D_k*U_jk^2), k > j
+		for (k = j+1, kj = k0+1, s = P[k0]; k < n; k++, kj++)
+			s -= D[k]*U[kj]*U[kj];
+		D[j] = s;
+		// U_ij = (P_ij - sum(D_k*U_ik*U_jk))/D_j, i < j, k > j
+		for (i = 0, ki = j; i < j; ki += n-1-i, i++) {
+			for (k = j+1, kj = k0+1, kk = ki+1, s = P[ki]; k < n; k++, kj++, kk++)
+				s -= D[k]*U[kk]*U[kj];
+			U[ki] = (D[j] == 0) ? 0 : s/D[j];
+		}
+		U[k0] = 1;
+	}
+}
+
+		/*
+			perform U-D factor Kalman filter update phase (Bierman)
+			input:
+				double*      x     --- pointer to a current estimate of n x 1 state vector
+				double*      U     --- pointer to a unit upper-triangular factor of current covariance matrix
+				                       lined in one-dimensional array n(n+1)/2 x 1
+				double*      D     --- pointer to n x 1 diagonal factor of current covariance matrix
+				double       z     --- scalar measurement value
+				double*      h     --- pointer to a linear measurement model matrix, so that z = h*x + r
+				double       sigma --- measurement error a priori standard deviation, so that sigma = sqrt(E[r^2])
+				const size_t n     --- state vector size
+			output:
+				double* x --- pointer to an updated estimate of state vector (overwrites input)
+				double* U --- pointer to a unit upper-triangular factor of updated covariance matrix (overwrites input)
+				double* D --- pointer to n x 1 diagonal factor of updated covariance matrix (overwrites input)
+				double* K --- pointer to a Kalman gain
+			return value:
+				measurement residual before update
+			note:
+				same as fsnav_linal_kalman_update with U-D factors instead of Cholesky factor, no square roots involved
+		*/
+double fsnav_linal_ud_update(double* x, double* U, double* D, double* K, double z, double* h, double sigma, const size_t n)
+{
+	double a, a1, f, v, l, t;
+	size_t i, j, k;
+
+	// dz
+	for (i = 0; i < n; i++)
+		z -= h[i]*x[i];
+
+	// a0
+	a = sigma*sigma;
+
+	// U, D, column by column
+	for (j = 0; j < n; j++) {
+		// f = U^T*h, v = D*f
+		f = h[j];
+		for (i = 0, k = j; i < j; k += n-1-i, i++)
+			f += U[k]*h[i];
+		if (f == 0) {
+			K[j] = 0;
+			continue; // optimization for sparse matrices
+		}
+		v = D[j]*f;
+		// a, D
+		a1 = a + v*f;
+		l  = (a == 0) ? 0 : -f/a; // a = 0 (sigma = 0) only before the first nonzero f, with K = 0 so far
+		D[j] *= (a == 0) ? 0 : a/a1;
+		// U^+, K
+		for (i = 0, k = j; i < j; k += n-1-i, i++) {
+			t = U[k];
+			U[k] += K[i]*l;
+			K[i] += t*v;
+		}
+		K[j] = v;
+		a = a1;
+	}
+
+	// K, x
+	for (i = 0; i < n; i++) {
+		if (K[i] != 0) { // optimization for degenerate case
+			K[i] /= a;   // a = 0 (sigma = 0) allowed only for K[i] = 0
+			x[i] += K[i]*z;
+		}
+	}
+	return z;
+}
+
+		/*
+			perform U-D factor Kalman filter prediction phase (Thornton, modified weighted Gram-Schmidt)
+			x_i = F*x_i-1,   E[(x_i - F*x_i-1)*(x_i - F*x_i-1)^T] = G*diag(q2)*G^T
+			input:
+				double*      x  --- pointer to a current estimate of n x 1 state vector, or NULL to propagate the covariance only
+				double*      U  --- pointer to a unit upper-triangular factor of current covariance matrix
+				                    lined in one-dimensional array n(n+1)/2 x 1
+				double*      D  --- pointer to n x 1 diagonal factor of current covariance matrix
+				double*      F  --- pointer to a regular n x n state transition matrix, or NULL for identity,
+				                    zero elements are skipped, so block-sparse transitions cost in proportion to their nonzero blocks
+				double*      G  --- pointer to a regular n x m process noise input matrix, or NULL for G = [I; 0] (noise in the first m states)
+				double*      q2 --- pointer to m x 1 process noise variances, q2[i] >= 0
+				double*      W  --- pointer to a workspace of n x (n+m) elements
+				const size_t n  --- state vector size
+				const size_t m  --- process noise vector size
+			output:
+				double* x --- pointer to a predicted estimate of state vector (overwrites input)
+				double* U --- pointer to a unit upper-triangular factor of predicted covariance matrix (overwrites input)
+				double* D --- pointer to n x 1 diagonal factor of predicted covariance matrix (overwrites input)
+			note:
+				rows of W = [F*U | G] are orthogonalized from the last one up with weights diag(D, q2),
+				zeros at the ends of the rows are skipped as in fsnav_linal_kalman_predict_F
+		*/
+void fsnav_linal_ud_predict(double* x, double* U, double* D, double* F, double* G, double* q2, double* W, const size_t n, const size_t m)
+{
+	const size_t c = n+m; // workspace row length
+	size_t i, j, k, kj, ki, lo, hi, dhi, qlo;
+	double a, s, *Wi, *Wj;
+
+	// x = F*x, first row of the workspace as a temporary
+	if (x != NULL && F != NULL) {
+		for (i = 0; i < n; i++)
+			for (j = 0, W[i] = 0; j < n; j++)
+				if (F[i*n+j] != 0)
+					W[i] += F[i*n+j]*x[j];
+		for (i = 0; i < n; i++)
+			x[i] = W[i];
+	}
+
+	// W = [F*U | G]
+	for (i = 0; i < n*c; i++)
+		W[i] = 0;
+	for (i = 0; i < n; i++) {
+		Wi = W + i*c;
+		for (k = 0, kj = 0; k < n; k++) {               // U row k holds U_kj, j = k..n-1, U_kk = 1
+			a = (F == NULL) ? (i == k) : F[i*n+k];
+			if (a == 0) {
+				kj += n-k;
+				continue;                               // skip zero elements of F
+			}
+			Wi[k] += a;
+			for (j = k+1, kj++; j < n; j++, kj++)
+				Wi[j] += a*U[kj];
+		}
+		for (k = 0; k < m; k++)
+			Wi[n+k] = (G == NULL) ? (i == k) : G[i*m+k];
+	}
+
+	// modified weighted Gram-Schmidt, weights diag(D, q2), from the last row up,
+	// predicted D_j is kept on the diagonal of U until the old D is no longer needed
+	for (j = n; j-- > 0; ) {
+		Wj = W + j*c;
+		for (lo = 0; lo < c && Wj[lo] == 0; lo++);
+		for (hi = c; hi > lo && Wj[hi-1] == 0; hi--);
+		dhi = (hi < n) ? hi : n;
+		qlo = (lo > n) ? lo : n;
+		// D_j = sum(D~_k*W_jk^2)
+		for (k = lo, a = 0; k < dhi; k++)
+			a += D[k]*Wj[k]*Wj[k];
+		for (k = qlo; k < hi; k++)
+			a += q2[k-n]*Wj[k]*Wj[k];
+		U[j*(2*n-j+1)/2] = a;
+		// U_ij = sum(W_ik*D~_k*W_jk)/D_j, W_i = W_i - U_ij*W_j, i < j
+		for (i = 0, ki = j; i < j; ki += n-1-i, i++) {
+			Wi = W + i*c;
+			for (k = lo, s = 0; k < dhi; k++)
+				s += Wi[k]*D[k]*Wj[k];
+			for (k = qlo; k < hi; k++)
+				s += Wi[k]*q2[k-n]*Wj[k];
+			s = (a == 0) ? 0 : s/a;
+			U[ki] = s;
+			if (s != 0)
+				for (k = lo; k < hi; k++)
+					Wi[k] -= s*Wj[k];
+		}
+	}
+	for (j = 0, kj = 0; j < n; kj += n-j, j++) {
+		D[j] = U[kj];
+		U[kj] = 1;
+	}
+}
+
+	// Kalman filter bank: nf square root filters of the same dimension in structure-of-arrays layout,
+	// element p of filter k is stored at [p*nf + k], loops over filters are innermost and run in chunks,
+	// full chunks have constant trip count for the compiler to vectorize, so nf that is a multiple of the chunk works best
+#define FSNAV_LINAL_BANK_CHUNK 8                     // filters processed together in the innermost loops
+#define FSNAV_LINAL_LOG_2PI    1.8378770664093454836 // ln(2*pi)
+
+		/*
+			copy a filter into a Kalman filter bank
+			input:
+				double*      x  --- pointer to n x 1 state vector of the filter
+				double*      S  --- pointer to an upper-truangular part of the Cholesky factor of the filter covariance matrix
+				                    lined in one-dimensional array n(n+1)/2 x 1
+				const size_t n  --- state vector size
+				const size_t nf --- number of filters in the bank
+				const size_t k  --- filter index in the bank, 0..nf-1
+			output:
+				double* xb --- pointer to n x nf bank state vectors, k-th column is overwritten
+				double* Sb --- pointer to n(n+1)/2 x nf bank Cholesky factors, k-th column is overwritten
+			note:
+				x or S may be NULL to skip the corresponding copy
+		*/
+void fsnav_linal_bank_set(double* xb, double* Sb, double* x, double* S, const size_t n, const size_t nf, const size_t k)
+{
+	size_t p;
+
+	if (x != NULL)
+		for (p = 0; p < n; p++)
+			xb[p*nf + k] = x[p];
+	if (S != NULL)
+		for (p = 0; p < n*(n+1)/2; p++)
+			Sb[p*nf + k] = S[p];
+}
+
+		/*
+			copy a filter out of a Kalman filter bank
+			input:
+				double*      xb --- pointer to n x nf bank state vectors
+				double*      Sb --- pointer to n(n+1)/2 x nf bank Cholesky factors
+				const size_t n  --- state vector size
+				const size_t nf --- number of filters in the bank
+				const size_t k  --- filter index in the bank, 0..nf-1
+			output:
+				double* x --- pointer to n x 1 state vector of the filter
+				double* S --- pointer to an upper-truangular part of the Cholesky factor of the filter covariance matrix
+				              lined in one-dimensional array n(n+1)/2 x 1
+			note:
+				x or S may be NULL to skip the corresponding copy
+		*/
+void fsnav_linal_bank_get(double* x, double* S, double* xb, double* Sb, const size_t n, const size_t nf, const size_t k)
+{
+	size_t p;
+
+	if (x != NULL)
+		for (p = 0; p < n; p++)
+			x[p] = xb[p*nf + k];
+	if (S != NULL)
+		for (p = 0; p < n*(n+1)/2; p++)
+			S[p] = Sb[p*nf + k];
+}
+
+		// fsnav_linal_bank_update body for a chunk of cn filters, starting at x, S, K, L, z, h, sigma with stride nf
+#define FSNAV_LINAL_BANK_UPDATE_BODY(cn) {                                                         \
+	double f[FSNAV_LINAL_BANK_CHUNK], a[FSNAV_LINAL_BANK_CHUNK], g[FSNAV_LINAL_BANK_CHUNK];        \
+	double d[FSNAV_LINAL_BANK_CHUNK], sd[FSNAV_LINAL_BANK_CHUNK], e[FSNAV_LINAL_BANK_CHUNK];       \
+	double d1, sd1, *Sk, *Kj, *hj, *xi;                                                            \
+	size_t i, j, k, c;                                                                             \
+                                                                                                   \
+	/* d0, sqrt(d0), K = 0, dz = z - h*x */                                                        \
+	for (c = 0; c < cn; c++) {                                                                     \
+		d [c] = sigma[c]*sigma[c];                                                                 \
+		sd[c] = sqrt(d[c]);                                                                        \
+	}                                                                                              \
+	for (i = 0; i < n; i++)                                                                        \
+		for (c = 0, Kj = K + i*nf, hj = h + i*nf, xi = x + i*nf; c < cn; c++) {                    \
+			Kj[c] = 0;                                                                             \
+			z[c] -= hj[c]*xi[c];                                                                   \
+		}                                                                                          \
+                                                                                                   \
+	/* S */                                                                                        \
+	for (i = 0; i < n; i++) {                                                                      \
+		/* f = S^T*h */                                                                            \
+		for (c = 0, Sk = S + i*nf; c < cn; c++)                                                    \
+			f[c] = Sk[c]*h[c];                                                                     \
+		for (j = 1, k = i+n-1; j <= i; j++, k += n-j)                                              \
+			for (c = 0, Sk = S + k*nf, hj = h + j*nf; c < cn; c++)                                 \
+				f[c] += Sk[c]*hj[c];                                                               \
+		/* d, sqrt(d), f = 0 leaves the filter unchanged, d = 0 (sigma = 0) allowed only if e = 0 */ \
+		for (c = 0; c < cn; c++) {                                                                 \
+			d1  = d[c] + f[c]*f[c];                                                                \
+			sd1 = sqrt(d1);                                                                        \
+			a[c] = (f[c] == 0) ? 1 : sd[c]/sd1;                                                    \
+			g[c] = (sd[c] == 0) ? 1 : sd[c]*sd1;                                                   \
+			d [c] = d1;                                                                            \
+			sd[c] = sd1;                                                                           \
+		}                                                                                          \
+		/* S^+, e */                                                                               \
+		for (j = 0, k = i; j <= i; j++, k += n-j) {                                                \
+			Sk = S + k*nf;                                                                         \
+			Kj = K + j*nf;                                                                         \
+			for (c = 0; c < cn; c++)                                                               \
+				e[c] = Kj[c];                                                                      \
+			for (c = 0; c < cn; c++)                                                               \
+				Kj[c] = e[c] + Sk[c]*f[c];                                                         \
+			for (c = 0; c < cn; c++)                                                               \
+				Sk[c] = Sk[c]*a[c] - e[c]*f[c]/g[c];                                               \
+		}                                                                                          \
+	}                                                                                              \
+                                                                                                   \
+	/* K, x, likelihood */                                                                         \
+	for (c = 0; c < cn; c++)                                                                       \
+		g[c] = (d[c] == 0) ? 1 : d[c]; /* d = 0 (sigma = 0) allowed only for K = 0 */              \
+	for (i = 0; i < n; i++)                                                                        \
+		for (c = 0, Kj = K + i*nf, xi = x + i*nf; c < cn; c++) {                                   \
+			Kj[c] /= g[c];                                                                         \
+			xi[c] += Kj[c]*z[c];                                                                   \
+		}                                                                                          \
+	if (L != NULL)                                                                                 \
+		for (c = 0; c < cn; c++)                                                                   \
+			L[c] = -(z[c]*z[c]/d[c] + FSNAV_LINAL_LOG_2PI + log(d[c]))/2;                          \
+}
+static void fsnav_linal_bank_update_chunk(double* x, double* S, double* K, double* L, double* z, double* h, double* sigma, const size_t n, const size_t nf)                  FSNAV_LINAL_BANK_UPDATE_BODY(FSNAV_LINAL_BANK_CHUNK)
+static void fsnav_linal_bank_update_tail (double* x, double* S, double* K, double* L, double* z, double* h, double* sigma, const size_t n, const size_t nf, const size_t cn) FSNAV_LINAL_BANK_UPDATE_BODY(cn)
+
+		/*
+			perform square root Kalman filter update phase for all filters of a bank
+			input:
+				double*      x     --- pointer to n x nf current estimates of state vectors
+				double*      S     --- pointer to n(n+1)/2 x nf upper-truangular parts of the Cholesky factors of current covariance matrices
+				double*      z     --- pointer to nf x 1 scalar measurement values
+				double*      h     --- pointer to n x nf linear measurement model matrices, so that z_k = h_k*x_k + r_k
+				                       (a model common to all filters is repeated in each column)
+				double*      sigma --- pointer to nf x 1 measurement error a priori standard deviations, sigma_k = sqrt(E[r_k^2])
+				const size_t n     --- state vector size
+				const size_t nf    --- number of filters in the bank
+			output:
+				double* x --- pointer to updated estimates of state vectors (overwrites input)
+				double* S --- pointer to upper-truangular parts of the Cholesky factors of updated covariance matrices (overwrites input)
+				double* K --- pointer to n x nf Kalman gains
+				double* z --- pointer to nf x 1 measurement residuals before update, z_k - h_k*x_k (overwrites input)
+				double* L --- pointer to nf x 1 measurement log-likelihoods 
+				              ln N(z_k - h_k*x_k; 0, d_k) = -((z_k - h_k*x_k)^2/d_k + ln(2*pi*d_k))/2, d_k = h_k*S_k*S_k^T*h_k^T + sigma_k^2,
+				              for model probabilities in multiple model mixing, may be NULL
+			note:
+				gives the same result for each filter as fsnav_linal_kalman_update_gated with the gate wide open;
+				sigma_k = 0 is allowed as in fsnav_linal_kalman_update, but the likelihood requires d_k > 0
+		*/
+void fsnav_linal_bank_update(double* x, double* S, double* K, double* L, double* z, double* h, double* sigma, const size_t n, const size_t nf)
+{
+	size_t c0;
+
+	for (c0 = 0; c0 + FSNAV_LINAL_BANK_CHUNK <= nf; c0 += FSNAV_LINAL_BANK_CHUNK)
+		fsnav_linal_bank_update_chunk(x + c0, S + c0, K + c0, (L == NULL) ? NULL : L + c0, z + c0, h + c0, sigma + c0, n, nf);
+	if (c0 < nf)
+		fsnav_linal_bank_update_tail (x + c0, S + c0, K + c0, (L == NULL) ? NULL : L + c0, z + c0, h + c0, sigma + c0, n, nf, nf - c0);
+}
+
+		// fsnav_linal_bank_predict_I_diag body for a chunk of cn filters, starting at S, q2 with stride nf
+#define FSNAV_LINAL_BANK_PREDICT_I_DIAG_BODY(cn) {                                \
+	double s[FSNAV_LINAL_BANK_CHUNK], t[FSNAV_LINAL_BANK_CHUNK];                  \
+	double *Sk, *Sp, *Sq;                                                         \
+	size_t i, j, k, k0, p, q, p0, r, c;                                           \
+                                                                                  \
+	/* P = S*S^T, in place row by row as in fsnav_linal_uuT */                    \
+	for (i = 0, k = 0; i < n; i++) {                                              \
+		for (j = i; j < n; j++, k++) {                                            \
+			fsnav_linal_u_ij2k(&p, j, j, n);                                      \
+			for (c = 0, Sk = S + k*nf, Sp = S + p*nf; c < cn; c++)                \
+				s[c] = Sk[c]*Sp[c];                                               \
+			for (q = k+1, p++, r = j+1; r < n; q++, p++, r++)                     \
+				for (c = 0, Sq = S + q*nf, Sp = S + p*nf; c < cn; c++)            \
+					s[c] += Sq[c]*Sp[c];                                          \
+			for (c = 0, Sk = S + k*nf; c < cn; c++)                               \
+				Sk[c] = s[c];                                                     \
+		}                                                                         \
+	}                                                                             \
+                                                                                  \
+	/* P = P + Q, Q = [diag(q2) 0; 0 0] */                                        \
+	for (i = 0; i < m; i++)                                                       \
+		for (c = 0, Sk = S + i*(2*n-i+1)/2*nf, Sq = q2 + i*nf; c < cn; c++)       \
+			Sk[c] += Sq[c];                                                       \
+                                                                                  \
+	/* S = chol(P), in place from the bottom row up as in fsnav_linal_chol */     \
+	for (j = 0, k0 = n*(n+1)/2 - 1; j < n; k0 -= j+2, j++) {                      \
+		p0 = k0+j;                                                                \
+		for (c = 0; c < cn; c++)                                                  \
+			s[c] = 0;                                                             \
+		for (p = k0+1; p <= p0; p++)                                              \
+			for (c = 0, Sp = S + p*nf; c < cn; c++)                               \
+				s[c] += Sp[c]*Sp[c];                                              \
+		for (c = 0, Sk = S + k0*nf; c < cn; c++) {                                \
+			Sk[c] = sqrt(Sk[c] - s[c]);                                           \
+			t[c] = (Sk[c] == 0) ? 1 : Sk[c]; /* zero pivot gives zero column */   \
+		}                                                                         \
+		for (i = j+1, k = k0-j-1; i < n; k -= i+1, i++) {                         \
+			for (c = 0; c < cn; c++)                                              \
+				s[c] = 0;                                                         \
+			for (p = k0+1, q = k+1; p <= p0; p++, q++)                            \
+				for (c = 0, Sp = S + p*nf, Sq = S + q*nf; c < cn; c++)            \
+					s[c] += Sp[c]*Sq[c];                                          \
+			for (c = 0, Sk = S + k*nf, Sp = S + k0*nf; c < cn; c++)               \
+				Sk[c] = (Sp[c] == 0) ? 0 : (Sk[c] - s[c])/t[c];                   \
+		}                                                                         \
+	}                                                                             \
+}
+static void fsnav_linal_bank_predict_I_diag_chunk(double* S, double* q2, const size_t n, const size_t m, const size_t nf)                  FSNAV_LINAL_BANK_PREDICT_I_DIAG_BODY(FSNAV_LINAL_BANK_CHUNK)
+static void fsnav_linal_bank_predict_I_diag_tail (double* S, double* q2, const size_t n, const size_t m, const size_t nf, const size_t cn) FSNAV_LINAL_BANK_PREDICT_I_DIAG_BODY(cn)
+
+		/*
+			perform square root Kalman filter prediction phase for all filters of a bank: identity state transition, diagonal process noise covariance
+			    [q_1k^2  0    0 0]  
+			    [  .     .    . .]
+			Q = [  0   q_mk^2 0 0] = E[(x_ik - x_i-1k)*(x_ik - x_i-1k)^T] for the k-th filter
+			    [  0     0    0 0]
+			    [  0     0    0 0]
+			input:
+				double*      S  --- pointer to n(n+1)/2 x nf upper-truangular parts of the Cholesky factors of current covariance matrices
+				double*      q2 --- pointer to m x nf nonzero process noise variances, q2[i*nf + k] = q_ik^2 >= 0
+				const size_t n  --- state vector size
+				const size_t m  --- nonzero process noise vector size
+				const size_t nf --- number of filters in the bank
+			output:
+				double* S --- pointer to upper-truangular parts of the Cholesky factors of predicted covariance matrices (overwrites input)
+			note:
+				gives the same result for each filter as fsnav_linal_kalman_predict_I_diag
+		*/
+void fsnav_linal_bank_predict_I_diag(double* S, double* q2, const size_t n, const size_t m, const size_t nf)
+{
+	size_t c0;
+
+	for (c0 = 0; c0 + FSNAV_LINAL_BANK_CHUNK <= nf; c0 += FSNAV_LINAL_BANK_CHUNK)
+		fsnav_linal_bank_predict_I_diag_chunk(S + c0, q2 + c0, n, m, nf);
+	if (c0 < nf)
+		fsnav_linal_bank_predict_I_diag_tail (S + c0, q2 + c0, n, m, nf, nf - c0);
+}
+
+		/*
+			update model probabilities of a Kalman filter bank with measurement likelihoods (multiple model mixing)
+			input:
+				double*      mu --- pointer to nf x 1 prior model probabilities
+				double*      L  --- pointer to nf x 1 measurement log-likelihoods, as given by fsnav_linal_bank_update
+				const size_t nf --- number of filters in the bank
+			output:
+				double* mu --- pointer to nf x 1 posterior model probabilities mu_k*exp(L_k)/sum(mu_j*exp(L_j)) (overwrites input)
+			return value:
+				log-likelihood of the measurement for the whole bank, ln sum(mu_j*exp(L_j)),
+				or -HUGE_VAL with unchanged probabilities if all the products vanish
+			note:
+				likelihoods are scaled by the largest one before exponentiation, so that vanishing values do not underflow to 0/0
+		*/
+double fsnav_linal_bank_weights(double* mu, double* L, const size_t nf)
+{
+	double Lmax, s;
+	size_t k;
+
+	for (k = 0, Lmax = -HUGE_VAL; k < nf; k++)
+		if (mu[k] > 0 && L[k] > Lmax)
+			Lmax = L[k];
+	if (Lmax == -HUGE_VAL)
+		return -HUGE_VAL;
+	for (k = 0, s = 0; k < nf; k++)
+		s += (mu[k] > 0) ? mu[k]*exp(L[k] - Lmax) : 0;
+	for (k = 0; k < nf; k++)
+		mu[k] = (mu[k] > 0) ? mu[k]*exp(L[k] - Lmax)/s : 0;
+	return Lmax + log(s);
+}
+
+	/*
+		turn on/off automatic shift assignment (load balancing) for scheduled plugins
+		input:
+			char on --- 1 to turn on, 0 to turn off
+		return value:
+			1 always
+		note:
+			when on, the core measures execution time of each plugin with cycle > 1 over its first runs with a monotonic clock,
+			averaging FSNAV_BALANCE_SAMPLES nonzero measurements (or whatever has been caught in FSNAV_BALANCE_RUNS runs),
+			and assigns shifts so that the maximum per-tick load over the hyperperiod is minimized (greedy, longest first);
+			equal loads are resolved towards ticks with fewer plugins, then towards the shift given by schedule_plugin/reschedule_plugin,
+			which is also kept for all plugins when no cost has been measured at all; ticks of all scheduled plugins are reset together;
+			rebalancing happens at the beginning of a step after plugins are added, removed, rescheduled, suspended or resumed,
+			and once again when all scheduled plugins have been measured
+	*/
+char fsnav_balance_plugins(char on)
+{
+	fsnav->core.balance = on ? 1 : 0;
+	fsnav->core.balance_pending = fsnav->core.balance;
+	fsnav->core.balance_clock = -1;
+
+	return 1;
+}
+
+	/*
+		read monotonic clock for execution time measurements, service function
+		return value:
+			time in seconds from an arbitrary origin
+		note:
+			falls back to the calendar clock of C11 and then to processor clock if no monotonic clock is available, 
+			the latter having a resolution far too coarse for most plugins, whose zero measurements are then ignored
+	*/
+double fsnav_balance_time(void)
+{
+#if defined(CLOCK_MONOTONIC)
+	struct timespec t;
+	if (clock_gettime(CLOCK_MONOTONIC, &t) == 0)
+		return (double)t.tv_sec + 1e-9*(double)t.tv_nsec;
+#elif defined(TIME_UTC)
+	struct timespec t;
+	if (timespec_get(&t, TIME_UTC) == TIME_UTC)
+		return (double)t.tv_sec + 1e-9*(double)t.tv_nsec;
+#endif
+	return (double)clock()/CLOCKS_PER_SEC;
+}
+
+	/*
+		start execution time measurement for an execution list entry, if it is a scheduled plugin that has not been measured enough
+		input:
+			size_t i --- execution list entry index
+	*/
+void fsnav_balance_begin(size_t i)
+{
+	fsnav_plugin* entry = fsnav->core.plugins + i;
+
+	fsnav->core.balance_clock = -1;
+	if (entry->cycle > 1 && !FSNAV_BALANCE_MEASURED(entry))
+		fsnav->core.balance_clock = fsnav_balance_time();
+}
+
+	/*
+		finish execution time measurement for an execution list entry, if started
+		input:
+			size_t i --- execution list entry index
+		note:
+			zero measurements, which occur when a plugin is faster than the clock resolution, are counted as runs only
+	*/
+void fsnav_balance_end(size_t i)
+{
+	fsnav_plugin* entry;
+	double dt;
+
+	if (fsnav->core.balance_clock < 0 || i >= fsnav->core.plugin_count)
+		return;
+
+	entry = fsnav->core.plugins + i;
+	dt = fsnav_balance_time() - fsnav->core.balance_clock;
+	fsnav->core.balance_clock = -1;
+
+	// running average over nonzero measurements
+	entry->cost_runs++;
+	if (dt > 0) {
+		entry->cost_count++;
+		entry->cost += (dt - entry->cost)/entry->cost_count;
+	}
+
+	// rebalance with measured costs once all scheduled plugins are measured
+	if (FSNAV_BALANCE_MEASURED(entry) && fsnav->core.balance_pending == 0)
+		fsnav->core.balance_pending = 2;
+}
+
+	/*
+		greatest common divisor, service function for hyperperiod calculation
+	*/
+size_t fsnav_balance_gcd(size_t a, size_t b)
+{
+	size_t r;
+
+	while (b) {
+		r = a%b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
+	/*
+		rebalance scheduled plugins if due, to be called at the beginning of a step in regular operation mode
+		note:
+			plugins with cycle <= 1 are not balanced, plugins that have not been measured yet 
+			are assumed to cost as much as an average measured plugin;
+			if none of the scheduled plugins has a nonzero cost, the shifts are left as they are
+	*/
+void fsnav_balance_step(void)
+{
+	const size_t tick_limit = FSNAV_BALANCE_TICKS; // hyperperiod limit
+
+	size_t  i, j, k, m, n, H, best_shift, busy_max, best_busy;
+	size_t* order;
+	size_t* busy;
+	double* load;
+	double  cost_avg, cost_sum, worst, best_worst, c, eps;
+	size_t  measured;
+	fsnav_plugin* entry;
+
+	if (!fsnav->core.balance || fsnav->core.balance_pending == 0)
+		return;
+
+	// after a preliminary rebalance, wait for all scheduled plugins to be measured
+	if (fsnav->core.balance_pending == 2)
+		for (i = 0; i < fsnav->core.plugin_count; i++)
+			if (fsnav->core.plugins[i].cycle > 1 && !FSNAV_BALANCE_MEASURED(fsnav->core.plugins + i))
+				return;
+
+	// scheduled plugins, hyperperiod and average cost
+	n = 0;
+	H = 1;
+	cost_sum = 0;
+	measured = 0;
+	for (i = 0; i < fsnav->core.plugin_count; i++) {
+		entry = fsnav->core.plugins + i;
+		if (entry->cycle <= 1)
+			continue;
+		n++;
+		H = H/fsnav_balance_gcd(H, (size_t)entry->cycle)*(size_t)entry->cycle;
+		if (H > tick_limit)
+			H = tick_limit;
+		if (entry->cost_count > 0) {
+			cost_sum += entry->cost;
+			measured++;
+		}
+	}
+	fsnav->core.balance_pending = 0;
+	for (i = 0; i < fsnav->core.plugin_count; i++)
+		if (fsnav->core.plugins[i].cycle > 1 && !FSNAV_BALANCE_MEASURED(fsnav->core.plugins + i))
+			fsnav->core.balance_pending = 2;
+	if (n == 0 || (measured == 0 && fsnav->core.balance_pending == 0)) // nothing to balance, or no measurable cost
+		return;
+	cost_avg = (measured > 0) ? cost_sum/measured : 1;
+
+	order = (size_t*)malloc(n*sizeof(size_t));
+	load  = (double*)calloc(H, sizeof(double));
+	busy  = (size_t*)calloc(H, sizeof(size_t));
+	if (order == NULL || load == NULL || busy == NULL) {
+		free(order);
+		free(load);
+		free(busy);
+		return;
+	}
+
+	// sort scheduled plugins by cost, longest first
+	for (i = 0, m = 0; i < fsnav->core.plugin_count; i++) {
+		if (fsnav->core.plugins[i].cycle <= 1)
+			continue;
+		c = (fsnav->core.plugins[i].cost_count > 0) ? fsnav->core.plugins[i].cost : cost_avg;
+		for (j = m; j > 0; j--) {
+			entry = fsnav->core.plugins + order[j-1];
+			if (((entry->cost_count > 0) ? entry->cost : cost_avg) >= c)
+				break;
+			order[j] = order[j-1];
+		}
+		order[j] = i;
+		m++;
+	}
+
+	// assign each plugin the shift that minimizes the maximum load among the ticks it runs at,
+	// resolving loads that differ by less than a measurable margin towards fewer plugins per tick and then towards the given shift
+	for (k = 0; k < n; k++) {
+		entry = fsnav->core.plugins + order[k];
+		c = (entry->cost_count > 0) ? entry->cost : cost_avg;
+		eps = c*FSNAV_BALANCE_MARGIN;
+		best_shift = (size_t)entry->shift;
+		best_worst = -1;
+		best_busy  = 0;
+		for (m = 0; m <= (size_t)entry->cycle && m <= H; m++) {
+			// the given shift goes first to win ties
+			if (m == 0)
+				i = (size_t)entry->shift;
+			else if (m - 1 == (size_t)entry->shift)
+				continue;
+			else
+				i = m - 1;
+			if (i >= H)
+				continue;
+			worst    = 0;
+			busy_max = 0;
+			for (j = i; j < H; j += (size_t)entry->cycle) {
+				if (load[j] > worst)
+					worst = load[j];
+				if (busy[j] > busy_max)
+					busy_max = busy[j];
+			}
+			if (best_worst < 0 || worst < best_worst - eps || (worst <= best_worst + eps && busy_max < best_busy)) {
+				best_worst = worst;
+				best_busy  = busy_max;
+				best_shift = i;
+			}
+		}
+		if (best_shift < H)
+			for (j = best_shift; j < H; j += (size_t)entry->cycle) {
+				load[j] += c;
+				busy[j]++;
+			}
+		entry->shift = (int)best_shift;
+	}
+
+	// reset ticks together, so that shifts are counted from the same step
+	for (i = 0; i < fsnav->core.plugin_count; i++)
+		if (fsnav->core.plugins[i].cycle > 1)
+			fsnav->core.plugins[i].tick = 0;
+
+	free(order);
+	free(load);
+	free(busy);
+}
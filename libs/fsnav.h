@@ -7,7 +7,7 @@
 #include <stddef.h>
 
 // FSNAV core declarations
-#define FSNAV_BUS_VERSION 12 // current bus version
+#define FSNAV_BUS_VERSION 20 // current bus version
 
 
 
@@ -28,6 +28,10 @@ typedef struct {
 
 
 // navigation solution structure
+	// attitude representations (bit masks), derived from each other on demand by fsnav_sol_get_q, fsnav_sol_get_L, fsnav_sol_get_rpy
+#define FSNAV_SOL_Q   0x01 // attitude quaternion
+#define FSNAV_SOL_L   0x02 // attitude matrix
+#define FSNAV_SOL_RPY 0x04 // attitude angles
 typedef struct {
 	double  x[3];          // cartesian coordinates, meters
 	char    x_valid;       // validity flag (0/1), or a number of valid measurements used
@@ -48,6 +52,8 @@ typedef struct {
 						   
 	double  rpy[3];        // attitude angles relative to local-level geodetic cartesian frame: roll (rad), pitch (rad), yaw (rad)
 	char    rpy_valid;     // validity flag (0/1), or a number of valid measurements used
+	char    att_fresh;     // attitude representations up to date (FSNAV_SOL_Q | FSNAV_SOL_L | FSNAV_SOL_RPY), the others are stale until derived by accessors
+	char    att_fast;      // flag (0/1) to derive attitude angles with polynomial approximations (fsnav_linal_mat2rpy_fast)
 						   
 	double  dt;            // clock bias
 	char    dt_valid;      // validity flag (0/1), or a number of valid measurements used
@@ -74,6 +80,19 @@ typedef struct {
 		fg;      // Earth normal gravity flattening
 } fsnav_imu_const;
 
+	// geodetic terms at the inertial solution position, shared by plugins, derived from fsnav_imu.sol.llh on demand by fsnav_imu_get_geo
+typedef struct {
+	double lat;          // latitude the terms are derived at, rad
+	double h;            // height the curvature radii are adjusted for, meters
+	double sphi, cphi;   // sine and cosine of latitude
+	double s2phi, c2phi; // sine and cosine of twofold latitude
+	double Re, Rn;       // east-to-west (prime vertical) and south-to-north (meridian) curvature radii, meters
+	double Re_h, Rn_h;   // curvature radii adjusted for height, meters
+	double u[3];         // Earth rotation rate projections to the local-level frame, rad/s
+	double tol;          // latitude terms are derived again when latitude moves by more than tol meters along the meridian, 0 for any change, given in cfg ("geodetic_tolerance = ...")
+	char   valid;        // validity flag (0/1), dropped to force derivation on the next access
+} fsnav_geo;
+
 	// inertial measurement unit
 typedef struct {
 	char*  cfg;       // pointer to IMU configuration substring
@@ -100,8 +119,30 @@ typedef struct {
 	char   g_valid;   // validity flag (0/1), or a number of valid components
 
 	fsnav_sol sol;     // inertial solution
+
+	fsnav_geo geo;     // geodetic terms at sol.llh, derived on demand by fsnav_imu_get_geo
 } fsnav_imu;
 
+	// buffered inertial sample, exchanged with block input/output plugins
+typedef struct {
+	double t;         // measurement update time
+	char   t_valid;   // validity flag (0/1), when not set the time is not loaded to the bus by input plugins
+
+	double w[3];      // gyroscope measurements
+	char   w_valid;   // validity flag (0/1), or a number of valid components
+
+	double f[3];      // accelerometer measurements
+	char   f_valid;   // validity flag (0/1), or a number of valid components
+
+	double Tw[3];     // temperature of gyroscopes
+	char   Tw_valid;  // validity flag (0/1), or a number of valid components
+
+	double Tf[3];     // temperature of accelerometers
+	char   Tf_valid;  // validity flag (0/1), or a number of valid components
+
+	fsnav_sol sol;    // inertial solution, stored by output plugins (without metrics)
+} fsnav_imu_sample;
+
 
 
 
@@ -358,14 +399,71 @@ typedef struct {
 
 
 // BUS
+	// load balancing of scheduled plugins
+#define FSNAV_BALANCE_SAMPLES 16   // number of nonzero execution time measurements per plugin
+#define FSNAV_BALANCE_RUNS    64   // number of runs per plugin to stop measuring after, even if some measurements were zero
+#define FSNAV_BALANCE_TICKS   4096 // hyperperiod limit, in ticks
+#define FSNAV_BALANCE_MARGIN  0.05 // load differences below this fraction of the placed plugin cost are not considered measurable
+
+	// bus topics, signalled by producers to trigger subscribed plugins (bit masks)
+#define FSNAV_TOPIC_IMU       0x01 // new inertial measurements
+#define FSNAV_TOPIC_GNSS      0x02 // new gnss epoch
+#define FSNAV_TOPIC_AIR       0x04 // new air data
+#define FSNAV_TOPIC_REF       0x08 // new reference data
+#define FSNAV_TOPIC_ALIGNMENT 0x10 // initial alignment finished
+#define FSNAV_TOPIC_ATTITUDE  0x20 // attitude updated at a reduced rate
+
+	// block plugin roles
+#define FSNAV_BLOCK_INPUT  1 // fills a block of samples, loaded to fsnav->imu one per step at the plugin position
+#define FSNAV_BLOCK_OUTPUT 2 // emits a block of samples, stored from fsnav->imu one per step at the plugin position
+
 	// scheduled plugin structure
 typedef struct {
-	void(*func)(void); // pointer to plugin function to execute
-	int cycle;         // tick cycle (period) to execute
-	int shift;         // tick within a cycle to execute at (shift)
-	int tick;          // current tick
+	void(*func)     (void);  // pointer to single-function plugin to execute in every mode, NULL for plugins with separate callbacks
+	void(*init)     (void*); // pointer to init callback, called in init mode (fsnav->mode == 0)
+	void(*step)     (void*); // pointer to step callback, called in regular operation mode (fsnav->mode > 0), identifies the plugin in scheduling functions
+	void(*terminate)(void*); // pointer to termination callback, called in termination mode (fsnav->mode < 0)
+	void* context;           // optional context pointer passed to callbacks
+	size_t(*block)(void*, fsnav_imu_sample*, size_t); // pointer to block callback for input/output plugins (see FSNAV_BLOCK_*), NULL otherwise, identifies the plugin in scheduling functions
+	char              block_role;   // FSNAV_BLOCK_INPUT or FSNAV_BLOCK_OUTPUT for block plugins, 0 otherwise
+	fsnav_imu_sample* samples;      // block buffer
+	size_t            sample_size;  // block buffer capacity
+	size_t            sample_count; // number of samples in block buffer
+	size_t            sample_next;  // index of the next sample to be loaded to the bus (input plugins)
+	unsigned int topics;         // subscribed topics (FSNAV_TOPIC_*), 0 to be called on every scheduled tick
+	unsigned int topics_pending; // topics signalled since the last call
+	char         retired;        // retirement flag, retired plugins are not called and are removed at the end of a step
+	double cost;             // average execution time estimate, seconds, measured when load balancing is on
+	int    cost_count;       // number of nonzero execution time measurements taken
+	int    cost_runs;        // number of execution time measurements taken, including zero ones
+	int cycle;               // tick cycle (period) to execute
+	int shift;               // tick within a cycle to execute at (shift)
+	int tick;                // current tick
 } fsnav_plugin;
 
+	// check if a scheduled plugin has been measured enough for load balancing
+#define FSNAV_BALANCE_MEASURED(p) ((p)->cost_count >= FSNAV_BALANCE_SAMPLES || (p)->cost_runs >= FSNAV_BALANCE_RUNS)
+
+	// check if a plugin is due in regular operation mode: the scheduled tick has come and, if subscribed, a topic was signalled
+#define FSNAV_PLUGIN_DUE(p) ((p)->cycle > 0 && (p)->tick == (p)->shift && ((p)->topics == 0 || (p)->topics_pending != 0))
+
+	// increment accumulator, integrated by producers at every step and read and reset by a consumer plugin on its own tick
+typedef struct {
+	void(*owner)(void); // consumer plugin function (step callback for plugins with separate callbacks) the accumulator is attached to
+	double  t0;         // time of the last reset, as per IMU clock
+	double  T;          // time interval accumulated since the last reset, seconds
+	size_t  n;          // number of samples accumulated since the last reset
+	double  a[3];       // angular increment, integral of angular rate
+	double  v[3];       // velocity increment, integral of specific force
+	double  c[3];       // coning compensation, rotation vector of instrumental frame over the interval is a + c
+	double  s[3];       // sculling compensation, velocity increment in instrumental frame at t0 is v + (a x v)/2 + s
+	char    w_valid;    // validity flag (0/1), 1 if angular rate was valid for all samples since the last reset
+	char    f_valid;    // validity flag (0/1), 1 if specific force was valid for all samples since the last reset
+	double  da[3];      // the last angular increment, kept over resets for coning compensation
+	double* x;          // integrals of application-specific quantities
+	size_t  x_count;    // number of application-specific quantities
+} fsnav_accum;
+
 	// core structure
 typedef struct {
 	fsnav_plugin* plugins;           // plugin array pointer
@@ -373,6 +471,15 @@ typedef struct {
 	size_t       current_plugin_id; // current plugin in plugin execution list
 	size_t       exit_plugin_id;    // index of a plugin that initiated termination, or UINT_MAX by default
 	char         host_termination;  // identifier of termination being called by host
+	unsigned long revision;         // execution list revision, incremented whenever plugins are added, removed or replaced
+	size_t       block_size;        // block buffer capacity for block plugins
+	char         balance;           // load balancing of scheduled plugins on/off (1/0)
+	char         balance_pending;   // rebalancing is due in the next step (1), or after all scheduled plugins are measured (2), or not due (0)
+	double       balance_clock;     // execution time measurement start
+	unsigned int current_topics;    // topics signalled for the plugin being called, 0 for plugins without subscription
+	size_t       retired_count;     // number of retired plugins to be removed at the end of a step
+	fsnav_accum** accums;           // increment accumulators, allocated one by one to keep pointers held by consumers valid
+	size_t       accum_count;       // number of increment accumulators
 } fsnav_core;
 
 	// bus data to be used in host application
@@ -383,17 +490,30 @@ typedef struct {
 	// main functions to be used in host app
 		// basic
 	char(*add_plugin)(void(*func)(void));                                 // add plugin to the plugin execution list,                             input: pointer to plugin function,                       output: OK/not OK (1/0)
+	char(*add_plugin_ext)(void(*init)(void*), void(*step)(void*), void(*terminate)(void*), void* context); // add plugin with separate callbacks, input: pointers to callbacks (NULL to skip) and context, output: OK/not OK (1/0)
+	char(*add_plugin_block)(void(*init)(void*), size_t(*block)(void*, fsnav_imu_sample*, size_t), void(*terminate)(void*), void* context, char role); // add block input/output plugin, input: callbacks, context, role (FSNAV_BLOCK_*), output: OK/not OK (1/0)
 	char(*init)      (char* cfg        );                                 // initialize the bus, except for core,                                 input: configuration string (see description),           output: OK/not OK (1/0)
 	char(*step)      (void             );                                 // step through the plugin execution list,                                                                                       output: OK/not OK (1/0)
+	char(*step_n)    (size_t n         );                                 // step through the plugin execution list n times, buffering block plugins, input: number of steps,                             output: OK/not OK (1/0)
 	char(*terminate) (void             );                                 // terminate operation,                                                                                                          output: OK/not OK (1/0)
 		
 		// advanced scheduling
 	char(*remove_plugin)    (void(*func   )(void)                      ); // remove all instances of a plugin from the plugin execution list,     input: pointer to plugin function to be removed,         output: OK/not OK (1/0)
 	char(*replace_plugin)   (void(*oldfunc)(void), void(*newfunc)(void)); // replace all instances of the plugin by another one,                  input: pointers to old and new plugin functions,         output: OK/not OK (1/0)
 	char(*schedule_plugin)  (void(*func   )(void), int cycle, int shift); // add scheduled plugin to the plugin execution list,                   input: pointer to plugin function, cycle, shift,         output: OK/not OK (1/0)
+	char(*schedule_plugin_ext)(void(*init)(void*), void(*step)(void*), void(*terminate)(void*), void* context, int cycle, int shift); // add scheduled plugin with separate callbacks, input: callbacks, context, cycle, shift, output: OK/not OK (1/0)
 	char(*reschedule_plugin)(void(*func   )(void), int cycle, int shift); // reschedule all instances of the plugin in the plugin execution list, input: pointer to plugin function, new cycle, new shift, output: OK/not OK (1/0)
 	char(*suspend_plugin)   (void(*func   )(void)                      ); // suspend all instances of the plugin in the plugin execution list,    input: pointer to plugin function,                       output: OK/not OK (1/0)
 	char(*resume_plugin)    (void(*func   )(void)                      ); // resume all instances of the plugin in the plugin execution list,     input: pointer to plugin function,                       output: OK/not OK (1/0)
+	char(*balance_plugins)  (char on                                   ); // turn on/off automatic shift assignment for scheduled plugins,       input: 1/0 for on/off,                                   output: OK/not OK (1/0)
+	char(*subscribe_plugin) (void(*func   )(void), unsigned int topics ); // call all instances of the plugin only when subscribed topics are signalled, input: pointer to plugin function, topics (0 to unsubscribe), output: OK/not OK (1/0)
+	void(*signal)           (unsigned int topics                       ); // signal topics to subscribed plugins,                                input: topics (FSNAV_TOPIC_*)
+	char(*retire_plugin)    (void(*func   )(void)                      ); // retire all instances of the plugin, removing them at the end of the step, input: pointer to plugin function,       output: OK/not OK (1/0)
+
+		// increment accumulators between plugin rates
+	fsnav_accum*(*attach_accum)(void(*func)(void), size_t x_count                          ); // attach an increment accumulator to a consumer plugin, input: pointer to plugin function, number of application-specific quantities, output: pointer to the accumulator, NULL if failed
+	void        (*accumulate)  (double dt, double* w, double* f, double* x, size_t x_count); // integrate a sample into all increment accumulators,   input: time step, angular rate, specific force (NULL if invalid), application-specific quantities and their number
+	void        (*reset_accum) (fsnav_accum* acc                                           ); // reset an increment accumulator after reading,         input: pointer to the accumulator
 	
 	fsnav_core       core;            // core instances
 
@@ -420,6 +540,78 @@ typedef struct {
 
 extern fsnav_struct* fsnav;
 
+// core plugins
+void fsnav_accumulate_imu(void); // integrate fsnav->imu->w and fsnav->imu->f into all increment accumulators, to be placed after sensor preprocessing plugins
+
+
+
+
+
+// statically compiled pipelines
+char fsnav_step_from        (size_t first                                  ); // step through the plugin execution list starting from a given entry,                         output: OK/not OK (1/0)
+size_t fsnav_step_static_map(void(**plugins)(void), const size_t n, size_t* map); // map a plugin sequence onto the plugin execution list,                            output: index of the first entry not covered by the sequence
+char fsnav_step_entry_end   (size_t i                                      ); // advance entry tick and track termination,                                                    output: 1 if the step is to be ended, 0 otherwise
+char fsnav_step_end         (void                                          ); // finalize a step through the plugin execution list,                                          output: OK/not OK (1/0)
+void fsnav_step_block_entry (size_t i                                      ); // load/store a sample for a block plugin entry in regular operation mode
+char fsnav_step_n_ext       (size_t n, char(*step)(void)                   ); // call a step function n times with block buffers of n samples,                               output: OK/not OK (1/0)
+void fsnav_balance_step     (void                                          ); // rebalance scheduled plugins if due, to be called at the beginning of a step in regular operation mode
+void fsnav_balance_begin    (size_t i                                      ); // start execution time measurement for an execution list entry, if needed
+void fsnav_balance_end      (size_t i                                      ); // finish execution time measurement for an execution list entry, if started
+
+#define FSNAV_STEP_STATIC_ABSENT ((size_t)(-1)) // mapping of a sequence plugin that is absent from the execution list (removed or retired)
+
+	/*
+		direct call of the k-th plugin within a host step function generated from a fixed plugin sequence, 
+		to be used in regular operation mode after the sequence was mapped by fsnav_step_static_map
+		k                --- size_t variable holding the index within the sequence, incremented after the entry
+		map              --- execution list indices of the sequence plugins, as filled by fsnav_step_static_map
+		checked_revision --- core.revision value the sequence was mapped at
+		call             --- direct call expression, e.g. plugin() or plugin(context), 
+		                     fsnav_step_static_i holds the execution list index of the entry
+		falls back to dynamic dispatch via fsnav_step_from if the plugin changes operation mode, 
+		requests termination or modifies the execution list
+	*/
+#define FSNAV_STEP_STATIC_PLUGIN(k, map, checked_revision, call) {                              \
+		size_t fsnav_step_static_i = map[k];                                                    \
+		fsnav_plugin* fsnav_step_static_p;                                                      \
+		if (fsnav_step_static_i != FSNAV_STEP_STATIC_ABSENT) {                                  \
+			fsnav->core.current_plugin_id = fsnav_step_static_i;                                \
+			fsnav_step_static_p = fsnav->core.plugins + fsnav_step_static_i;                    \
+			if (FSNAV_PLUGIN_DUE(fsnav_step_static_p)) {                                        \
+				fsnav->core.current_topics = fsnav_step_static_p->topics_pending;               \
+				fsnav_step_static_p->topics_pending = 0;                                        \
+				if (fsnav->core.balance)                                                        \
+					fsnav_balance_begin(fsnav_step_static_i);                                   \
+				call;                                                                           \
+				if (fsnav->core.balance)                                                        \
+					fsnav_balance_end(fsnav_step_static_i);                                     \
+			}                                                                                   \
+			if (fsnav->mode <= 0 || fsnav->core.host_termination || fsnav->core.revision != checked_revision) \
+				return fsnav_step_entry_end(fsnav_step_static_i) ? fsnav_step_end() : fsnav_step_from(fsnav_step_static_i+1); \
+			fsnav_step_static_p = fsnav->core.plugins + fsnav_step_static_i;                    \
+			if (++(fsnav_step_static_p->tick) >= fsnav_step_static_p->cycle)                    \
+				fsnav_step_static_p->tick = 0;                                                  \
+		}                                                                                       \
+		k++;                                                                                    \
+	}
+
+
+
+
+
+// navigation solution attitude accessors
+void    fsnav_sol_set_att(fsnav_sol* sol, const char fresh); // mark attitude representations written by a plugin as up to date, and the others as stale, input: pointer to solution, FSNAV_SOL_Q | FSNAV_SOL_L | FSNAV_SOL_RPY bit mask
+double* fsnav_sol_get_q  (fsnav_sol* sol                  ); // get attitude quaternion,  derived on demand if stale, return value: pointer to sol->q,   NULL if not valid
+double* fsnav_sol_get_L  (fsnav_sol* sol                  ); // get attitude matrix,      derived on demand if stale, return value: pointer to sol->L,   NULL if not valid
+double* fsnav_sol_get_rpy(fsnav_sol* sol                  ); // get attitude angles,      derived on demand if stale, return value: pointer to sol->rpy, NULL if not valid
+
+
+
+
+
+// inertial solution geodetic terms accessor
+fsnav_geo* fsnav_imu_get_geo(fsnav_imu* imu); // get sine and cosine of latitude, curvature radii and Earth rate projections at imu->sol.llh, derived on demand when position moved, return value: pointer to imu->geo
+
 
 
 
@@ -442,14 +634,24 @@ char fsnav_time_epoch2gps         (unsigned int* week, double* sec, fsnav_time_e
 
 
 // linear algebra functions
+#define FSNAV_LINAL_BLOCK_MIN 16 // smallest dimension with 4 x 4 register-tiled mmul, mmul1T, mmul2T, msq2T_u and uuT (uuT above FSNAV_LINAL_SIZE_MAX)
 	// conventional operations
-double fsnav_linal_dot     (double* u, double* v, const size_t n                                              ); // calculate dot product
-double fsnav_linal_vnorm   (double* u, const size_t n                                                         ); // calculate l_2 vector norm, i.e. sqrt(u^T*u)
-void   fsnav_linal_cross3x1(double* res, double* u, double* v                                                 ); // calculate cross product for 3x1 vectors
-void   fsnav_linal_mmul    (double* res, double* a, double* b, const size_t n, const size_t n1, const size_t m); // multiply two matrices:                        res = a*b,   where a is n x n1, b is n1 x m, res is n x m
-void   fsnav_linal_mmul1T  (double* res, double* a, double* b, const size_t n, const size_t m, const size_t n1); // multiply two matrices ( first is transposed): res = a^T*b, where a is n x m,  b is n x n1, res is m x n1
-void   fsnav_linal_mmul2T  (double* res, double* a, double* b, const size_t n, const size_t m, const size_t n1); // multiply two matrices (second is transposed): res = a*b^T, where a is n x m,  b is n1 x m, res is n x n1
-void   fsnav_linal_qmul    (double* res, double* q, double* r                                                 ); // multiply 4x1 quaternions:                     res = q x r, with res0, q0, r0 being scalar parts
+double fsnav_linal_dot      (double* u, double* v, const size_t n                                              ); // calculate dot product
+double fsnav_linal_vnorm    (double* u, const size_t n                                                         ); // calculate l_2 vector norm, i.e. sqrt(u^T*u)
+void   fsnav_linal_cross3x1 (double* res, double* u, double* v                                                 ); // calculate cross product for 3x1 vectors
+void   fsnav_linal_mmul     (double* res, double* a, double* b, const size_t n, const size_t n1, const size_t m); // multiply two matrices:                        res = a*b,   where a is n x n1, b is n1 x m, res is n x m
+void   fsnav_linal_mmul1T   (double* res, double* a, double* b, const size_t n, const size_t m, const size_t n1); // multiply two matrices ( first is transposed): res = a^T*b, where a is n x m,  b is n x n1, res is m x n1
+void   fsnav_linal_mmul2T   (double* res, double* a, double* b, const size_t n, const size_t m, const size_t n1); // multiply two matrices (second is transposed): res = a*b^T, where a is n x m,  b is n1 x m, res is n x n1
+void   fsnav_linal_mmul3x1  (double* res, double* a, double* b                                                 ); // multiply 3x3 matrix by 3x1 vector:                          res = a*b
+void   fsnav_linal_mmul1T3x1(double* res, double* a, double* b                                                 ); // multiply transposed 3x3 matrix by 3x1 vector:               res = a^T*b
+void   fsnav_linal_mmul3x3  (double* res, double* a, double* b                                                 ); // multiply two 3x3 matrices:                                  res = a*b
+void   fsnav_linal_mmul1T3x3(double* res, double* a, double* b                                                 ); // multiply two 3x3 matrices ( first is transposed):           res = a^T*b
+void   fsnav_linal_mmul2T3x3(double* res, double* a, double* b                                                 ); // multiply two 3x3 matrices (second is transposed):           res = a*b^T
+void   fsnav_linal_qmul     (double* res, double* q, double* r                                                 ); // multiply 4x1 quaternions:                     res = q x r, with res0, q0, r0 being scalar parts
+void   fsnav_linal_qmul1C   (double* res, double* q, double* r                                                 ); // multiply 4x1 quaternions ( first is conjugated): res = q~ x r
+void   fsnav_linal_qmul2C   (double* res, double* q, double* r                                                 ); // multiply 4x1 quaternions (second is conjugated): res = q x r~
+void   fsnav_linal_qmul_batch(double* res, double* q, double* r, const size_t n                                ); // multiply n pairs of 4x1 quaternions lined up one after another: res_k = q_k x r_k
+void   fsnav_linal_qnormalize(double* q                                                                        ); // normalize 4x1 quaternion in place, with a Newton step for 1/sqrt near unit norm
 	
 	// space rotation representation
 void fsnav_linal_mat2quat(double* q, double* R  ); // calculate quaternion q (with q0 being scalar part) corresponding to 3x3 attitude matrix R
@@ -457,33 +659,63 @@ void fsnav_linal_quat2mat(double* R, double* q  ); // calculate 3x3 attitude mat
 void fsnav_linal_rpy2mat (double* R, double* rpy); // calculate 3x3 transition matrix R from E-N-U corresponding to roll, pitch and yaw (radians, airborne frame: X longitudinal, Z right-wing)
 void fsnav_linal_mat2rpy (double* rpy, double* R); // calculate roll, pitch and yaw (radians, airborne frame: X longitudinal, Z right-wing) corresponding to 3x3 transition matrix R from E-N-U
 void fsnav_linal_eul2mat (double* R, double* e  ); // calculate 3x3 rotation matrix R for 3x1 Euler vector e via Rodrigues' formula: R = E + sin|e|/|e|*[e,] + (1-cos|e|)/|e|^2*[e,]^2 
+void fsnav_linal_eul2quat(double* q, double* e  ); // calculate quaternion q for 3x1 Euler vector e: q = [cos(|e|/2) e*sin(|e|/2)/|e|]
+		// polynomial approximations (fast math), within a few units of the last place of the libm-based routines above
+void   fsnav_linal_eul2mat_fast (double* R, double* e  ); // calculate 3x3 rotation matrix R for 3x1 Euler vector e via Rodrigues' formula with minimax polynomials for |e| <= 1
+void   fsnav_linal_eul2mat_batch(double* R, double* e, const size_t n, const char fast); // calculate 3x3 rotation matrices for n 3x1 Euler vectors, fast (1) or reference (0) routine
+void   fsnav_linal_eul2quat_fast (double* q, double* e  ); // calculate quaternion q for 3x1 Euler vector e with Taylor polynomials for |e| <= 1
+void   fsnav_linal_eul2quat_batch(double* q, double* e, const size_t n, const char fast); // calculate quaternions for n 3x1 Euler vectors, fast (1) or reference (0) routine
+double fsnav_linal_atan2_fast   (double y, double x ); // calculate arctangent of y/x in the range of -pi..pi with minimax polynomial
+void   fsnav_linal_mat2rpy_fast (double* rpy, double* R); // calculate roll, pitch and yaw corresponding to 3x3 transition matrix R from E-N-U with fsnav_linal_atan2_fast
 	
 	// routines for n x n upper-triangular matrices U lined up in one-dimensional array u
+#define FSNAV_LINAL_SIZE_MIN         2 // smallest dimension with size-specialized uuT, chol and square root Kalman filtering kernels
+#define FSNAV_LINAL_SIZE_MAX        16 // largest  dimension with size-specialized uuT, measurement residual check and gated update
+#define FSNAV_LINAL_CHOL_SIZE_MAX    3 // largest  dimension with size-specialized chol, no measurable gain above (tests/bench_linal_sizes)
+#define FSNAV_LINAL_UPDATE_SIZE_MAX  8 // largest  dimension with size-specialized ungated scalar Kalman update, no measurable gain above
 		// element manipulations
 void fsnav_linal_u_ij2k(size_t* k, const size_t i, const size_t j, const size_t n); // convert index for upper-triangular matrix lined up in one-dimensional array: (i,j) ->  k
 void fsnav_linal_u_k2ij(size_t* i, size_t* j, const size_t k,      const size_t n); // convert index for upper-triangular matrix lined up in one-dimensional array:  k    -> (i,j)
 void fsnav_linal_diag2u(double* u, double* d,                      const size_t n); // fill the diagonal with array elements
 
 		// conventional matrix operations
-void fsnav_linal_u_mul  (double* res, double* u, double* v, const size_t n, const size_t m); // multiply upper-triangular matrix lined up in one-dimensional array of n(n+1)/2 x 1 by a regular matrix:             res = U*v
-void fsnav_linal_uT_mul (double* res, double* u, double* v, const size_t n, const size_t m); // multiply transposed upper-triangular matrix lined up in one-dimensional array of n(n+1)/2 x 1, by a regular matrix: res = U^T*v
-void fsnav_linal_mul_u  (double* res, double* v, double* u, const size_t m, const size_t n); // multiply a regular matrix by upper-triangular matrix lined up in one-dimensional array of n(n+1)/2 x 1:             res = v*U
-void fsnav_linal_msq2T_u(double* res, double* v,            const size_t n, const size_t m); // multiply a regular matrix by itself transposed, storing upper part of the result lined up in one-dimensional array: res = v*v^T
-void fsnav_linal_msq1T_u(double* res, double* v,            const size_t m, const size_t n); // multiply a transposed regular matrix by itself, storing upper part of the result lined up in one-dimensional array: res = v^T*v
-void fsnav_linal_u_inv  (double* res, double* u,                            const size_t n); // invert upper-triangular matrix lined up in one-dimensional array of n(n+1)/2 x 1:                                   res = U^-1
-void fsnav_linal_uuT    (double* res, double* u,                            const size_t n); // calculate square (with transposition) of upper-triangular matrix lined up in one-dimensional array of n(n+1)/2 x 1: res = U*U^T
+void fsnav_linal_u_mul    (double* res, double* u, double* v, const size_t n, const size_t m); // multiply upper-triangular matrix lined up in one-dimensional array of n(n+1)/2 x 1 by a regular matrix:             res = U*v
+void fsnav_linal_uT_mul   (double* res, double* u, double* v, const size_t n, const size_t m); // multiply transposed upper-triangular matrix lined up in one-dimensional array of n(n+1)/2 x 1, by a regular matrix: res = U^T*v
+void fsnav_linal_mul_u    (double* res, double* v, double* u, const size_t m, const size_t n); // multiply a regular matrix by upper-triangular matrix lined up in one-dimensional array of n(n+1)/2 x 1:             res = v*U
+void fsnav_linal_u_mul3x1 (double* res, double* u, double* v                                ); // multiply 3x3 upper-triangular matrix lined up in one-dimensional array of 6 x 1 by 3x1 vector:             res = U*v
+void fsnav_linal_uT_mul3x1(double* res, double* u, double* v                                ); // multiply transposed 3x3 upper-triangular matrix lined up in one-dimensional array of 6 x 1 by 3x1 vector: res = U^T*v
+void fsnav_linal_msq2T_u  (double* res, double* v,            const size_t n, const size_t m); // multiply a regular matrix by itself transposed, storing upper part of the result lined up in one-dimensional array: res = v*v^T
+void fsnav_linal_msq1T_u  (double* res, double* v,            const size_t m, const size_t n); // multiply a transposed regular matrix by itself, storing upper part of the result lined up in one-dimensional array: res = v^T*v
+void fsnav_linal_u_inv    (double* res, double* u,                            const size_t n); // invert upper-triangular matrix lined up in one-dimensional array of n(n+1)/2 x 1:                                   res = U^-1
+void fsnav_linal_uuT      (double* res, double* u,                            const size_t n); // calculate square (with transposition) of upper-triangular matrix lined up in one-dimensional array of n(n+1)/2 x 1: res = U*U^T
 
 	// matrix factorizations
 void fsnav_linal_chol(double* S, double* P, const size_t n); // calculate Cholesky upper-triangular factorization P = S*S^T, where P is symmetric positive-definite matrix
+void fsnav_linal_ud  (double* U, double* D, double* P, const size_t n); // calculate U-D factorization P = U*D*U^T, where U is unit upper-triangular, D is diagonal, P is symmetric positive-semidefinite matrix
 
 	// square root Kalman filtering
 char   fsnav_linal_check_measurement_residual(double* x, double* S, double z, double* h, double sigma, double k_sigma, const size_t n); // check measurement residual magnitude against predicted covariance level
 double fsnav_linal_kalman_update             (double* x, double* S, double* K, double z, double* h, double sigma,      const size_t n); // perform square root Kalman filter update     phase
+char   fsnav_linal_kalman_update_gated       (double* x, double* S, double* K, double* nu, double z, double* h, double sigma, double k_sigma, const size_t n); // perform square root Kalman filter update phase if measurement residual passes the gate, with S^T*h calculated once
+double fsnav_linal_kalman_update_sparse      (double* x, double* S, double* K, double z, size_t* hi, double* hv, const size_t nz, double sigma, const size_t n); // perform square root Kalman filter update phase for a sparse measurement model given by indices and values of nonzero elements
+char   fsnav_linal_kalman_update_vector      (double* x, double* S, double* K, double* z, double* H, double* R, const size_t n, const size_t m); // perform square root Kalman filter update phase for a vector measurement with correlated noise
 void   fsnav_linal_kalman_predict_I_qI       (           double* S,            double  q2, const size_t n                            ); // perform square root Kalman filter prediction phase: identity         state transition, scalar         process noise covariance
 void   fsnav_linal_kalman_predict_I_qIr      (           double* S,            double  q2, const size_t n, const size_t m            ); // perform square root Kalman filter prediction phase: identity         state transition, reduced scalar process noise covariance
 void   fsnav_linal_kalman_predict_I_diag     (           double* S,            double* q2, const size_t n, const size_t m            ); // perform square root Kalman filter prediction phase: identity         state transition, diagonal       process noise covariance
 void   fsnav_linal_kalman_predict_I          (           double* S,            double* Q , const size_t n, const size_t m            ); // perform square root Kalman filter prediction phase: identity         state transition
 void   fsnav_linal_kalman_predict_U_diag     (double* x, double* S, double* U, double* q2, const size_t n, const size_t m            ); // perform square root Kalman filter prediction phase: upper triangular state transition, diagonal       process noise covariance
 void   fsnav_linal_kalman_predict_U          (double* x, double* S, double* U, double* Q , const size_t n, const size_t m            ); // perform square root Kalman filter prediction phase: upper triangular state transition
+void   fsnav_linal_kalman_predict_F          (double* x, double* S, double* F, double* G, double* Qh, double* A, const size_t n, const size_t m); // perform square root Kalman filter prediction phase: general state transition, triangularization of [F*S | G*Qh] without forming the covariance
+
+	// U-D factor Kalman filtering
+double fsnav_linal_ud_update (double* x, double* U, double* D, double* K, double z, double* h, double sigma, const size_t n); // perform U-D factor Kalman filter update     phase (Bierman)
+void   fsnav_linal_ud_predict(double* x, double* U, double* D, double* F, double* G, double* q2, double* W, const size_t n, const size_t m); // perform U-D factor Kalman filter prediction phase (Thornton): general state transition, diagonal process noise covariance
+
+	// Kalman filter bank, nf filters of the same dimension in structure-of-arrays layout, element p of filter k at [p*nf + k]
+void   fsnav_linal_bank_set           (double* xb, double* Sb, double* x , double* S ,                                 const size_t n, const size_t nf, const size_t k); // copy a filter into a Kalman filter bank
+void   fsnav_linal_bank_get           (double* x , double* S , double* xb, double* Sb,                                 const size_t n, const size_t nf, const size_t k); // copy a filter out of a Kalman filter bank
+void   fsnav_linal_bank_update        (double* x , double* S , double* K , double* L , double* z, double* h, double* sigma, const size_t n, const size_t nf                ); // perform square root Kalman filter update     phase for all filters of a bank, with measurement log-likelihoods
+void   fsnav_linal_bank_predict_I_diag(            double* S , double* q2,                                        const size_t n, const size_t m, const size_t nf        ); // perform square root Kalman filter prediction phase for all filters of a bank: identity state transition, diagonal process noise covariance
+double fsnav_linal_bank_weights       (double* mu, double* L ,                                                                                 const size_t nf                ); // update model probabilities of a Kalman filter bank with measurement likelihoods, return the bank log-likelihood
 
 #endif // FSNAV_H_
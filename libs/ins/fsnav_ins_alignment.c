@@ -32,7 +32,7 @@
 #include "../fsnav.h"
 
 // fsnav bus version check
-#define FSNAV_INS_ALIGNMENT_BUS_VERSION_REQUIRED 8
+#define FSNAV_INS_ALIGNMENT_BUS_VERSION_REQUIRED 19
 #if FSNAV_BUS_VERSION < FSNAV_INS_ALIGNMENT_BUS_VERSION_REQUIRED
 	#error "fsnav bus version check failed, consider fetching the latest version"
 #endif
@@ -121,9 +121,12 @@ void fsnav_ins_alignment_static(void) {
 	}
 	else						// main cycle
 	{
-		// check if alignment duration exceeded 
-		if (fsnav->imu->t > t0)
+		// check if alignment duration exceeded, retire to be removed from the execution list
+		if (fsnav->imu->t > t0) {
+			fsnav->retire_plugin(fsnav_ins_alignment_static);
+			fsnav->signal(FSNAV_TOPIC_ALIGNMENT);
 			return;
+		}
 		// drop validity flags
 		fsnav->imu->sol.L_valid		= 0;
 		fsnav->imu->sol.q_valid		= 0;
@@ -152,12 +155,8 @@ void fsnav_ins_alignment_static(void) {
 			L[i + 2] = f [j]/d[2];
 		}
 		fsnav->imu->sol.L_valid   = 1;
-		// renew quaternion
-		fsnav_linal_mat2quat(fsnav->imu->sol.q  , fsnav->imu->sol.L);
-		fsnav->imu->sol.q_valid   = 1;
-		// renew angles
-		fsnav_linal_mat2rpy (fsnav->imu->sol.rpy, fsnav->imu->sol.L);
-		fsnav->imu->sol.rpy_valid = 1;
+		// quaternion and angles are derived on demand
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_L);
 		// set velocity equal to zero, as it is assumed to do so in static alignment
 		for (i = 0; i < 3; i++)
 			fsnav->imu->sol.v[i] = 0;
@@ -244,8 +243,9 @@ void fsnav_ins_alignment_rotating(void) {
 		 hx  [3],       // approximation model matrix
 		  y  [3],       // Earth rotation axis ort estimate
 		 Sy  [6],       // upper-triangular part of Colesky factorization of Earth rotation axis ort covariance
-		 hy  [3],       // Earth rotation axis ort model matrix
-		 Ky  [3],       // Earth rotation axis ort Kalman gain
+		 zy  [3],       // Earth rotation axis ort measurements
+		 hy  [9],       // Earth rotation axis ort model matrix
+		 Ky  [9],       // Earth rotation axis ort Kalman gains
 		 wf  [3],       // first column of attitude matrix
 		fwf  [3];       // second column of attitude matrix
 					    
@@ -288,9 +288,12 @@ void fsnav_ins_alignment_rotating(void) {
 
 	else						// main cycle
 	{
-		// check if alignment duration exceeded 
-		if (fsnav->imu->t > t1)
+		// check if alignment duration exceeded, retire to be removed from the execution list
+		if (fsnav->imu->t > t1) {
+			fsnav->retire_plugin(fsnav_ins_alignment_rotating);
+			fsnav->signal(FSNAV_TOPIC_ALIGNMENT);
 			return;
+		}
 		// drop validity flags
 		fsnav->imu->sol.L_valid		= 0;
 		fsnav->imu->sol.q_valid		= 0;
@@ -352,7 +355,7 @@ void fsnav_ins_alignment_rotating(void) {
 		sut = sin(ut);
 		cut = cos(ut);
 		// transforming into inertial frame fz0 = A^T*fz
-		fsnav_linal_mmul1T(fz0, Azz0, fsnav->imu->f, 3, 3, 1);
+		fsnav_linal_mmul1T3x1(fz0, Azz0, fsnav->imu->f);
 		// approximation model coefficients
 		hx[0] = (1 - cut)/(fsnav->imu_const.u*fsnav->imu_const.u);  
 		hx[1] =   sut    / fsnav->imu_const.u;  
@@ -362,18 +365,17 @@ void fsnav_ins_alignment_rotating(void) {
 			// velocity interal update
 			vz0[i] += fz0[i]*dt;
 			// approiximation coefficient estimates
-			if (fsnav_linal_check_measurement_residual(x[i],Sx[i], vz0[i],hx,v_std, 3.0, m)) // check measurement residual within 3-sigma with current estimate
-				fsnav_linal_kalman_update(x[i],Sx[i],Kx, vz0[i],hx,v_std, m);                // update estimates using v = h*x + dv, v_std = sqrt(E[dv^2])
+			fsnav_linal_kalman_update_gated(x[i],Sx[i],Kx,NULL, vz0[i],hx,v_std, 3.0, m); // update estimates using v = h*x + dv, v_std = sqrt(E[dv^2]), if residual is within 3-sigma with current estimate
 			// approximation at t0 in inertial frame
 			fz0a0[i] = x[i][1] + x[i][2];
 			// approximation at t  in inertial frame
 			fz0[i] = x[i][0]*sut/fsnav->imu_const.u + x[i][1]*cut + x[i][2];
 		}
 		// transition to instrumental frame (fza = Azz0*fz0) and normalization
-		fsnav_linal_mmul(fza , Azz0, fz0 , 3, 3, 1);
+		fsnav_linal_mmul3x1(fza , Azz0, fz0 );
 		n = fsnav_linal_vnorm(fza,3);                    // n = |fza|
 		if (n > 0) for (i = 0; i < 3; i++) fza[i] /= n; // normalization
-		fsnav_linal_mmul(fz0, Azz0, fz0a0, 3, 3, 1);
+		fsnav_linal_mmul3x1(fz0, Azz0, fz0a0);
 		n = fsnav_linal_vnorm(fz0,3);                    // n = |fz0|
 		if (n > 0) for (i = 0; i < 3; i++) fz0[i] /= n; // normalization
 		// estimating Earth rotation axis ort
@@ -382,11 +384,13 @@ void fsnav_ins_alignment_rotating(void) {
 		C[2] = slt*slt + clt*clt*cut;
 		for (i = 0; i < 3; i++) {
 			// H = (w x f)*C_13 + [f x (w x f)]*C_23
-			hy[(i+0)%3] = (fza[(i+1)%3]*fza[(i+1)%3] + fza[(i+2)%3]*fza[(i+2)%3])*C[1];
-			hy[(i+1)%3] =  fza[(i+2)%3]*C[0]         - fza[(i+0)%3]*fza[(i+1)%3] *C[1];
-			hy[(i+2)%3] = -fza[(i+1)%3]*C[0]         - fza[(i+0)%3]*fza[(i+2)%3] *C[1];
-			fsnav_linal_kalman_update(y,Sy,Ky, (fz0[i]-fza[i]*C[2])*sin(ut/2),hy,1, 3); // update estimate using z = [fza0 - fza*C_33], z = H*y + r, M[r^2] = 1
+			hy[i*3+(i+0)%3] = (fza[(i+1)%3]*fza[(i+1)%3] + fza[(i+2)%3]*fza[(i+2)%3])*C[1];
+			hy[i*3+(i+1)%3] =  fza[(i+2)%3]*C[0]         - fza[(i+0)%3]*fza[(i+1)%3] *C[1];
+			hy[i*3+(i+2)%3] = -fza[(i+1)%3]*C[0]         - fza[(i+0)%3]*fza[(i+2)%3] *C[1];
+			// z = [fza0 - fza*C_33]
+			zy[i] = (fz0[i]-fza[i]*C[2])*sin(ut/2);
 		}
+		fsnav_linal_kalman_update_vector(y,Sy,Ky, zy,hy,NULL, 3,3); // update estimate using z = H*y + r, M[r*r^T] = I
 		// Kalman prediction step, identity transition, diagonal system noise covariance
 		fsnav_linal_kalman_predict_I_qI(Sy,q2,3); // P = S*S^T, P_ii = P_ii + q^2, S = chol(P)
 		// renew attitude matrix: L = [ (w x f)/|w x f| , (f x (w x f))/(|f||w x f|) , f/|f| ]
@@ -398,12 +402,8 @@ void fsnav_ins_alignment_rotating(void) {
 			for (i = 0; i < 3; i++) L[i*3+1] = fwf[i]/n; // L2 = (f x (w x f))/(|f||w x f|)
 			for (i = 0; i < 3; i++) L[i*3+2] = fza[i];   // L3 =           f  / |f|
 			fsnav->imu->sol.L_valid = 1;
-			// renew quaternion
-			fsnav_linal_mat2quat(fsnav->imu->sol.q ,L);
-			fsnav->imu->sol.q_valid   = 1;
-			// renew angles: roll, pitch and yaw=true heading
-			fsnav_linal_mat2rpy(fsnav->imu->sol.rpy,L);
-			fsnav->imu->sol.rpy_valid = 1;
+			// quaternion and angles (roll, pitch and yaw=true heading) are derived on demand
+			fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_L);
 		}
 		// instrumental frame update: Azz0(t+dt) = (E + [w x]*sin(|w*dt|)/|w| + [w x]^2*(1-cos(|w*dt|)/|w*dt|^2)*Azz0(t) - Rodrigues' rotation formula
 		for (i = 0; i < 3; i++)
@@ -533,9 +533,12 @@ void fsnav_ins_alignment_rotating_rpy(void) {
 
 	else						// main cycle
 	{
-		// check if alignment duration exceeded 
-		if (fsnav->imu->t > t1)
+		// check if alignment duration exceeded, retire to be removed from the execution list
+		if (fsnav->imu->t > t1) {
+			fsnav->retire_plugin(fsnav_ins_alignment_rotating_rpy);
+			fsnav->signal(FSNAV_TOPIC_ALIGNMENT);
 			return;
+		}
 		// drop validity flags
 		fsnav->imu->sol.L_valid		= 0;
 		fsnav->imu->sol.q_valid		= 0;
@@ -589,7 +592,7 @@ void fsnav_ins_alignment_rotating_rpy(void) {
 		sut = sin(ut);
 		cut = cos(ut);
 		// transforming into inertial frame fz0 = A^T*fz
-		fsnav_linal_mmul1T(fz0, Azz0, fsnav->imu->f, 3, 3, 1);
+		fsnav_linal_mmul1T3x1(fz0, Azz0, fsnav->imu->f);
 		// approximation model coefficients
 		hx[0] = (1 - cut)/(fsnav->imu_const.u*fsnav->imu_const.u);  
 		hx[1] =   sut    / fsnav->imu_const.u;  
@@ -599,15 +602,14 @@ void fsnav_ins_alignment_rotating_rpy(void) {
 			// velocity interal update
 			vz0[i] += fz0[i]*dt;
 			// approiximation coefficient estimates
-			if (fsnav_linal_check_measurement_residual(x[i],Sx[i], vz0[i],hx,v_std, 3.0, m)) // check measurement residual within 3-sigma with current estimate
-				fsnav_linal_kalman_update(x[i],Sx[i],Kx, vz0[i],hx,v_std, m);                // update estimates using v = h*x + dv, v_std = sqrt(E[dv^2])
+			fsnav_linal_kalman_update_gated(x[i],Sx[i],Kx,NULL, vz0[i],hx,v_std, 3.0, m); // update estimates using v = h*x + dv, v_std = sqrt(E[dv^2]), if residual is within 3-sigma with current estimate
 			// approximation at t0 in inertial frame
 			fz0a0[i] = x[i][1] + x[i][2];
 			// approximation at t  in inertial frame
 			fz0[i] = x[i][0]*sut/fsnav->imu_const.u + x[i][1]*cut + x[i][2];
 		}
 		// transition to instrumental frame (fza = Azz0*fz0) and normalization
-		fsnav_linal_mmul(fza , Azz0, fz0 , 3, 3, 1);
+		fsnav_linal_mmul3x1(fza , Azz0, fz0 );
 		// roll angle via fza components
 		fsnav->imu->sol.rpy[0] = -atan2(fza[2], fza[1]);
 		// pitch angle via fza components
@@ -622,8 +624,8 @@ void fsnav_ins_alignment_rotating_rpy(void) {
 		fsnav_linal_rpy2mat(fsnav->imu->sol.L, fsnav->imu->sol.rpy); // Axz^T(t)
 			// how to produce matrix A_z_x_t0: via angles at either t0, or t `\_("o)_/`
 		fsnav_linal_rpy2mat(L0, rpy0); // Azx(t0)
-		fsnav_linal_mmul1T(D, fsnav->imu->sol.L, Azz0, 3,3,3);
-		fsnav_linal_mmul  (C, D, L0, 3,3,3);
+		fsnav_linal_mmul1T3x3(D, fsnav->imu->sol.L, Azz0);
+		fsnav_linal_mmul3x3  (C, D, L0);
 		// "matrix D" `\_("o)_/`	 // only the elements being used	
 		D[2] = -sut*clt;
 		D[5] = (1 - cut)*slt*clt;
@@ -633,9 +635,8 @@ void fsnav_ins_alignment_rotating_rpy(void) {
 		// attitude matrix
 		fsnav_linal_rpy2mat(fsnav->imu->sol.L, fsnav->imu->sol.rpy);
 		fsnav->imu->sol.L_valid = 1;
-		// renew quaternion
-		fsnav_linal_mat2quat(fsnav->imu->sol.q  , fsnav->imu->sol.L);
-		fsnav->imu->sol.q_valid   = 1;		
+		// quaternion is derived on demand
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_RPY | FSNAV_SOL_L);
 		// instrumental frame update: Azz0(t+dt) = (E + [w x]*sin(|w*dt|)/|w| + [w x]^2*(1-cos(|w*dt|)/|w|^2)*Azz0(t) - Rodrigues' rotation formula
 		for (i = 0; i < 3; i++)
 			a[i] = fsnav->imu->w[i]*dt; // a = w*dt
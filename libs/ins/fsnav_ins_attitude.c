@@ -6,28 +6,54 @@
 	- fsnav_ins_attitude_rodrigues
 		Combines angular rate components or their integrals into Euler rotation vector 
 		for both instrumental frame and navigation frame. Then applies Rodrigues' rotation formula 
-		to each frame. Then derives the transition matrix between them. Quaternion and angles are also updated.
+		to each frame. Then derives the transition matrix between them. Quaternion and angles are derived on demand.
 		Recommended for navigation/tactical grade systems.
 
-	- (planned) fsnav_ins_attitude_madgwick
-		Planned for future development
+	- fsnav_ins_attitude_quaternion
+		Propagates attitude quaternion directly with incremental quaternion products
+		for instrumental frame and navigation frame, with periodic renormalization. 
+		Attitude matrix and angles are derived from the quaternion on demand.
+		Recommended for navigation/tactical grade systems.
+
+	- fsnav_ins_attitude_coning
+		Accumulates angular rate integrals over several sensor samples into a coning compensated 
+		Euler rotation vector, then applies Rodrigues' rotation formula to each frame once per interval.
+		Recommended for navigation/tactical grade systems under vibration at reduced attitude update rate.
+
+	- fsnav_ins_attitude_madgwick
+		Propagates attitude quaternion with Madgwick gradient descent correction 
+		towards the specific force direction, which is assumed to be vertical.
+		Recommended for MEMS sensors, when only roll and pitch are to be kept bounded without aiding.
+		A batch variant processes a block of samples outside the bus.
+
+	- fsnav_ins_attitude_mahony
+		Propagates attitude quaternion with Mahony proportional-integral complementary correction 
+		towards the specific force direction, which is assumed to be vertical.
+		Uses only multiply-adds and one quaternion normalization per sample.
+		Recommended for low-cost MEMS sensors, when only roll and pitch are to be kept bounded without aiding.
 */
 
+#include <stdlib.h>
 #include <math.h>
 
 #include "../fsnav.h"
+#include "fsnav_ins_attitude.h"
 
 // fsnav bus version check
-#define FSNAV_INS_ATTITUDE_BUS_VERSION_REQUIRED 8
+#define FSNAV_INS_ATTITUDE_BUS_VERSION_REQUIRED 20
 #if FSNAV_BUS_VERSION < FSNAV_INS_ATTITUDE_BUS_VERSION_REQUIRED
 	#error "fsnav bus version check failed, consider fetching the latest version"
 #endif
 
+// service functions
+void fsnav_ins_attitude_madgwick_update(double* q, double* w, double* f, double* c, const double dt, const double beta);
+void fsnav_ins_attitude_mahony_update  (double* q, double* b, double* w, double* f, double* c, const double dt, const double kp, const double ki);
+
 /* fsnav_ins_attitude_rodrigues - fsnav plugin
 	
 	Combines angular rate components or their integrals into Euler rotation vector 
 	for both instrumental frame and navigation frame. Then applies Rodrigues' rotation formula 
-	to each frame. Then derives the transition matrix between them. Quaternion and angles are also updated.
+	to each frame. Then derives the transition matrix between them. Quaternion and angles are derived on demand.
 	Recommended for navigation/tactical grade systems.
 
 	description:
@@ -42,7 +68,9 @@
 		[v x] = [ -v3  0   v1 ] for v = a, v = c
 	            [  v2 -v1  0  ]
 				
-		fsnav core function fsnav_linal_eul2mat safely uses Taylor expansions for |a|,|c| < 2^-8
+		fsnav core function fsnav_linal_eul2mat safely uses Taylor expansions for |a|,|c| < 2^-8,
+		fsnav_linal_eul2mat_fast uses minimax polynomials for |a|,|c| <= 1 (fast_math flag);
+		quaternion and angles are marked stale and derived by fsnav_sol_get_q, fsnav_sol_get_rpy when read
 		
 	uses:
 		fsnav->imu->t
@@ -54,6 +82,7 @@
 		fsnav->imu->W_valid
 		fsnav->imu->sol.llh
 		fsnav->imu->sol.llh_valid
+		fsnav->imu->geo (fsnav_imu_get_geo)
 
 	changes:
 		fsnav->imu->sol.L
@@ -64,11 +93,17 @@
 		fsnav->imu->sol.rpy_valid
 
 	cfg parameters:
-		none
+		{imu: fast_math} - flag to use polynomial approximations instead of libm trigonometry
+			(fsnav_linal_eul2mat_fast, fsnav_linal_mat2rpy_fast)
+			example: {imu: fast_math}
 */
 void fsnav_ins_attitude_rodrigues(void) {
 
+	const char fast_token[] = "fast_math"; // polynomial approximations flag name in configuration
+
 	static double t0 = -1; // previous time
+	static void 
+		(*eul2mat)(double*, double*) = fsnav_linal_eul2mat; // rotation vector to matrix routine
 	static double 		   
 		 C[9],             // intermediate matrix
 		*L;                // pointer to attitude matrix in solution
@@ -76,6 +111,7 @@ void fsnav_ins_attitude_rodrigues(void) {
 	double 
 		   dt,	           // time step
 		   a[3];           // Euler rotation vector
+	fsnav_geo *geo;        // geodetic terms shared on the bus
 	size_t i;              // common index variable
 
 
@@ -106,6 +142,10 @@ void fsnav_ins_attitude_rodrigues(void) {
 		fsnav->imu->sol.rpy_valid = 1;
 		// reset previous time
 		t0 = -1;
+		// libm-based or fast routines
+		fsnav->imu->sol.att_fast = (fsnav_locate_token(fast_token, fsnav->imu->cfg, fsnav->imu->cfglength, 0) != NULL);
+		eul2mat = fsnav->imu->sol.att_fast ? fsnav_linal_eul2mat_fast : fsnav_linal_eul2mat;
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_Q | FSNAV_SOL_L | FSNAV_SOL_RPY);
 
 	}
 
@@ -115,7 +155,7 @@ void fsnav_ins_attitude_rodrigues(void) {
 	else						// main cycle
 	{
 		// check for crucial data initialized
-		if (!fsnav->imu->sol.L_valid || !fsnav->imu->w_valid)
+		if (fsnav_sol_get_L(&(fsnav->imu->sol)) == NULL || !fsnav->imu->w_valid)
 			return;
 		// time variables
 		if (t0 < 0) { // first touch
@@ -128,7 +168,7 @@ void fsnav_ins_attitude_rodrigues(void) {
 		for (i = 0; i < 3; i++)
 			a[i] = fsnav->imu->w[i]*dt;
 		// L = (E + [a x]*sin(a)/|a| + [a x]^2*(1-cos(a))/|a|^2)*L
-		fsnav_linal_eul2mat(C,a);  // C <- A = E + [a x]*sin(a)/|a| + [a x]^2*(1-cos(a))/|a|^2
+		eul2mat(C,a);              // C <- A = E + [a x]*sin(a)/|a| + [a x]^2*(1-cos(a))/|a|^2
 		for (i = 0; i < 3; i++) { // L = A*L
 			a[0] = L[0+i], a[1] = L[3+i], a[2] = L[6+i];
 			L[0+i] = C[0]*a[0] + C[1]*a[1] + C[2]*a[2];
@@ -139,26 +179,851 @@ void fsnav_ins_attitude_rodrigues(void) {
 		for (i = 0; i < 3; i++)
 			a[i] = fsnav->imu->W_valid ? fsnav->imu->W[i] : 0;
 		if (fsnav->imu->sol.llh_valid) {
-			a[1] += fsnav->imu_const.u*cos(fsnav->imu->sol.llh[1]);
-			a[2] += fsnav->imu_const.u*sin(fsnav->imu->sol.llh[1]);
+			geo = fsnav_imu_get_geo(fsnav->imu);
+			a[1] += geo->u[1];
+			a[2] += geo->u[2];
 		}
 		for (i = 0; i < 3; i++)
 			a[i] *= dt;
 		// L = L*(E + [c x]*sin(c)/|c| + [c x]^2*(1-cos(c))/|c|^2)^T
-		fsnav_linal_eul2mat(C,a);     // C = E + [c x]*sin(c)/|c| + [c x]^2*(1-cos(c))/|c|^2
+		eul2mat(C,a);                 // C = E + [c x]*sin(c)/|c| + [c x]^2*(1-cos(c))/|c|^2
 		for (i = 0; i < 9; i += 3) { // L = L*C^T
 			a[0] = L[i+0], a[1] = L[i+1], a[2] = L[i+2];
 			L[i+0] = a[0]*C[0] + a[1]*C[1] + a[2]*C[2];
 			L[i+1] = a[0]*C[3] + a[1]*C[4] + a[2]*C[5];
 			L[i+2] = a[0]*C[6] + a[1]*C[7] + a[2]*C[8];
 		}
-		// renew quaternion
-		fsnav_linal_mat2quat(fsnav->imu->sol.q ,L);
+		// quaternion and angles are derived on demand
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_L);
+
+	}
+
+}
+/* fsnav_ins_attitude_quaternion - fsnav plugin
+	
+	Propagates attitude quaternion directly with incremental quaternion products
+	for instrumental frame and navigation frame, with periodic renormalization. 
+	Attitude matrix and angles are derived from the quaternion on demand.
+	Recommended for navigation/tactical grade systems.
+
+	description:
+		    
+		q(t+dt) = c~ x q(t) x a, 
+		    
+		where
+		x is quaternion product, c~ is conjugate quaternion,
+		a = [cos(|a|/2) a*sin(|a|/2)/|a|] for a = w*dt, 
+		c = [cos(|c|/2) c*sin(|c|/2)/|c|] for c = (W + u)*dt,
+		which is equivalent to L(t+dt) = A L(t) C^T of fsnav_ins_attitude_rodrigues with L = fsnav_linal_quat2mat(q);
+		the quaternion is renormalized every 64 samples
+				
+		fsnav core function fsnav_linal_eul2quat safely uses Taylor expansions for |a|,|c| < 2^-8,
+		fsnav_linal_eul2quat_fast uses polynomials for |a|,|c| <= 1 (fast_math flag);
+		quaternion products involve no square roots or branches, unlike fsnav_linal_mat2quat after matrix propagation;
+		attitude matrix and angles are marked stale and derived by fsnav_sol_get_L, fsnav_sol_get_rpy when read
+		
+	uses:
+		fsnav->imu->t
+		fsnav->imu->sol.q
+		fsnav->imu->sol.q_valid
+		fsnav->imu->w
+		fsnav->imu->w_valid
+		fsnav->imu->W
+		fsnav->imu->W_valid
+		fsnav->imu->sol.llh
+		fsnav->imu->sol.llh_valid
+		fsnav->imu->geo (fsnav_imu_get_geo)
+
+	changes:
+		fsnav->imu->sol.q
+		fsnav->imu->sol.q_valid
+		fsnav->imu->sol.L
+		fsnav->imu->sol.L_valid
+		fsnav->imu->sol.rpy
+		fsnav->imu->sol.rpy_valid
+
+	cfg parameters:
+		{imu: fast_math} - flag to use polynomial approximations instead of libm trigonometry
+			(fsnav_linal_eul2quat_fast, fsnav_linal_mat2rpy_fast)
+			example: {imu: fast_math}
+*/
+void fsnav_ins_attitude_quaternion(void) {
+
+	const char fast_token[] = "fast_math"; // polynomial approximations flag name in configuration
+
+	const int renorm_cycle = 64; // number of samples between quaternion renormalizations
+
+	static double t0 = -1; // previous time
+	static int    k  =  0; // sample counter for renormalization
+	static void 
+		(*eul2quat)(double*, double*) = fsnav_linal_eul2quat; // rotation vector to quaternion routine
+	static double 		   
+		*q;                // pointer to attitude quaternion in solution
+
+	double 
+		   dt,	           // time step
+		   a[3],           // Euler rotation vector
+		   p[4],           // rotation quaternion
+		   r[4];           // intermediate quaternion
+	fsnav_geo *geo;        // geodetic terms shared on the bus
+	size_t i;              // common index variable
+
+
+	// check if imu data has been initialized
+	if (fsnav->imu == NULL)
+		return;
+
+	if (fsnav->mode == 0) {		// init
+
+		// drop validity flags
+		fsnav->imu->sol.  q_valid = 0;
+		fsnav->imu->sol.  L_valid = 0;
+		fsnav->imu->sol.rpy_valid = 0;
+		// set quaternion pointer to imu->sol
+		q = fsnav->imu->sol.q;
+		// identity quaternion
+		for (i = 1, q[0] = 1; i < 4; i++)
+			q[i] = 0;
+		fsnav->imu->sol.  q_valid = 1;
+		// identity attitude matrix
+		for (i = 0; i < 9; i++)
+			fsnav->imu->sol.L[i] = ((i%4) == 0) ? 1 : 0; // for 3x3 matrix, each 4-th element is diagonal
+		fsnav->imu->sol.  L_valid = 1;
+		// attitude angles for identity matrix
+		fsnav->imu->sol.rpy[0] = -fsnav->imu_const.pi/2;	// roll             -90 deg
+		fsnav->imu->sol.rpy[1] =  0;						// pitch              0 deg
+		fsnav->imu->sol.rpy[2] = +fsnav->imu_const.pi/2;	// yaw=true heading +90 deg
+		fsnav->imu->sol.rpy_valid = 1;
+		// reset previous time
+		t0 = -1;
+		k  =  0;
+		// libm-based or fast routines
+		fsnav->imu->sol.att_fast = (fsnav_locate_token(fast_token, fsnav->imu->cfg, fsnav->imu->cfglength, 0) != NULL);
+		eul2quat = fsnav->imu->sol.att_fast ? fsnav_linal_eul2quat_fast : fsnav_linal_eul2quat;
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_Q | FSNAV_SOL_L | FSNAV_SOL_RPY);
+
+	}
+
+	else if (fsnav->mode < 0) {	// termination
+		// do nothing
+	}
+	else						// main cycle
+	{
+		// check for crucial data initialized
+		if (fsnav_sol_get_q(&(fsnav->imu->sol)) == NULL || !fsnav->imu->w_valid)
+			return;
+		// time variables
+		if (t0 < 0) { // first touch
+			t0 = fsnav->imu->t;
+			return;
+		}
+		dt = fsnav->imu->t - t0;
+		t0 = fsnav->imu->t;
+		// q = q x a
+		for (i = 0; i < 3; i++)
+			a[i] = fsnav->imu->w[i]*dt;
+		eul2quat(p, a);
+		fsnav_linal_qmul(r, q, p);
+		// a <- c = (W + u)*dt
+		for (i = 0; i < 3; i++)
+			a[i] = fsnav->imu->W_valid ? fsnav->imu->W[i] : 0;
+		if (fsnav->imu->sol.llh_valid) {
+			geo = fsnav_imu_get_geo(fsnav->imu);
+			a[1] += geo->u[1];
+			a[2] += geo->u[2];
+		}
+		for (i = 0; i < 3; i++)
+			a[i] *= dt;
+		// q = c~ x q
+		eul2quat(p, a);
+		fsnav_linal_qmul1C(q, p, r);
+		// periodic renormalization
+		if (++k >= renorm_cycle) {
+			fsnav_linal_qnormalize(q);
+			k = 0;
+		}
 		fsnav->imu->sol.q_valid   = 1;
-		// renew angles
-		fsnav_linal_mat2rpy(fsnav->imu->sol.rpy,L);
+		// attitude matrix and angles are derived on demand
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_Q);
+
+	}
+
+}
+
+/* fsnav_ins_attitude_coning - fsnav plugin
+	
+	Accumulates angular rate integrals over N sensor samples into a coning compensated rotation vector
+	for instrumental frame, then applies Rodrigues' rotation formula to instrumental and navigation frames 
+	once per N samples. Quaternion and angles are derived on demand.
+	Recommended for navigation/tactical grade systems under vibration, when attitude is not needed at every sample.
+
+	description:
+		
+		L(t_m) = A L(t_m-1) C^T,
+		
+		where
+		A, C are Rodrigues' matrices as in fsnav_ins_attitude_rodrigues for
+		a = da_1 + ... + da_N + dc,   da_k = w_k*dt (rotation vector with coning compensation)
+		c = (W + u)*T,                T = t_m - t_m-1 (navigation frame rotation over the interval)
+		and the coning term dc is (classical multi-sample algorithms, N samples per interval):
+		N = 1: dc = da_0 x da_1/12, da_0 is the last sample of the previous interval
+		N = 2: dc = 2/3*da_1 x da_2
+		N = 3: dc = 33/80*da_1 x da_3 + 57/80*da_2 x (da_3 - da_1)
+		N = 4: dc = 736/945*(da_1 x da_2 + da_3 x da_4) + 334/945*(da_1 x da_3 + da_2 x da_4) 
+		          + 526/945*da_1 x da_4 + 654/945*da_2 x da_3
+		N > 4: dc = sum_k (a_k-1 + da_k-1/6) x da_k/2, a_k-1 = da_1 + ... + da_k-1 (recursive form, da_0 as for N = 1)
+		
+		attitude matrix, quaternion and angles on the bus hold their values between updates,
+		each update is signalled with FSNAV_TOPIC_ATTITUDE;
+		pair with plugins subscribed to FSNAV_TOPIC_ATTITUDE (fsnav_ins_motion_sculling), 
+		so that they run right after the updates, in phase with the attitude
+		
+	uses:
+		fsnav->imu->t
+		fsnav->imu->sol.L
+		fsnav->imu->sol.L_valid
+		fsnav->imu->w
+		fsnav->imu->w_valid
+		fsnav->imu->W
+		fsnav->imu->W_valid
+		fsnav->imu->sol.llh
+		fsnav->imu->sol.llh_valid
+		fsnav->imu->geo (fsnav_imu_get_geo)
+
+	changes:
+		fsnav->imu->sol.L
+		fsnav->imu->sol.L_valid
+		fsnav->imu->sol.q
+		fsnav->imu->sol.q_valid
+		fsnav->imu->sol.rpy
+		fsnav->imu->sol.rpy_valid
+		FSNAV_TOPIC_ATTITUDE signalled on every update
+
+	cfg parameters:
+		{imu: coning_samples} - number of sensor samples N per attitude update
+			type :   natural number
+			range:   >0
+			default: 4
+			example: {imu: coning_samples = 4}
+		{imu: fast_math} - flag to use polynomial approximations instead of libm trigonometry
+			(fsnav_linal_eul2mat_fast, fsnav_linal_mat2rpy_fast)
+			example: {imu: fast_math}
+*/
+void fsnav_ins_attitude_coning(void) {
+
+	const char 
+		fast_token[] = "fast_math",      // polynomial approximations flag name in configuration
+		N_token   [] = "coning_samples"; // number of samples per update parameter name in configuration
+
+	const int N_def = 4;   // default number of samples per update
+
+	static double t0 = -1; // previous time
+	static void 
+		(*eul2mat)(double*, double*) = fsnav_linal_eul2mat; // rotation vector to matrix routine
+	static double 		   
+		 C[9],             // intermediate matrix
+		 da[4][3],         // rotation increments of the current interval (N <= 4) or previous increment (da[0], N = 1, N > 4)
+		 a[3],             // accumulated rotation vector
+		 dc[3],            // accumulated coning compensation
+		 T,                // time elapsed since the last update
+		*L;                // pointer to attitude matrix in solution
+	static int 
+		N = 4,             // number of samples per update
+		k = 0;             // sample counter within the interval
+
+	char  *cfg_ptr;        // pointer to a substring
+	double 
+		   dt,	           // time step
+		   d[3],           // current rotation increment
+		   e[3],           // intermediate cross product
+		   b[3];           // intermediate vector
+	fsnav_geo *geo;        // geodetic terms shared on the bus
+	size_t i;              // common index variable
+
+
+	// check if imu data has been initialized
+	if (fsnav->imu == NULL)
+		return;
+
+	if (fsnav->mode == 0) {		// init
+
+		// drop validity flags
+		fsnav->imu->sol.  q_valid = 0;
+		fsnav->imu->sol.  L_valid = 0;
+		fsnav->imu->sol.rpy_valid = 0;
+		// set matrix pointer to imu->sol
+		L = fsnav->imu->sol.L;	
+		// identity quaternion
+		for (i = 1, fsnav->imu->sol.q[0] = 1; i < 4; i++)
+			fsnav->imu->sol.q[i] = 0;
+		fsnav->imu->sol.  q_valid = 1;
+		// identity attitude matrix
+		for (i = 0; i < 9; i++)
+			L[i] = ((i%4) == 0) ? 1 : 0; // for 3x3 matrix, each 4-th element is diagonal
+		fsnav->imu->sol.  L_valid = 1;
+		// attitude angles for identity matrix
+		fsnav->imu->sol.rpy[0] = -fsnav->imu_const.pi/2;	// roll             -90 deg
+		fsnav->imu->sol.rpy[1] =  0;						// pitch              0 deg
+		fsnav->imu->sol.rpy[2] = +fsnav->imu_const.pi/2;	// yaw=true heading +90 deg
 		fsnav->imu->sol.rpy_valid = 1;
+		// number of samples per update
+		cfg_ptr = fsnav_locate_token(N_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
+		N = (cfg_ptr != NULL) ? atoi(cfg_ptr) : N_def;
+		if (N < 1)
+			N = N_def;
+		// reset previous time
+		t0 = -1;
+		// libm-based or fast routines
+		fsnav->imu->sol.att_fast = (fsnav_locate_token(fast_token, fsnav->imu->cfg, fsnav->imu->cfglength, 0) != NULL);
+		eul2mat = fsnav->imu->sol.att_fast ? fsnav_linal_eul2mat_fast : fsnav_linal_eul2mat;
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_Q | FSNAV_SOL_L | FSNAV_SOL_RPY);
 
 	}
 
-}
\ No newline at end of file
+	else if (fsnav->mode < 0) {	// termination
+		// do nothing
+	}
+	else						// main cycle
+	{
+		// check for crucial data initialized
+		if (fsnav_sol_get_L(&(fsnav->imu->sol)) == NULL || !fsnav->imu->w_valid) {
+			t0 = -1; // restart accumulation
+			return;
+		}
+		// time variables
+		if (t0 < 0) { // first touch
+			t0 = fsnav->imu->t;
+			T  = 0;
+			k  = 0;
+			for (i = 0; i < 3; i++)
+				a[i] = dc[i] = da[0][i] = 0;
+			return;
+		}
+		dt = fsnav->imu->t - t0;
+		t0 = fsnav->imu->t;
+		T += dt;
+		// d = w*dt
+		for (i = 0; i < 3; i++)
+			d[i] = fsnav->imu->w[i]*dt;
+		// accumulate
+		if (N == 1 || N > 4) { // recursive coning, dc += (a + da_0/6) x d/2
+			for (i = 0; i < 3; i++)
+				b[i] = (N == 1) ? da[0][i]/6 : a[i] + da[0][i]/6;
+			fsnav_linal_cross3x1(e, b, d);
+			for (i = 0; i < 3; i++) {
+				dc[i] += e[i]/2;
+				da[0][i] = d[i];
+			}
+		}
+		else                   // store for multi-sample coning
+			for (i = 0; i < 3; i++)
+				da[k][i] = d[i];
+		for (i = 0; i < 3; i++)
+			a[i] += d[i];
+		if (++k < N)
+			return;
+		// multi-sample coning compensation
+		if (N == 2) {
+			fsnav_linal_cross3x1(e, da[0], da[1]);
+			for (i = 0; i < 3; i++)
+				dc[i] = e[i]*2/3;
+		}
+		else if (N == 3) {
+			fsnav_linal_cross3x1(e, da[0], da[2]);
+			for (i = 0; i < 3; i++) {
+				dc[i] = e[i]*33/80;
+				b [i] = da[2][i] - da[0][i];
+			}
+			fsnav_linal_cross3x1(e, da[1], b);
+			for (i = 0; i < 3; i++)
+				dc[i] += e[i]*57/80;
+		}
+		else if (N == 4) {
+			fsnav_linal_cross3x1(e, da[0], da[1]); for (i = 0; i < 3; i++) dc[i]  = e[i]*736/945;
+			fsnav_linal_cross3x1(e, da[2], da[3]); for (i = 0; i < 3; i++) dc[i] += e[i]*736/945;
+			fsnav_linal_cross3x1(e, da[0], da[2]); for (i = 0; i < 3; i++) dc[i] += e[i]*334/945;
+			fsnav_linal_cross3x1(e, da[1], da[3]); for (i = 0; i < 3; i++) dc[i] += e[i]*334/945;
+			fsnav_linal_cross3x1(e, da[0], da[3]); for (i = 0; i < 3; i++) dc[i] += e[i]*526/945;
+			fsnav_linal_cross3x1(e, da[1], da[2]); for (i = 0; i < 3; i++) dc[i] += e[i]*654/945;
+		}
+		// a = da_1 + ... + da_N + dc
+		for (i = 0; i < 3; i++)
+			a[i] += dc[i];
+		// L = (E + [a x]*sin(a)/|a| + [a x]^2*(1-cos(a))/|a|^2)*L
+		eul2mat(C,a);              // C <- A = E + [a x]*sin(a)/|a| + [a x]^2*(1-cos(a))/|a|^2
+		for (i = 0; i < 3; i++) { // L = A*L
+			a[0] = L[0+i], a[1] = L[3+i], a[2] = L[6+i];
+			L[0+i] = C[0]*a[0] + C[1]*a[1] + C[2]*a[2];
+			L[3+i] = C[3]*a[0] + C[4]*a[1] + C[5]*a[2];
+			L[6+i] = C[6]*a[0] + C[7]*a[1] + C[8]*a[2];
+		}
+		// a <- c = (W + u)*T
+		for (i = 0; i < 3; i++)
+			a[i] = fsnav->imu->W_valid ? fsnav->imu->W[i] : 0;
+		if (fsnav->imu->sol.llh_valid) {
+			geo = fsnav_imu_get_geo(fsnav->imu);
+			a[1] += geo->u[1];
+			a[2] += geo->u[2];
+		}
+		for (i = 0; i < 3; i++)
+			a[i] *= T;
+		// L = L*(E + [c x]*sin(c)/|c| + [c x]^2*(1-cos(c))/|c|^2)^T
+		eul2mat(C,a);                 // C = E + [c x]*sin(c)/|c| + [c x]^2*(1-cos(c))/|c|^2
+		for (i = 0; i < 9; i += 3) { // L = L*C^T
+			a[0] = L[i+0], a[1] = L[i+1], a[2] = L[i+2];
+			L[i+0] = a[0]*C[0] + a[1]*C[1] + a[2]*C[2];
+			L[i+1] = a[0]*C[3] + a[1]*C[4] + a[2]*C[5];
+			L[i+2] = a[0]*C[6] + a[1]*C[7] + a[2]*C[8];
+		}
+		// quaternion and angles are derived on demand
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_L);
+		fsnav->signal(FSNAV_TOPIC_ATTITUDE);
+		// restart accumulation, the last increment is kept for N = 1 and N > 4
+		T = 0;
+		k = 0;
+		for (i = 0; i < 3; i++)
+			a[i] = dc[i] = 0;
+
+	}
+
+}
+
+/* fsnav_ins_attitude_madgwick - fsnav plugin
+	
+	Propagates attitude quaternion with Madgwick gradient descent correction 
+	towards the specific force direction, which is assumed to be vertical.
+	Recommended for MEMS sensors, when only roll and pitch are to be kept bounded without aiding.
+
+	description:
+		
+		q(t+dt) = c~ x (q(t) + (q(t) x [0 w] - beta*grad/|grad|)*dt/2),  then normalized
+		
+		where
+		x is quaternion product, c~ is conjugate quaternion,
+		c = [cos(|c|/2) c*sin(|c|/2)/|c|] for c = (W + u)*dt (navigation frame rotation, as in fsnav_ins_attitude_quaternion),
+		grad = J^T*F is the gradient of |F|^2/2 for the gravity-only objective function
+		
+		    [ 2*(q1*q3 - q0*q2)       ]                        [ -2*q2  2*q3 -2*q0  2*q1 ]
+		F = [ 2*(q0*q1 + q2*q3)       ] - f/|f|,  J = dF/dq =  [  2*q1  2*q0  2*q3  2*q2 ],
+		    [ 1 - 2*(q1*q1 + q2*q2)   ]                        [  0    -4*q1 -4*q2  0    ]
+		
+		i.e. the third column of L(q), the navigation vertical in the instrumental frame, compared to the measured specific force direction;
+		|f| and |grad| take one reciprocal square root each, the quaternion is renormalized 
+		by fsnav_linal_qnormalize (Newton step, no square root near unit norm),
+		and the navigation frame rotation is applied in quaternion space with fsnav_linal_eul2quat_fast,
+		so that no attitude matrix is built; matrix and angles are derived on demand
+		
+	uses:
+		fsnav->imu->t
+		fsnav->imu->f
+		fsnav->imu->f_valid
+		fsnav->imu->w
+		fsnav->imu->w_valid
+		fsnav->imu->W
+		fsnav->imu->W_valid
+		fsnav->imu->sol.q (fsnav_sol_get_q)
+		fsnav->imu->sol.q_valid
+		fsnav->imu->sol.llh
+		fsnav->imu->sol.llh_valid
+		fsnav->imu->geo (fsnav_imu_get_geo)
+
+	changes:
+		fsnav->imu->sol.q
+		fsnav->imu->sol.q_valid
+
+	cfg parameters:
+		{imu: madgwick_feedback_rate} - feedback rate beta, degrees per second, ~sqrt(3)*(residual gyroscope drift)
+			type :   floating point
+			range:   >= 0
+			default: 0 (no correction)
+			example: {imu: madgwick_feedback_rate = 0.003}
+		{imu: fast_math} - flag to derive attitude angles with polynomial approximations (fsnav_linal_mat2rpy_fast)
+			example: {imu: fast_math}
+*/
+void fsnav_ins_attitude_madgwick(void) {
+
+	const char 
+		fast_token[] = "fast_math",              // polynomial approximations flag name in configuration
+		beta_token[] = "madgwick_feedback_rate"; // feedback rate parameter name in configuration
+
+	static double t0   = -1; // previous time
+	static double beta =  0; // feedback rate, rad/s
+
+	char  *cfg_ptr;          // pointer to a substring
+	double 
+		   dt,	             // time step
+		   c[3],             // navigation frame rotation vector
+		  *q;                // pointer to attitude quaternion in solution
+	fsnav_geo *geo;          // geodetic terms shared on the bus
+	size_t i;                // common index variable
+
+
+	// check if imu data has been initialized
+	if (fsnav->imu == NULL)
+		return;
+
+	if (fsnav->mode == 0) {		// init
+
+		// drop validity flags
+		fsnav->imu->sol.  q_valid = 0;
+		fsnav->imu->sol.  L_valid = 0;
+		fsnav->imu->sol.rpy_valid = 0;
+		// identity quaternion, matrix and angles are derived on demand
+		for (i = 1, fsnav->imu->sol.q[0] = 1; i < 4; i++)
+			fsnav->imu->sol.q[i] = 0;
+		fsnav->imu->sol.  q_valid = 1;
+		fsnav->imu->sol.att_fast = (fsnav_locate_token(fast_token, fsnav->imu->cfg, fsnav->imu->cfglength, 0) != NULL);
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_Q);
+		// feedback rate
+		cfg_ptr = fsnav_locate_token(beta_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
+		beta = (cfg_ptr != NULL) ? atof(cfg_ptr)/fsnav->imu_const.rad2deg : 0;
+		if (!(beta >= 0) || !isfinite(beta))
+			beta = 0;
+		// reset previous time
+		t0 = -1;
+
+	}
+
+	else if (fsnav->mode < 0) {	// termination
+		// do nothing
+	}
+	else						// main cycle
+	{
+		// check for crucial data initialized
+		q = fsnav_sol_get_q(&(fsnav->imu->sol));
+		if (q == NULL || !fsnav->imu->w_valid || !fsnav->imu->f_valid)
+			return;
+		// time variables
+		if (t0 < 0) { // first touch
+			t0 = fsnav->imu->t;
+			return;
+		}
+		dt = fsnav->imu->t - t0;
+		t0 = fsnav->imu->t;
+		// c = (W + u)*dt
+		for (i = 0; i < 3; i++)
+			c[i] = fsnav->imu->W_valid ? fsnav->imu->W[i] : 0;
+		if (fsnav->imu->sol.llh_valid) {
+			geo = fsnav_imu_get_geo(fsnav->imu);
+			c[1] += geo->u[1];
+			c[2] += geo->u[2];
+		}
+		for (i = 0; i < 3; i++)
+			c[i] *= dt;
+		// quaternion update
+		fsnav_ins_attitude_madgwick_update(q, fsnav->imu->w, fsnav->imu->f, c, dt, beta);
+		fsnav->imu->sol.q_valid = 1;
+		// attitude matrix and angles are derived on demand
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_Q);
+
+	}
+
+}
+
+/* fsnav_ins_attitude_madgwick_batch - batch variant of fsnav_ins_attitude_madgwick
+	
+	Processes a block of samples, e.g. filled by a block input plugin or read by a host for post-processing, 
+	without bus steps in between.
+
+	input:
+		double*           q       --- pointer to 4x1 attitude quaternion at the time t0
+		fsnav_imu_sample* samples --- pointer to a block of samples: t, w, f and their validity flags are used
+		const size_t      n       --- number of samples in the block
+		double*           t0      --- pointer to the time of q, negative when unknown (the first valid sample only sets the time)
+		const double      beta    --- feedback rate, rad/s
+		double*           W       --- pointer to 3x1 angular rate of navigation frame relative to inertial space (W + u), 
+		                              assumed constant over the block, NULL for none
+	output:
+		double*           q       --- pointer to 4x1 attitude quaternion at the time of the last valid sample
+		fsnav_imu_sample* samples --- sol.q, sol.q_valid of each sample, with matrix and angles marked to be derived on demand
+		double*           t0      --- pointer to the time of the last valid sample
+	note:
+		samples with invalid time, angular rate or specific force keep the previous quaternion
+*/
+void fsnav_ins_attitude_madgwick_batch(double* q, fsnav_imu_sample* samples, const size_t n, double* t0, const double beta, double* W)
+{
+	double dt, c[3];
+	size_t k, i;
+	fsnav_imu_sample *s;
+
+	for (k = 0; k < n; k++) {
+		s = samples + k;
+		if (s->t_valid && s->w_valid && s->f_valid) {
+			if (*t0 >= 0) {
+				dt = s->t - *t0;
+				for (i = 0; i < 3; i++)
+					c[i] = (W != NULL) ? W[i]*dt : 0;
+				fsnav_ins_attitude_madgwick_update(q, s->w, s->f, c, dt, beta);
+			}
+			*t0 = s->t;
+		}
+		for (i = 0; i < 4; i++)
+			s->sol.q[i] = q[i];
+		s->sol.q_valid = 1;
+		fsnav_sol_set_att(&(s->sol), FSNAV_SOL_Q);
+	}
+}
+
+/* fsnav_ins_attitude_mahony - fsnav plugin with separate callbacks (fsnav->add_plugin_ext)
+	
+	Propagates attitude quaternion with Mahony proportional-integral complementary correction 
+	towards the specific force direction, which is assumed to be vertical.
+	Uses only multiply-adds and one quaternion normalization per sample.
+	Recommended for low-cost MEMS sensors, when only roll and pitch are to be kept bounded without aiding.
+	The filter state is kept in a context, so that several filters may run on the bus at once:
+	
+		static fsnav_ins_attitude_mahony_state mahony;
+		fsnav->add_plugin_ext(fsnav_ins_attitude_mahony_init, fsnav_ins_attitude_mahony, NULL, &mahony);
+
+	description:
+		
+		q(t+dt) = c~ x (q(t) + q(t) x [0 w']*dt/2),  then normalized
+		
+		where
+		w' = w + kp*e + b,  b(t+dt) = b(t) + ki*e*dt
+		e  = (f/ge) x v,    v = [ 2*(q1*q3 - q0*q2)   2*(q0*q1 + q2*q3)   1 - 2*(q1*q1 + q2*q2) ]^T
+		x is quaternion or cross product, c~ is conjugate quaternion,
+		c = [cos(|c|/2) c*sin(|c|/2)/|c|] for c = (W + u)*dt (navigation frame rotation, as in fsnav_ins_attitude_madgwick),
+		v is the third column of L(q), the navigation vertical in the instrumental frame, as estimated,
+		ge is the normal gravity at the equator: the specific force is scaled by a constant instead of being normalized,
+		so the correction weakens or strengthens in proportion to |f|/ge and no square root is taken;
+		the quaternion is renormalized by fsnav_linal_qnormalize (Newton step, no square root near unit norm),
+		Earth rate projections are taken from the geodetic terms shared on the bus (fsnav_imu_get_geo),
+		matrix and angles are derived on demand
+		
+	uses:
+		fsnav->imu->t
+		fsnav->imu->f
+		fsnav->imu->f_valid
+		fsnav->imu->w
+		fsnav->imu->w_valid
+		fsnav->imu->W
+		fsnav->imu->W_valid
+		fsnav->imu->sol.q (fsnav_sol_get_q)
+		fsnav->imu->sol.q_valid
+		fsnav->imu->sol.llh
+		fsnav->imu->sol.llh_valid
+		fsnav->imu->geo (fsnav_imu_get_geo)
+		fsnav->imu_const.ge
+
+	changes:
+		fsnav->imu->sol.q
+		fsnav->imu->sol.q_valid
+
+	context:
+		fsnav_ins_attitude_mahony_state (gains, integral correction, previous time), set up by the init callback
+
+	cfg parameters:
+		{imu: mahony_kp} - proportional gain, 1/s, sets the time constant 1/kp of roll and pitch correction
+			type :   floating point
+			range:   >= 0
+			default: 0 (no correction)
+			example: {imu: mahony_kp = 0.1}
+		{imu: mahony_ki} - integral gain, 1/s^2, estimates gyroscope drift in b
+			type :   floating point
+			range:   >= 0
+			default: 0 (no drift estimation)
+			example: {imu: mahony_ki = 0.001}
+		{imu: fast_math} - flag to derive attitude angles with polynomial approximations (fsnav_linal_mat2rpy_fast)
+			example: {imu: fast_math}
+*/
+void fsnav_ins_attitude_mahony_init(void* state) {
+
+	const char 
+		fast_token[] = "fast_math", // polynomial approximations flag name in configuration
+		kp_token  [] = "mahony_kp", // proportional gain parameter name in configuration
+		ki_token  [] = "mahony_ki"; // integral gain parameter name in configuration
+
+	fsnav_ins_attitude_mahony_state *s = (fsnav_ins_attitude_mahony_state*)state;
+
+	char  *cfg_ptr;          // pointer to a substring
+	size_t i;                // common index variable
+
+
+	// check if imu data has been initialized
+	if (fsnav->imu == NULL)
+		return;
+
+	// drop validity flags
+	fsnav->imu->sol.  q_valid = 0;
+	fsnav->imu->sol.  L_valid = 0;
+	fsnav->imu->sol.rpy_valid = 0;
+	// identity quaternion, matrix and angles are derived on demand
+	for (i = 1, fsnav->imu->sol.q[0] = 1; i < 4; i++)
+		fsnav->imu->sol.q[i] = 0;
+	fsnav->imu->sol.  q_valid = 1;
+	fsnav->imu->sol.att_fast = (fsnav_locate_token(fast_token, fsnav->imu->cfg, fsnav->imu->cfglength, 0) != NULL);
+	fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_Q);
+	// gains, scaled by 1/ge to use the specific force without normalization
+	cfg_ptr = fsnav_locate_token(kp_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
+	s->kp = (cfg_ptr != NULL) ? atof(cfg_ptr) : 0;
+	if (!(s->kp >= 0) || !isfinite(s->kp))
+		s->kp = 0;
+	cfg_ptr = fsnav_locate_token(ki_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
+	s->ki = (cfg_ptr != NULL) ? atof(cfg_ptr) : 0;
+	if (!(s->ki >= 0) || !isfinite(s->ki))
+		s->ki = 0;
+	s->kp /= fsnav->imu_const.ge;
+	s->ki /= fsnav->imu_const.ge;
+	// reset integral correction and previous time
+	for (i = 0; i < 3; i++)
+		s->b[i] = 0;
+	s->t0 = -1;
+
+}
+
+void fsnav_ins_attitude_mahony(void* state) {
+
+	fsnav_ins_attitude_mahony_state *s = (fsnav_ins_attitude_mahony_state*)state;
+
+	double 
+		   dt,	             // time step
+		   c[3],             // navigation frame rotation vector
+		  *q;                // pointer to attitude quaternion in solution
+	fsnav_geo *geo;          // geodetic terms shared on the bus
+	size_t i;                // common index variable
+
+
+	// check if imu data has been initialized
+	if (fsnav->imu == NULL)
+		return;
+	// check for crucial data initialized
+	q = fsnav_sol_get_q(&(fsnav->imu->sol));
+	if (q == NULL || !fsnav->imu->w_valid || !fsnav->imu->f_valid)
+		return;
+	// time variables
+	if (s->t0 < 0) { // first touch
+		s->t0 = fsnav->imu->t;
+		return;
+	}
+	dt = fsnav->imu->t - s->t0;
+	s->t0 = fsnav->imu->t;
+	// c = (W + u)*dt
+	for (i = 0; i < 3; i++)
+		c[i] = fsnav->imu->W_valid ? fsnav->imu->W[i] : 0;
+	if (fsnav->imu->sol.llh_valid) {
+		geo = fsnav_imu_get_geo(fsnav->imu);
+		c[1] += geo->u[1];
+		c[2] += geo->u[2];
+	}
+	for (i = 0; i < 3; i++)
+		c[i] *= dt;
+	// quaternion update
+	fsnav_ins_attitude_mahony_update(q, s->b, fsnav->imu->w, fsnav->imu->f, c, dt, s->kp, s->ki);
+	fsnav->imu->sol.q_valid = 1;
+	// attitude matrix and angles are derived on demand
+	fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_Q);
+
+}
+
+// service functions
+	/*
+		Madgwick filter update for one sample, gravity-only objective function
+		input:
+			double*      q    --- pointer to 4x1 attitude quaternion
+			double*      w    --- pointer to 3x1 angular rate
+			double*      f    --- pointer to 3x1 specific force
+			double*      c    --- pointer to 3x1 navigation frame rotation vector over the time step
+			const double dt   --- time step
+			const double beta --- feedback rate
+		output:
+			double*      q    --- pointer to updated 4x1 attitude quaternion
+	*/
+void fsnav_ins_attitude_madgwick_update(double* q, double* w, double* f, double* c, const double dt, const double beta)
+{
+	const double epsilon = 1.0/1048576; // 2^-20 ~ 1e-6, guards normalization of a zero gradient
+
+	double 
+		a[3],    // specific force direction
+		F[3],    // objective function
+		g[4],    // gradient
+		p[4],    // quaternion derivative, navigation frame rotation quaternion
+		r[4],    // intermediate quaternion
+		k;       // normalization factor
+	size_t i;
+
+	// q x [0 w]/2
+	p[0] = (- q[1]*w[0] - q[2]*w[1] - q[3]*w[2])/2;
+	p[1] = (  q[0]*w[0] + q[2]*w[2] - q[3]*w[1])/2;
+	p[2] = (  q[0]*w[1] + q[3]*w[0] - q[1]*w[2])/2;
+	p[3] = (  q[0]*w[2] + q[1]*w[1] - q[2]*w[0])/2;
+	// gradient correction
+	k = f[0]*f[0] + f[1]*f[1] + f[2]*f[2];
+	if (beta > 0 && k > 0) {
+		// specific force direction
+		k = 1/sqrt(k);
+		for (i = 0; i < 3; i++)
+			a[i] = f[i]*k;
+		// objective function
+		F[0] = 2*(q[1]*q[3] - q[0]*q[2])     - a[0];
+		F[1] = 2*(q[0]*q[1] + q[2]*q[3])     - a[1];
+		F[2] = 1 - 2*(q[1]*q[1] + q[2]*q[2]) - a[2];
+		// gradient J^T*F
+		g[0] = -2*q[2]*F[0] + 2*q[1]*F[1];
+		g[1] =  2*q[3]*F[0] + 2*q[0]*F[1] - 4*q[1]*F[2];
+		g[2] = -2*q[0]*F[0] + 2*q[3]*F[1] - 4*q[2]*F[2];
+		g[3] =  2*q[1]*F[0] + 2*q[2]*F[1];
+		// normalized gradient step
+		k = beta/2/(epsilon + sqrt(g[0]*g[0] + g[1]*g[1] + g[2]*g[2] + g[3]*g[3]));
+		for (i = 0; i < 4; i++)
+			p[i] -= k*g[i];
+	}
+	// integration
+	for (i = 0; i < 4; i++)
+		r[i] = q[i] + p[i]*dt;
+	// navigation frame rotation, q = c~ x q
+	fsnav_linal_eul2quat_fast(p, c);
+	fsnav_linal_qmul1C(q, p, r);
+	// norm
+	fsnav_linal_qnormalize(q);
+}
+
+	/*
+		Mahony filter update for one sample
+		input:
+			double*      q    --- pointer to 4x1 attitude quaternion
+			double*      b    --- pointer to 3x1 integral correction
+			double*      w    --- pointer to 3x1 angular rate
+			double*      f    --- pointer to 3x1 specific force
+			double*      c    --- pointer to 3x1 navigation frame rotation vector over the time step
+			const double dt   --- time step
+			const double kp   --- proportional gain divided by the nominal specific force magnitude
+			const double ki   --- integral gain divided by the nominal specific force magnitude
+		output:
+			double*      q    --- pointer to updated 4x1 attitude quaternion
+			double*      b    --- pointer to updated 3x1 integral correction
+	*/
+void fsnav_ins_attitude_mahony_update(double* q, double* b, double* w, double* f, double* c, const double dt, const double kp, const double ki)
+{
+	double 
+		v[3],    // estimated vertical in the instrumental frame
+		e[3],    // correction axis f x v
+		a[3],    // corrected angular rate times dt/2
+		p[4],    // navigation frame rotation quaternion
+		r[4];    // intermediate quaternion
+	size_t i;
+
+	// estimated vertical, the third column of L(q)
+	v[0] = 2*(q[1]*q[3] - q[0]*q[2]);
+	v[1] = 2*(q[0]*q[1] + q[2]*q[3]);
+	v[2] = 1 - 2*(q[1]*q[1] + q[2]*q[2]);
+	// correction axis
+	e[0] = f[1]*v[2] - f[2]*v[1];
+	e[1] = f[2]*v[0] - f[0]*v[2];
+	e[2] = f[0]*v[1] - f[1]*v[0];
+	// integral and proportional corrections
+	for (i = 0; i < 3; i++) {
+		b[i] += ki*e[i]*dt;
+		a[i]  = (w[i] + kp*e[i] + b[i])*dt/2;
+	}
+	// integration, q + q x [0 w']*dt/2
+	r[0] = q[0] - q[1]*a[0] - q[2]*a[1] - q[3]*a[2];
+	r[1] = q[1] + q[0]*a[0] + q[2]*a[2] - q[3]*a[1];
+	r[2] = q[2] + q[0]*a[1] + q[3]*a[0] - q[1]*a[2];
+	r[3] = q[3] + q[0]*a[2] + q[1]*a[1] - q[2]*a[0];
+	// navigation frame rotation, q = c~ x q
+	fsnav_linal_eul2quat_fast(p, c);
+	fsnav_linal_qmul1C(q, p, r);
+	// norm
+	fsnav_linal_qnormalize(q);
+}
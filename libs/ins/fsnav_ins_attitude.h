@@ -4,4 +4,16 @@
 	fsnav plugins for ins angular rate integration:
 */
 void fsnav_ins_attitude_rodrigues(void); // via Euler vector using Rodrigues' rotation formula
+void fsnav_ins_attitude_quaternion(void); // via incremental quaternion products
+void fsnav_ins_attitude_coning   (void); // via coning compensated Euler vector accumulated over several samples using Rodrigues' rotation formula
 void fsnav_ins_attitude_madgwick (void); // via Madgwick filter fused with accelerometer data
+void fsnav_ins_attitude_madgwick_batch(double* q, fsnav_imu_sample* samples, const size_t n, double* t0, const double beta, double* W); // Madgwick filter over a block of samples, outside the bus
+	// Mahony complementary filter state, passed as a context to the plugin callbacks
+typedef struct {
+	double t0;   // previous time, negative to restart
+	double kp;   // proportional gain, 1/s, scaled by 1/ge
+	double ki;   // integral gain, 1/s^2, scaled by 1/ge
+	double b[3]; // integral correction, rad/s
+} fsnav_ins_attitude_mahony_state;
+void fsnav_ins_attitude_mahony_init(void* state); // via Mahony complementary filter fused with accelerometer data: init callback, context is fsnav_ins_attitude_mahony_state
+void fsnav_ins_attitude_mahony     (void* state); // via Mahony complementary filter fused with accelerometer data: step callback, context is fsnav_ins_attitude_mahony_state
@@ -12,24 +12,84 @@
 		Computes conventional Earth normal gravity model as in GRS80, etc.,
 		but takes Earth model constants from fsnav->imu_const variables.
 		Accounts for both latitude and altitude, as well as for plumb line curvature above ellipsoid.
+		Optionally updates gravity incrementally between exact evaluations.
 		Recommended for conventional navigation grade systems.
 
-	- (planned) fsnav_ins_gravity_egm08
-		Planned for future development.
+	- fsnav_ins_gravity_egm08
+		Adds gravity disturbance and deflection of the vertical, interpolated bilinearly 
+		over a regional grid precomputed from EGM2008 (scripts/gravity/egm08_grid.m), 
+		to the gravity vector calculated by a preceding model. The grid file is memory-mapped, 
+		so that only the tiles actually touched are loaded.
+		Recommended for navigation grade systems, when the normal gravity model error matters.
 	
 */
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 #include <math.h>
+#ifdef _WIN32
+	#define FSNAV_INS_GRAVITY_NO_MMAP // read the grid file into memory instead
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
 
 #include "../fsnav.h"
 
 // fsnav bus version check
-#define FSNAV_INS_GRAVITY_BUS_VERSION_REQUIRED 8
+#define FSNAV_INS_GRAVITY_BUS_VERSION_REQUIRED 20
 #if FSNAV_BUS_VERSION < FSNAV_INS_GRAVITY_BUS_VERSION_REQUIRED
 	#error "fsnav bus version check failed, consider fetching the latest version"
 #endif
 
+// EGM2008 grid file, as written by scripts/gravity/egm08_grid.m, little-endian;
+// the format version doubles as the byte order marker: grids written otherwise, or read on a host of other byte order, are rejected
+	/*
+		offset  type       description
+		 0      char[8]    signature "FSNAVEGM"
+		 8      int32      format version
+		12      int32      tile size T, nodes per tile side
+		16      int32      number of latitude nodes
+		20      int32      number of longitude nodes
+		24      double     latitude of the first node, degrees
+		32      double     longitude of the first node, degrees
+		40      double     latitude step, degrees
+		48      double     longitude step, degrees
+		56      double     height above ellipsoid the grid is computed at, meters
+		64      float[]    tiles of T x T nodes, row-major over tiles and over nodes within a tile,
+		                   each node holding gravity disturbance (mGal), deflection of the vertical 
+		                   in the meridian xi and in the prime vertical eta (arcseconds), 
+		                   edge tiles padded to full size
+	*/
+#define FSNAV_INS_GRAVITY_EGM08_SIGNATURE "FSNAVEGM" // grid file signature
+#define FSNAV_INS_GRAVITY_EGM08_VERSION   1          // grid file format version
+#define FSNAV_INS_GRAVITY_EGM08_HEADER    64         // grid file header size, bytes
+#define FSNAV_INS_GRAVITY_EGM08_LAYERS    3          // number of values per grid node
+
+	// memory-mapped grid with the current cell
+typedef struct {
+	unsigned char* map;  // mapped file, NULL if not loaded
+	size_t  size;        // mapped file size, bytes
+	float*  data;        // grid nodes
+	long    T;           // tile size, nodes per tile side
+	long    nlat, nlon;  // number of nodes
+	long    tlon;        // number of tiles per tile row
+	double  lat0, lon0;  // first node coordinates, rad
+	double  klat, klon;  // inverse steps, 1/rad
+	long    i, j;        // current cell, south-western node indices, -1 if none
+	double  c[FSNAV_INS_GRAVITY_EGM08_LAYERS][4]; // bilinear coefficients over the current cell: disturbance (m/s^2), xi, eta (rad)
+} fsnav_ins_gravity_grid;
+
+// service functions
+char   fsnav_ins_gravity_egm08_open (fsnav_ins_gravity_grid* grid, const char* filename);
+void   fsnav_ins_gravity_egm08_close(fsnav_ins_gravity_grid* grid);
+float* fsnav_ins_gravity_egm08_node (fsnav_ins_gravity_grid* grid, const long i, const long j);
+void   fsnav_ins_gravity_egm08_cell (fsnav_ins_gravity_grid* grid, const long i, const long j);
+
 /* fsnav_ins_gravity_constant - fsnav plugin
 	
 	Takes the magnitude of average accelerometer output vector 
@@ -128,6 +188,7 @@ void fsnav_ins_gravity_constant(void) {
 	Computes conventional Earth normal gravity model as in GRS80, etc.,
 	but takes Earth model constants from fsnav->imu_const variables.
 	Accounts for both latitude and altitude, as well as for plumb line curvature above ellipsoid.
+	Optionally updates gravity incrementally between exact evaluations.
 	Recommended for conventional navigation grade systems.
 
 	description:
@@ -148,10 +209,20 @@ void fsnav_ins_gravity_constant(void) {
 		- ge    is  Earth gravity at equator
 		- f     is  Earth ellipsoid flattening
 		- m, f4 are Earth gravity model auxiliary constants
+
+		incremental mode (tol > 0): the model is evaluated exactly at an anchor point (lat0, h0) 
+		together with its partial derivatives, then
+
+		g(lat, h) = g(lat0, h0) + dg/dlat*(lat - lat0) + dg/dh*(h - h0)
+
+		while |lat - lat0|*a <= tol and |h - h0| <= tol, and the anchor is moved otherwise;
+		g is linear in h, so the neglected terms are d2g/dlat2 and d2g/dlat/dh, 
+		which keep the error below 0.5*(tol/a)^2 m/s^2, e.g. 1.3e-8 m/s^2 for tol = 1000 m
 	
 	uses:
 		fsnav->imu->sol.llh
 		fsnav->imu->sol.llh_valid
+		fsnav->imu->geo (fsnav_imu_get_geo)
 		fsnav->sol.llh
 		fsnav->sol.llh_valid
 
@@ -160,23 +231,39 @@ void fsnav_ins_gravity_constant(void) {
 		fsnav->imu->g_valid
 
 	cfg parameters:
-		none
+		{imu: gravity_tolerance} - distance from the last exact evaluation to update gravity incrementally within, meters
+			type :   floating point
+			range:   >= 0
+			default: 0 (exact model at every sample)
+			example: {imu: gravity_tolerance = 100}
 */
 void fsnav_ins_gravity_normal(void) {
 
+	const char tol_token[] = "gravity_tolerance"; // incremental update tolerance parameter name in configuration
+
 	static double
 		f    = 0, // Earth ellipsoid flattening f = (a - b)/a
 		m    = 0, // gravitational parameter, m = [u^2 a^2 b]/[GM], ratio between centrifugal and gravitational accelerations on the equator of a shpere having the same mass and volume as the Earth does
-		f4_4 = 0; // coefficient for the second harmonic term, f4/4 = 5/2 f m - 1/2 f^2
-
+		f4_4 = 0, // coefficient for the second harmonic term, f4/4 = 5/2 f m - 1/2 f^2
+		tol  = 0, // incremental update tolerance, meters, 0 for exact model at every sample
+		lat0 = 0, // anchor latitude, where the model was evaluated exactly
+		h0   = 0, // anchor altitude
+		g0[3],    // gravity at the anchor point
+		dg[4];    // partial derivatives at the anchor point: dgN/dlat, dgN/dh, dgU/dlat, dgU/dh
+	static char src0 = 0; // anchor coordinates source: 1 - imu, 2 - hybrid solution, 3 - default, 0 - no anchor
+
+	char   src;       // coordinates source
 	double 
 		lat,	  // geographical latitude		
 		h,		  // geographical altitude from reference ellipsoid
 		sinlat,	  //   sine of latitude
 		sin2lat,  //   sine of twofold latitude
 		cos2lat,  // cosine of twofold latitude
+		P, Q,     // latitude and altitude factors of vertical component
 		h_a,	  // ratio between altitude and ellipsoid semimajor axis
 		b_a;	  // ratio between Earth ellipsoid semiminor and semimajor axes, b/a = sqrt(1 - e^2)
+	char  *cfg_ptr;   // pointer to a substring in configuration
+	fsnav_geo *geo;   // geodetic terms shared on the bus
 
 
 	// check if imu data has been initialized
@@ -201,6 +288,13 @@ void fsnav_ins_gravity_normal(void) {
 		m    = 1/(f4_4*(m+1.0/3) + m + 1);
 		// coefficient for the second harmonic term
 		f4_4 = f/8*(5*m - f); // f4 = -1/2 f^2 + 5/2 f m, as in (2-115), Physical Geodesy, W.Heiskanen H.Moritz, 1993, p. 76, or section 3 of Geodetic Reference System 80 by H. Moritz (GRS-80), corrected for skipped minus sign
+		// incremental update tolerance
+		cfg_ptr = fsnav_locate_token(tol_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
+		tol = (cfg_ptr != NULL) ? atof(cfg_ptr) : 0;
+		if (!(tol >= 0) || !isfinite(tol))
+			tol = 0;
+		// no anchor point yet
+		src0 = 0;
 
 	}
 
@@ -214,32 +308,389 @@ void fsnav_ins_gravity_normal(void) {
 		fsnav->imu->g_valid = 0;
 		// define latitude and altitude
 		if (fsnav->imu->sol.llh_valid) { // from imu data, if valid
+			src = 1;
 			lat = fsnav->imu->sol.llh[1];
 			h   = fsnav->imu->sol.llh[2];
 		}
 		else if (fsnav->sol.llh_valid) { // from hybrid solution, if valid
+			src = 2;
 			lat = fsnav->sol.llh[1];
 			h   = fsnav->sol.llh[2];
 		}
 		else {                          // default values
+			src = 3;
 			lat = fsnav->imu_const.pi/4; 
 			h   = 0;
 		}
-		sinlat  = sin(  lat);
-		sin2lat = sin(2*lat);
-		cos2lat = cos(2*lat);
+		// incremental update within tolerance from the anchor point
+		if (src == src0 && fabs(lat - lat0)*fsnav->imu_const.a <= tol && fabs(h - h0) <= tol) {
+			fsnav->imu->g[0] = 0;
+			fsnav->imu->g[1] = g0[1] + dg[0]*(lat - lat0) + dg[1]*(h - h0);
+			fsnav->imu->g[2] = g0[2] + dg[2]*(lat - lat0) + dg[3]*(h - h0);
+			fsnav->imu->g_valid = 1;
+			return;
+		}
+		// latitude terms, shared on the bus for imu coordinates
+		if (src == 1) {
+			geo     = fsnav_imu_get_geo(fsnav->imu);
+			sinlat  = geo->sphi;
+			sin2lat = geo->s2phi;
+			cos2lat = geo->c2phi;
+		}
+		else {
+			sinlat  = sin(  lat);
+			sin2lat = sin(2*lat);
+			cos2lat = cos(2*lat);
+		}
 		h_a = h/fsnav->imu_const.a;
 		// Eastern component - zero for normal gravity
 		fsnav->imu->g[0] = 0;
 		// Northern deflection with altitude above ellipsoid from plumb line curvature, as in (5-34), Physical Geodesy, W.Heiskanen H.Moritz, 1993, p. 196
 		fsnav->imu->g[1] = -fsnav->imu_const.fg*sin2lat*h_a;
 		// vertical component, as from section 3 of Geodetic Reference System 80 by H. Moritz (GRS-80)
-		fsnav->imu->g[2] = -fsnav->imu_const.ge*
-			(1 + fsnav->imu_const.fg*sinlat*sinlat - f4_4*sin2lat*sin2lat)*
-			(1 - 2*(1 + f*cos2lat + m)*h_a);
+		P = 1 + fsnav->imu_const.fg*sinlat*sinlat - f4_4*sin2lat*sin2lat;
+		Q = 1 - 2*(1 + f*cos2lat + m)*h_a;
+		fsnav->imu->g[2] = -fsnav->imu_const.ge*P*Q;
 		// validity flag up
 		fsnav->imu->g_valid = 1;
+		// new anchor point with partial derivatives
+		if (tol > 0) {
+			src0  = src;
+			lat0  = lat;
+			h0    = h;
+			g0[1] = fsnav->imu->g[1];
+			g0[2] = fsnav->imu->g[2];
+			dg[0] = -2*fsnav->imu_const.fg*cos2lat*h_a;
+			dg[1] = -fsnav->imu_const.fg*sin2lat/fsnav->imu_const.a;
+			dg[2] = -fsnav->imu_const.ge*((fsnav->imu_const.fg - 4*f4_4*cos2lat)*sin2lat*Q + P*4*f*sin2lat*h_a);
+			dg[3] =  fsnav->imu_const.ge*P*2*(1 + f*cos2lat + m)/fsnav->imu_const.a;
+		}
+
+	}
+
+}
+
+/* fsnav_ins_gravity_egm08 - fsnav plugin
+	
+	Adds gravity disturbance and deflection of the vertical, interpolated bilinearly 
+	over a regional grid precomputed from EGM2008 (scripts/gravity/egm08_grid.m), 
+	to the gravity vector calculated by a preceding model. The grid file is memory-mapped, 
+	so that only the tiles actually touched are loaded.
+	Recommended for navigation grade systems, when the normal gravity model error matters.
+
+	description:
+		to be placed after fsnav_ins_gravity_normal, which provides the normal gravity vector gamma;
+		if fsnav->imu->sol.llh coordinates are valid, takes them as the point to interpolate at
+		else if fsnav->sol (hybrid solution) coordinates are valid, uses them
+		otherwise, or outside the grid, leaves the gravity vector unchanged
+
+		g[0] = gE = gamma_E - |gamma|*eta
+		g[1] = gN = gamma_N - |gamma|*xi
+		g[2] = gU = gamma_U - dg
+
+		where
+
+		- dg    is  gravity disturbance, positive for gravity stronger than normal
+		- xi    is  deflection of the vertical in the meridian, astronomic minus geodetic latitude
+		- eta   is  deflection of the vertical in the prime vertical, astronomic minus geodetic longitude times cos(lat)
+		- |gamma| is approximated by -gamma_U
+
+		each value is interpolated as c0 + c1*x + (c2 + c3*x)*y, x, y being fractional node indices within the cell;
+		the coefficients are derived once per cell crossing, so that per-sample cost is a few multiply-adds;
+		grid values are taken at the grid height, the height dependence of the disturbance is neglected
+	
+	uses:
+		fsnav->imu->sol.llh
+		fsnav->imu->sol.llh_valid
+		fsnav->sol.llh
+		fsnav->sol.llh_valid
+		fsnav->imu->g
+		fsnav->imu->g_valid
+
+	changes:
+		fsnav->imu->g
+
+	cfg parameters:
+		{imu: egm08_grid} - grid file name, without spaces; 
+		                    the plugin is inactive without the parameter, and requests termination if the file is not a valid grid,
+		                    printing the reason: the file couldn't be opened, a signature, version, byte order, header or size mismatch
+			type :   string
+			example: {imu: egm08_grid = egm08_moscow.grd}
+*/
+void fsnav_ins_gravity_egm08(void) {
+
+	const char grid_token[] = "egm08_grid"; // grid file name parameter name in configuration
+
+	static fsnav_ins_gravity_grid grid = {NULL}; // memory-mapped grid
+
+	char  *cfg_ptr;      // pointer to a substring in configuration
+	char   filename[256]; // grid file name
+	double 
+		lat, lon,        // geographical coordinates
+		x, y,            // fractional node indices
+		d[FSNAV_INS_GRAVITY_EGM08_LAYERS], // interpolated disturbance and deflections
+		gamma;           // normal gravity magnitude
+	long   i, j;         // cell indices
+	size_t k;            // common index variable
+
+
+	// check if imu data has been initialized
+	if (fsnav->imu == NULL)
+		return;
+
+	if (fsnav->mode == 0) {		// init
+
+		fsnav_ins_gravity_egm08_close(&grid);
+		// grid file name, up to the closing brace of the configuration group
+		cfg_ptr = fsnav_locate_token(grid_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
+		if (cfg_ptr == NULL)
+			return;
+		if (sscanf(cfg_ptr, " %255[^ \t\r\n}]", filename) != 1) {
+			printf("error: couldn't parse EGM2008 grid file name.\n");
+			fsnav->mode = -1; // request termination, the configured grid is not available
+		}
+		else if (!fsnav_ins_gravity_egm08_open(&grid, filename))
+			fsnav->mode = -1; // request termination, the configured grid is not available, the reason is printed
+
+	}
+
+	else if (fsnav->mode < 0) {	// terminate
+		fsnav_ins_gravity_egm08_close(&grid);
+	}
+
+	else						// main cycle
+	{
+		// check for crucial data initialized
+		if (grid.map == NULL || !fsnav->imu->g_valid)
+			return;
+		// define latitude and longitude
+		if (fsnav->imu->sol.llh_valid) { // from imu data, if valid
+			lon = fsnav->imu->sol.llh[0];
+			lat = fsnav->imu->sol.llh[1];
+		}
+		else if (fsnav->sol.llh_valid) { // from hybrid solution, if valid
+			lon = fsnav->sol.llh[0];
+			lat = fsnav->sol.llh[1];
+		}
+		else
+			return;
+		// fractional node indices
+		lon -= grid.lon0;
+		if (lon < 0)
+			lon += 2*fsnav->imu_const.pi;
+		x = lon*grid.klon;
+		y = (lat - grid.lat0)*grid.klat;
+		if (!(x >= 0 && x < grid.nlon - 1 && y >= 0 && y < grid.nlat - 1)) // outside the grid
+			return;
+		// cell
+		i = (long)y;
+		j = (long)x;
+		if (i != grid.i || j != grid.j)
+			fsnav_ins_gravity_egm08_cell(&grid, i, j);
+		x -= j;
+		y -= i;
+		// bilinear interpolation
+		for (k = 0; k < FSNAV_INS_GRAVITY_EGM08_LAYERS; k++)
+			d[k] = grid.c[k][0] + grid.c[k][1]*x + (grid.c[k][2] + grid.c[k][3]*x)*y;
+		// disturbing gravity vector
+		gamma = -fsnav->imu->g[2];
+		fsnav->imu->g[0] -= gamma*d[2];
+		fsnav->imu->g[1] -= gamma*d[1];
+		fsnav->imu->g[2] -= d[0];
+
+	}
 
+}
+
+// service functions
+	/*
+		map EGM2008 grid file and check its header
+		input:
+			fsnav_ins_gravity_grid* grid     --- pointer to a grid structure
+			const char*             filename --- grid file name
+		output:
+			fsnav_ins_gravity_grid* grid     --- grid structure with the file mapped, no current cell
+		return value:
+			1 if successful
+			0 otherwise, with an error message printed
+		note:
+			the version is decoded from its bytes in both orders to tell a grid of other byte order from a host of other byte order
+	*/
+char fsnav_ins_gravity_egm08_open(fsnav_ins_gravity_grid* grid, const char* filename)
+{
+	const double deg2rad = 3.14159265358979323846264338327950288/180; // pi/180
+
+	int32_t n[4];    // format version, tile size, number of latitude and longitude nodes
+	double  v[5];    // first node coordinates, steps, height
+	unsigned char *b;        // format version bytes
+	unsigned long  le, be;   // format version decoded as little-endian and big-endian
+	size_t  tiles;   // number of tiles
+#ifdef FSNAV_INS_GRAVITY_NO_MMAP
+	FILE   *fp;
+#else
+	int     fd;
+	struct stat st;
+#endif
+
+	grid->map = NULL;
+	grid->i   = -1;
+	grid->j   = -1;
+	// map the file
+#ifdef FSNAV_INS_GRAVITY_NO_MMAP
+	fp = fopen(filename, "rb");
+	if (fp == NULL) {
+		printf("error: couldn't open EGM2008 grid '%s'.\n", filename);
+		return 0;
+	}
+	if (fseek(fp, 0, SEEK_END) != 0 || ftell(fp) < FSNAV_INS_GRAVITY_EGM08_HEADER) {
+		printf("error: EGM2008 grid '%s' is shorter than its %d-byte header.\n", filename, FSNAV_INS_GRAVITY_EGM08_HEADER);
+		fclose(fp);
+		return 0;
+	}
+	grid->size = (size_t)ftell(fp);
+	grid->map  = (unsigned char*)malloc(grid->size);
+	rewind(fp);
+	if (grid->map == NULL || fread(grid->map, 1, grid->size, fp) != grid->size) {
+		printf("error: couldn't read EGM2008 grid '%s'.\n", filename);
+		fclose(fp);
+		fsnav_ins_gravity_egm08_close(grid);
+		return 0;
+	}
+	fclose(fp);
+#else
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		printf("error: couldn't open EGM2008 grid '%s'.\n", filename);
+		return 0;
+	}
+	if (fstat(fd, &st) != 0 || st.st_size < FSNAV_INS_GRAVITY_EGM08_HEADER) {
+		printf("error: EGM2008 grid '%s' is shorter than its %d-byte header.\n", filename, FSNAV_INS_GRAVITY_EGM08_HEADER);
+		close(fd);
+		return 0;
+	}
+	grid->size = (size_t)st.st_size;
+	grid->map  = (unsigned char*)mmap(NULL, grid->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping stays valid
+	if (grid->map == (unsigned char*)MAP_FAILED) {
+		printf("error: couldn't map EGM2008 grid '%s'.\n", filename);
+		grid->map = NULL;
+		return 0;
+	}
+#endif
+	// header
+	memcpy(n, grid->map +  8, sizeof(n));
+	memcpy(v, grid->map + 24, sizeof(v));
+	b  = grid->map + 8;
+	le = (unsigned long)b[0] | (unsigned long)b[1] << 8 | (unsigned long)b[2] << 16 | (unsigned long)b[3] << 24;
+	be = (unsigned long)b[3] | (unsigned long)b[2] << 8 | (unsigned long)b[1] << 16 | (unsigned long)b[0] << 24;
+	if (memcmp(grid->map, FSNAV_INS_GRAVITY_EGM08_SIGNATURE, 8) != 0) {
+		printf("error: '%s' is not an EGM2008 grid, no %s signature.\n", filename, FSNAV_INS_GRAVITY_EGM08_SIGNATURE);
+		fsnav_ins_gravity_egm08_close(grid);
+		return 0;
+	}
+	if (le != FSNAV_INS_GRAVITY_EGM08_VERSION) {
+		if (be == FSNAV_INS_GRAVITY_EGM08_VERSION)
+			printf("error: EGM2008 grid '%s' is big-endian, little-endian expected.\n", filename);
+		else
+			printf("error: EGM2008 grid '%s' has format version %lu, %d expected.\n", filename, le, FSNAV_INS_GRAVITY_EGM08_VERSION);
+		fsnav_ins_gravity_egm08_close(grid);
+		return 0;
 	}
+	if (n[0] != FSNAV_INS_GRAVITY_EGM08_VERSION) {
+		printf("error: EGM2008 grid '%s' is little-endian, the host byte order differs.\n", filename);
+		fsnav_ins_gravity_egm08_close(grid);
+		return 0;
+	}
+	if (n[1] < 1 || n[2] < 2 || n[3] < 2 || !(v[2] > 0) || !(v[3] > 0)) {
+		printf("error: EGM2008 grid '%s' header mismatch: tile size %ld, %ld x %ld nodes, steps %g x %g deg.\n", 
+			filename, (long)n[1], (long)n[2], (long)n[3], v[2], v[3]);
+		fsnav_ins_gravity_egm08_close(grid);
+		return 0;
+	}
+	grid->T    = n[1];
+	grid->nlat = n[2];
+	grid->nlon = n[3];
+	grid->tlon = (grid->nlon + grid->T - 1)/grid->T;
+	tiles      = (size_t)((grid->nlat + grid->T - 1)/grid->T)*grid->tlon;
+	if ((grid->size - FSNAV_INS_GRAVITY_EGM08_HEADER)/(sizeof(float)*FSNAV_INS_GRAVITY_EGM08_LAYERS)/grid->T/grid->T < tiles) { // truncated
+		printf("error: EGM2008 grid '%s' size mismatch: %lu bytes, %.0f expected for %ld x %ld nodes in %ld x %ld tiles.\n", 
+			filename, (unsigned long)grid->size, 
+			FSNAV_INS_GRAVITY_EGM08_HEADER + (double)tiles*grid->T*grid->T*FSNAV_INS_GRAVITY_EGM08_LAYERS*sizeof(float), 
+			grid->nlat, grid->nlon, grid->T, grid->T);
+		fsnav_ins_gravity_egm08_close(grid);
+		return 0;
+	}
+	grid->data = (float*)(grid->map + FSNAV_INS_GRAVITY_EGM08_HEADER);
+	grid->lat0 = v[0]*deg2rad;
+	grid->lon0 = v[1]*deg2rad;
+	grid->klat = 1/(v[2]*deg2rad);
+	grid->klon = 1/(v[3]*deg2rad);
 
+	return 1;
+}
+
+	/*
+		unmap EGM2008 grid file
+		input:
+			fsnav_ins_gravity_grid* grid --- pointer to a grid structure
+	*/
+void fsnav_ins_gravity_egm08_close(fsnav_ins_gravity_grid* grid)
+{
+	if (grid->map != NULL)
+#ifdef FSNAV_INS_GRAVITY_NO_MMAP
+		free(grid->map);
+#else
+		munmap(grid->map, grid->size);
+#endif
+	grid->map = NULL;
+	grid->i   = -1;
+	grid->j   = -1;
+}
+
+	/*
+		locate grid node values within tiles
+		input:
+			fsnav_ins_gravity_grid* grid --- pointer to a grid structure
+			const long              i    --- latitude node index
+			const long              j    --- longitude node index
+		return value:
+			pointer to node values: gravity disturbance (mGal), xi and eta (arcseconds)
+	*/
+float* fsnav_ins_gravity_egm08_node(fsnav_ins_gravity_grid* grid, const long i, const long j)
+{
+	return grid->data + FSNAV_INS_GRAVITY_EGM08_LAYERS*(
+		((i/grid->T)*grid->tlon + j/grid->T)*grid->T*grid->T + (i%grid->T)*grid->T + j%grid->T);
+}
+
+	/*
+		derive bilinear interpolation coefficients over a grid cell
+		input:
+			fsnav_ins_gravity_grid* grid --- pointer to a grid structure
+			const long              i    --- latitude index of the south-western node
+			const long              j    --- longitude index of the south-western node
+		output:
+			fsnav_ins_gravity_grid* grid --- current cell and its coefficients, in m/s^2 and radians
+	*/
+void fsnav_ins_gravity_egm08_cell(fsnav_ins_gravity_grid* grid, const long i, const long j)
+{
+	const double scale[FSNAV_INS_GRAVITY_EGM08_LAYERS] = { // mGal to m/s^2, arcseconds to radians
+		1e-5, 
+		3.14159265358979323846264338327950288/180/3600, 
+		3.14159265358979323846264338327950288/180/3600 };
+
+	float  *f00, *f01, *f10, *f11; // cell corner nodes, [latitude][longitude]
+	size_t  k;
+
+	f00 = fsnav_ins_gravity_egm08_node(grid, i    , j    );
+	f01 = fsnav_ins_gravity_egm08_node(grid, i    , j + 1);
+	f10 = fsnav_ins_gravity_egm08_node(grid, i + 1, j    );
+	f11 = fsnav_ins_gravity_egm08_node(grid, i + 1, j + 1);
+	for (k = 0; k < FSNAV_INS_GRAVITY_EGM08_LAYERS; k++) {
+		grid->c[k][0] = scale[k]*f00[k];
+		grid->c[k][1] = scale[k]*((double)f01[k] - f00[k]);
+		grid->c[k][2] = scale[k]*((double)f10[k] - f00[k]);
+		grid->c[k][3] = scale[k]*((double)f11[k] - f10[k] - f01[k] + f00[k]);
+	}
+	grid->i = i;
+	grid->j = j;
 }
@@ -5,4 +5,4 @@
 */
 void fsnav_ins_gravity_constant(void); // magnitude of average accelerometer output vector as constant gravity value
 void fsnav_ins_gravity_normal  (void); // conventional Earth normal gravity model
-void fsnav_ins_gravity_egm08   (void); // planned for future development
+void fsnav_ins_gravity_egm08   (void); // gravity disturbance and deflection of the vertical from a memory-mapped EGM2008 grid, added to a preceding model
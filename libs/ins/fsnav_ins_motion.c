@@ -9,8 +9,10 @@
 		Updates velocity and geographical coordinates. 
 		Not suitable near the Earth's poles, at outer-space altitudes, and/or over-Mach velocities.
 		
-	- (planned) fsnav_ins_motion_sculling
-		Planned for future development
+	- fsnav_ins_motion_sculling
+		Reads rotation and sculling compensated velocity increments pre-integrated on the fsnav bus at the full sensor rate,
+		so that velocity and geographical coordinates are updated at a lower configurable rate. 
+		Not suitable near the Earth's poles, at outer-space altitudes, and/or over-Mach velocities.
 		
 	- fsnav_ins_motion_vertical_damping
 		Restrains vertical error exponential growth by either damping
@@ -25,7 +27,7 @@
 #include "../fsnav.h"
 
 // fsnav bus version check
-#define FSNAV_INS_MOTION_BUS_VERSION_REQUIRED 8
+#define FSNAV_INS_MOTION_BUS_VERSION_REQUIRED 20
 #if FSNAV_BUS_VERSION < FSNAV_INS_MOTION_BUS_VERSION_REQUIRED
 	#error "fsnav bus version check failed, consider fetching the latest version"
 #endif
@@ -33,6 +35,8 @@
 // service functions
 double fsnav_ins_motion_parse_double(const char *token, char *src, const size_t len, double range[2], const double default_value);
 void   fsnav_ins_motion_flip_sol_over_pole(fsnav_sol *sol);
+void   fsnav_ins_motion_nav_rate(double *sphi, double *cphi, double *Rn_h, double *Re_h);
+void   fsnav_ins_motion_llh_update(double *v, const double cphi, const double Rn_h, const double Re_h, const double dt);
 
 /* fsnav_ins_motion_euler - fsnav plugin
 	
@@ -61,9 +65,10 @@ void   fsnav_ins_motion_flip_sol_over_pole(fsnav_sol *sol);
 		fsnav->imu->t
 		fsnav->imu->sol.llh
 		fsnav->imu->sol.llh_valid
+		fsnav->imu->geo (fsnav_imu_get_geo)
 		fsnav->imu->sol.v
 		fsnav->imu->sol.v_valid
-		fsnav->imu->sol.L
+		fsnav->imu->sol.L (fsnav_sol_get_L)
 		fsnav->imu->sol.L_valid
 		fsnav->imu->f
 		fsnav->imu->f_valid
@@ -96,30 +101,33 @@ void   fsnav_ins_motion_flip_sol_over_pole(fsnav_sol *sol);
 			range:   -20000..+50000
 			default: 0
 			example: {imu: alt = 151.3}
+		{imu: fast_math} - flag to use polynomial approximations instead of libm trigonometry (fsnav_linal_eul2mat_fast)
+			example: {imu: fast_math}
 */
 void fsnav_ins_motion_euler(void) {
 
 	const char 
 		lon_token[] = "lon",        // starting longitude parameter name in configuration
 		lat_token[] = "lat",        // starting latitude  parameter name in configuration
-		alt_token[] = "alt";        // starting altitude  parameter name in configuration
+		alt_token[] = "alt",        // starting altitude  parameter name in configuration
+		fast_token[] = "fast_math"; // polynomial approximations flag name in configuration
 
 	const double 
 		lon_range[] = {-180, +180},	// longitude range, 0 by default
 		lat_range[] = { -90,  +90},	// latitude  range, 0 by default
-		alt_range[] = {-20e3,50e3},	// altitude  range, 0 by default
-		eps = 1.0/0x0100;			// 2^-8, guaranteed non-zero value in IEEE754 half-precision format
+		alt_range[] = {-20e3,50e3};	// altitude  range, 0 by default
 
 	static double t0  = -1;         // previous time
+	static void (*eul2mat)(double*, double*) = fsnav_linal_eul2mat; // rotation vector to matrix routine
 
 	double dt;                      // time step
 	double
 		sphi, cphi,	                // sine and cosine of latitude
 		Rn_h, Re_h,	                // south-to-north and east-to-west curvature radii, altitude-adjusted
-		e2s2, e4s4,	                // e^2*sin(phi)^2, (e^2*sin(phi)^2)^2
 		dvrel[3],	                // proper acceleration in navigation frame
 		dvcor[3],	                // Coriolis acceleration in navigation frame
-		C_2[9];                     // intermediate matrix/vector for modified Euler component
+		C_2[9],                     // intermediate matrix/vector for modified Euler component
+		*L;                         // pointer to attitude matrix in solution, derived on demand
 	size_t i, j;                    // common index variables
 
 
@@ -149,6 +157,8 @@ void fsnav_ins_motion_euler(void) {
 		fsnav->imu->sol.v_valid = 1;
 		// reset previous time
 		t0 = -1;
+		// libm-based or fast routines
+		eul2mat = (fsnav_locate_token(fast_token, fsnav->imu->cfg, fsnav->imu->cfglength, 0) != NULL) ? fsnav_linal_eul2mat_fast : fsnav_linal_eul2mat;
 
 	}
 
@@ -159,9 +169,10 @@ void fsnav_ins_motion_euler(void) {
 	else						// main cycle
 	{
 		// check for crucial data initialized
+		L = fsnav_sol_get_L(&(fsnav->imu->sol));
 		if (   !fsnav->imu->sol.  v_valid 
 			|| !fsnav->imu->sol.llh_valid 
-			|| !fsnav->imu->sol.  L_valid 
+			|| L == NULL 
 			|| !fsnav->imu->f_valid 
 			|| !fsnav->imu->g_valid)
 			return;
@@ -172,29 +183,11 @@ void fsnav_ins_motion_euler(void) {
 		}
 		dt = fsnav->imu->t - t0;
 		t0 = fsnav->imu->t;
-		// ellipsoid geometry
-		sphi = sin(fsnav->imu->sol.llh[1]);
-		cphi = cos(fsnav->imu->sol.llh[1]);
-		e2s2 = fsnav->imu_const.e2*sphi*sphi;
-		e4s4 = e2s2*e2s2;					
-		Re_h = fsnav->imu_const.a*(1 + e2s2/2 + 3*e4s4/8);	                                        // Taylor expansion within 0.5 m, not altitude-adjusted
-		Rn_h = Re_h*(1 - fsnav->imu_const.e2)*(1 + e2s2 + e4s4 + e2s2*e4s4) + fsnav->imu->sol.llh[2]; // Taylor expansion within 0.5 m
-		Re_h += fsnav->imu->sol.llh[2];						                                        // adjust for altitude
 		// drop validity flags
-		fsnav->imu->W_valid       = 0;
 		fsnav->imu->sol.llh_valid = 0;
 		fsnav->imu->sol.  v_valid = 0;
-		// angular rate of navigation frame relative to the Earth
-		fsnav->imu->W[0] = -fsnav->imu->sol.v[1]/Rn_h;
-		fsnav->imu->W[1] =  fsnav->imu->sol.v[0]/Re_h;	
-		if (cphi < eps) { // check for Earth pole proximity
-			fsnav->imu->W[2] = 0;    // freeze
-			fsnav->imu->W_valid = 0; // drop validity
-		}
-		else {
-			fsnav->imu->W[2] = fsnav->imu->sol.v[0]/Re_h*sphi/cphi;
-			fsnav->imu->W_valid = 1;
-		}
+		// ellipsoid geometry, angular rate of navigation frame relative to the Earth
+		fsnav_ins_motion_nav_rate(&sphi, &cphi, &Rn_h, &Re_h);
 		// velocity
 			// Coriolis acceleration
 		dvrel[0] = fsnav->imu->W[0];
@@ -205,43 +198,228 @@ void fsnav_ins_motion_euler(void) {
 		if (fsnav->imu->w_valid) { // if able to calculate attitude mid-point using gyroscopes
 			for (i = 0; i < 3; i++)
 				dvrel[i] = fsnav->imu->w[i]*dt/2; // midpoint rotation Euler vector
-			fsnav_linal_eul2mat(C_2, dvrel); // midpoint attitude matrix factor
+			eul2mat(C_2, dvrel);             // midpoint attitude matrix factor
 			for (i = 0; i < 3; i++) // multiply C_2*f, store in the first row of C_2
 				for (j = 1, C_2[i] = C_2[i*3]*fsnav->imu->f[0]; j < 3; j++)
 					C_2[i] += C_2[i*3+j]*fsnav->imu->f[j];
-			fsnav_linal_mmul1T(dvrel, fsnav->imu->sol.L, C_2, 3, 3, 1); // dvrel = L^T(t+dt)*C_2(w*dt/2)*f
+			fsnav_linal_mmul1T3x1(dvrel, L, C_2); // dvrel = L^T(t+dt)*C_2(w*dt/2)*f
 		}
 		else // otherwise, go on with only the current attitude matrix
-			fsnav_linal_mmul1T(dvrel, fsnav->imu->sol.L, fsnav->imu->f, 3, 3, 1);
+			fsnav_linal_mmul1T3x1(dvrel, L, fsnav->imu->f);
 			// velocity update
 		for (i = 0; i < 3; i++)
 			fsnav->imu->sol.v[i] += (dvcor[i] + dvrel[i] + fsnav->imu->g[i])*dt;
 		fsnav->imu->sol.v_valid = 1;
 		// coordinates
-		if (cphi < eps) { // check for Earth pole proximity
-			fsnav->imu->sol.llh[2] += fsnav->imu->sol.v[2]				*dt;
-			fsnav->imu->sol.llh_valid = 0; // drop validity
+		fsnav_ins_motion_llh_update(fsnav->imu->sol.v, cphi, Rn_h, Re_h, dt);
+	}
+
+}
+
+/* fsnav_ins_motion_sculling - fsnav plugin
+	
+	Reads velocity increments pre-integrated at the full sensor rate in a bus accumulator (fsnav->attach_accum),
+	then applies rotation and sculling compensation and integrates Newton's second Law in local level navigation frame at a lower rate over the Earth reference ellipsoid. 
+	Updates velocity and geographical coordinates. 
+	Not suitable near the Earth's poles, at outer-space altitudes, and/or over-Mach velocities.
+
+	description:
+		every sensor sample k within the navigation update interval [t_m-1, t_m] (fsnav_accumulate_imu core plugin):
+		
+		da_k = w_k*dt, dv_k = f_k*dt,
+		s_k  = s_k-1 + (a_k-1 x dv_k + v_k-1 x da_k)/2  (sculling),
+		a_k  = a_k-1 + da_k,
+		v_k  = v_k-1 + dv_k,
+		
+		at t_m, T = t_m - t_m-1:
+		
+		dV_b = v + (a x v)/2 + s                         (rotation and sculling compensated increment in body frame at t_m-1)
+		dV_n = (E - [z x]/2)*L^T(t_m-1)*dV_b, z = (W + u)*T (navigation frame rotation over the interval)
+		V  (t_m) = V  (t_m-1) + dV_n + T*([(W + 2u) x]*V(t_m-1) + g)
+		lon(t_m) = lon(t_m-1) + T*      Ve/((Re + alt(t_m-1))*cos(lat(t_m-1)))
+		lat(t_m) = lat(t_m-1) + T*      Vn/( Rn + alt(t_m-1))
+		alt(t_m) = alt(t_m-1) + T*      Vu,   V = (V(t_m-1) + V(t_m))/2
+		
+		where
+		[v x] is a cross product matrix as in fsnav_ins_motion_euler,
+		Rn, Re are curvature radii
+		L is attitude matrix
+		
+		per-sample cost is two cross products, compared to trigonometry, Rodrigues matrix
+		and matrix products of fsnav_ins_motion_euler at each sample;
+		use instead of fsnav_ins_motion_euler, not together;
+		requires fsnav_accumulate_imu core plugin placed before, 
+		may be scheduled with cycle > 1, every step within the update interval is then skipped by the host,
+		or subscribed to FSNAV_TOPIC_ATTITUDE after a reduced-rate attitude plugin (fsnav_ins_attitude_coning),
+		so that intervals start and end on attitude updates (the first one at or past the navigation update interval);
+		an interval with invalid sensor samples is dropped, and accumulation starts over from the step it is found on
+
+		do not use at the Earth's poles
+		
+	uses:
+		fsnav->imu->sol.llh
+		fsnav->imu->sol.llh_valid
+		fsnav->imu->geo (fsnav_imu_get_geo)
+		fsnav->imu->sol.v
+		fsnav->imu->sol.v_valid
+		fsnav->imu->sol.L (fsnav_sol_get_L)
+		fsnav->imu->sol.L_valid
+		fsnav->imu->g
+		fsnav->imu->g_valid
+		fsnav->imu->W
+		fsnav->imu->W_valid
+		increment accumulator attached to the plugin (a, v, s, T, n, w_valid, f_valid)
+
+	changes:
+		fsnav->imu->sol.v
+		fsnav->imu->sol.v_valid
+		fsnav->imu->sol.llh
+		fsnav->imu->sol.llh_valid
+		increment accumulator attached to the plugin (reset)
+
+	cfg parameters:
+		{imu: lon}, {imu: lat}, {imu: alt} - starting coordinates, same as for fsnav_ins_motion_euler
+		{imu: sculling_rate} - navigation update rate, Hz
+			type :   floating point
+			range:   >0, rates at or above the sensor rate update at every sample
+			default: update on every call (every sample, or at the rate the plugin is scheduled or signalled at)
+			example: {imu: sculling_rate = 200}
+*/
+void fsnav_ins_motion_sculling(void) {
+
+	const char 
+		lon_token[]  = "lon",           // starting longitude parameter name in configuration
+		lat_token[]  = "lat",           // starting latitude  parameter name in configuration
+		alt_token[]  = "alt",           // starting altitude  parameter name in configuration
+		rate_token[] = "sculling_rate"; // navigation update rate parameter name in configuration
+
+	const double 
+		lon_range[] = {-180, +180},	// longitude range, 0 by default
+		lat_range[] = { -90,  +90},	// latitude  range, 0 by default
+		alt_range[] = {-20e3,50e3};	// altitude  range, 0 by default
+
+	static double 
+		Tn =  0,                    // navigation update interval
+		L0[9];                      // attitude matrix at the last navigation update
+	static char restart = 1;        // accumulation restart flag
+	static fsnav_accum* acc = NULL; // increment accumulator
+
+	double
+		T,                          // time elapsed since the last navigation update
+		v[3],                       // compensated velocity increment in body frame
+		sphi, cphi,	                // sine and cosine of latitude
+		Rn_h, Re_h,	                // south-to-north and east-to-west curvature radii, altitude-adjusted
+		da[3],                      // intermediate cross product
+		dvrel[3],	                // velocity increment in navigation frame
+		dvcor[3],	                // Coriolis acceleration in navigation frame
+		c[3],                       // intermediate cross product
+		v_1[3],                     // velocity before update
+		*L;                         // pointer to attitude matrix in solution, derived on demand
+	size_t i;                       // common index variable
+
+
+	// check if imu data has been initialized
+	if (fsnav->imu == NULL)
+		return;
+
+	if (fsnav->mode == 0) {		// init
+
+		// drop validity flags
+		fsnav->imu->sol.  v_valid = 0;
+		fsnav->imu->sol.llh_valid = 0;		
+		// parse parameters from configuration	
+		fsnav->imu->sol.llh[0] = // starting longitude
+			fsnav_ins_motion_parse_double(lon_token, fsnav->imu->cfg,fsnav->imu->cfglength, (double *)lon_range,0)
+			/fsnav->imu_const.rad2deg; // degrees to radians
+		fsnav->imu->sol.llh[1] = // starting latitude
+			fsnav_ins_motion_parse_double(lat_token, fsnav->imu->cfg,fsnav->imu->cfglength, (double *)lat_range,0)
+			/fsnav->imu_const.rad2deg; // degrees to radians
+		fsnav->imu->sol.llh[2] = // starting altitude
+			fsnav_ins_motion_parse_double(alt_token, fsnav->imu->cfg,fsnav->imu->cfglength, (double *)alt_range,0);
+		// raise coordinates validity flag
+		fsnav->imu->sol.llh_valid = 1;
+		// zero velocity at start
+		for (i = 0; i < 3; i++)
+			fsnav->imu->sol.v[i] = 0;
+		fsnav->imu->sol.v_valid = 1;
+		// navigation update interval
+		Tn = fsnav_ins_motion_parse_double(rate_token, fsnav->imu->cfg,fsnav->imu->cfglength, NULL,0);
+		Tn = (Tn > 0 && isfinite(Tn)) ? 1/Tn : 0; // on every call by default
+		// attach increment accumulator
+		acc = fsnav->attach_accum(fsnav_ins_motion_sculling, 0);
+		restart = 1;
+
+	}
+
+	else if (fsnav->mode < 0) {	// termination
+		// do nothing
+	}
+
+	else						// main cycle
+	{
+		if (acc == NULL)
+			return;
+		// check for crucial data initialized
+		L = fsnav_sol_get_L(&(fsnav->imu->sol));
+		if (   !fsnav->imu->sol.  v_valid 
+			|| !fsnav->imu->sol.llh_valid 
+			|| L == NULL 
+			|| !fsnav->imu->g_valid) {
+			restart = 1; // restart accumulation
+			return;
 		}
-		else {
-			fsnav->imu->sol.llh[0] += fsnav->imu->sol.v[0]/(Re_h*cphi)	*dt;
-			fsnav->imu->sol.llh[1] += fsnav->imu->sol.v[1]/ Rn_h			*dt;
-			fsnav->imu->sol.llh[2] += fsnav->imu->sol.v[2]				*dt;
-			// flip latitude if crossed a pole
-			if (fsnav->imu->sol.llh[1] < -fsnav->imu_const.pi/2) { // South pole
-				fsnav->imu->sol.llh[1] = -fsnav->imu_const.pi - fsnav->imu->sol.llh[1];
-				fsnav_ins_motion_flip_sol_over_pole(&(fsnav->imu->sol));			
-			}
-			if (fsnav->imu->sol.llh[1] > +fsnav->imu_const.pi/2) { // North pole
-				fsnav->imu->sol.llh[1] = +fsnav->imu_const.pi - fsnav->imu->sol.llh[1];
-				fsnav_ins_motion_flip_sol_over_pole(&(fsnav->imu->sol));			
-			}
-			// adjust longitude into range
-			while (fsnav->imu->sol.llh[0] < -fsnav->imu_const.pi)
-				fsnav->imu->sol.llh[0] += 2*fsnav->imu_const.pi;
-			while (fsnav->imu->sol.llh[0] > +fsnav->imu_const.pi)
-				fsnav->imu->sol.llh[0] -= 2*fsnav->imu_const.pi;
-			fsnav->imu->sol.llh_valid = 1;
+		if (restart || !acc->w_valid || !acc->f_valid) { // first touch, or invalid samples within the interval: start over from here
+			restart = 0;
+			fsnav->reset_accum(acc);
+			for (i = 0; i < 9; i++)
+				L0[i] = L[i];
+			return;
 		}
+		// wait for the navigation update, half a sample tolerance
+		if (acc->n == 0 || acc->T + acc->T/acc->n/2 < Tn)
+			return;
+		T = acc->T;
+		// drop validity flags
+		fsnav->imu->sol.llh_valid = 0;
+		fsnav->imu->sol.  v_valid = 0;
+		// ellipsoid geometry, angular rate of navigation frame relative to the Earth
+		fsnav_ins_motion_nav_rate(&sphi, &cphi, &Rn_h, &Re_h);
+		// velocity
+			// Coriolis acceleration
+		dvrel[0] = fsnav->imu->W[0];
+		dvrel[1] = fsnav->imu->W[1] + 2*fsnav->imu_const.u*cphi;
+		dvrel[2] = fsnav->imu->W[2] + 2*fsnav->imu_const.u*sphi;
+		fsnav_linal_cross3x1(dvcor, fsnav->imu->sol.v, dvrel);
+			// rotation and sculling compensated increment in body frame, v + (a x v)/2 + s
+		fsnav_linal_cross3x1(c, acc->a, acc->v);
+		for (i = 0; i < 3; i++)
+			v[i] = acc->v[i] + c[i]/2 + acc->s[i];
+			// navigation frame at the beginning of the interval
+		fsnav_linal_mmul1T3x1(dvrel, L0, v);
+			// navigation frame rotation over the interval, z = (W + u)*T
+		for (i = 0; i < 3; i++)
+			c[i] = fsnav->imu->W[i];
+		c[1] += fsnav->imu_const.u*cphi;
+		c[2] += fsnav->imu_const.u*sphi;
+		for (i = 0; i < 3; i++)
+			c[i] *= T;
+		fsnav_linal_cross3x1(da, c, dvrel);
+		for (i = 0; i < 3; i++)
+			dvrel[i] -= da[i]/2;
+			// velocity update
+		for (i = 0; i < 3; i++) {
+			v_1[i] = fsnav->imu->sol.v[i];
+			fsnav->imu->sol.v[i] += dvrel[i] + (dvcor[i] + fsnav->imu->g[i])*T;
+		}
+		fsnav->imu->sol.v_valid = 1;
+		// coordinates with the mean velocity over the interval
+		for (i = 0; i < 3; i++)
+			v_1[i] = (v_1[i] + fsnav->imu->sol.v[i])/2;
+		fsnav_ins_motion_llh_update(v_1, cphi, Rn_h, Re_h, T);
+		// restart accumulation
+		fsnav->reset_accum(acc);
+		for (i = 0; i < 9; i++)
+			L0[i] = L[i];
 	}
 
 }
@@ -442,3 +620,61 @@ void fsnav_ins_motion_flip_sol_over_pole(fsnav_sol *sol) {
 	fsnav_linal_mat2rpy (sol->rpy,sol->L);
 
 }
+
+void fsnav_ins_motion_nav_rate(double *sphi, double *cphi, double *Rn_h, double *Re_h) {
+
+	const double eps = 1.0/0x0100; // 2^-8, guaranteed non-zero value in IEEE754 half-precision format
+
+	fsnav_geo *geo;                // geodetic terms shared on the bus
+
+	// ellipsoid geometry
+	geo = fsnav_imu_get_geo(fsnav->imu);
+	*sphi = geo->sphi;
+	*cphi = geo->cphi;
+	*Re_h = geo->Re_h;
+	*Rn_h = geo->Rn_h;
+	// angular rate of navigation frame relative to the Earth
+	fsnav->imu->W_valid = 0;
+	fsnav->imu->W[0] = -fsnav->imu->sol.v[1]/(*Rn_h);
+	fsnav->imu->W[1] =  fsnav->imu->sol.v[0]/(*Re_h);	
+	if (*cphi < eps) { // check for Earth pole proximity
+		fsnav->imu->W[2] = 0;    // freeze
+		fsnav->imu->W_valid = 0; // drop validity
+	}
+	else {
+		fsnav->imu->W[2] = fsnav->imu->sol.v[0]/(*Re_h)*(*sphi)/(*cphi);
+		fsnav->imu->W_valid = 1;
+	}
+
+}
+
+void fsnav_ins_motion_llh_update(double *v, const double cphi, const double Rn_h, const double Re_h, const double dt) {
+
+	const double eps = 1.0/0x0100; // 2^-8, guaranteed non-zero value in IEEE754 half-precision format
+
+	if (cphi < eps) { // check for Earth pole proximity
+		fsnav->imu->sol.llh[2] += v[2]				*dt;
+		fsnav->imu->sol.llh_valid = 0; // drop validity
+	}
+	else {
+		fsnav->imu->sol.llh[0] += v[0]/(Re_h*cphi)	*dt;
+		fsnav->imu->sol.llh[1] += v[1]/ Rn_h			*dt;
+		fsnav->imu->sol.llh[2] += v[2]				*dt;
+		// flip latitude if crossed a pole
+		if (fsnav->imu->sol.llh[1] < -fsnav->imu_const.pi/2) { // South pole
+			fsnav->imu->sol.llh[1] = -fsnav->imu_const.pi - fsnav->imu->sol.llh[1];
+			fsnav_ins_motion_flip_sol_over_pole(&(fsnav->imu->sol));			
+		}
+		if (fsnav->imu->sol.llh[1] > +fsnav->imu_const.pi/2) { // North pole
+			fsnav->imu->sol.llh[1] = +fsnav->imu_const.pi - fsnav->imu->sol.llh[1];
+			fsnav_ins_motion_flip_sol_over_pole(&(fsnav->imu->sol));			
+		}
+		// adjust longitude into range
+		while (fsnav->imu->sol.llh[0] < -fsnav->imu_const.pi)
+			fsnav->imu->sol.llh[0] += 2*fsnav->imu_const.pi;
+		while (fsnav->imu->sol.llh[0] > +fsnav->imu_const.pi)
+			fsnav->imu->sol.llh[0] -= 2*fsnav->imu_const.pi;
+		fsnav->imu->sol.llh_valid = 1;
+	}
+
+}
@@ -0,0 +1,157 @@
+% compute a regional grid of gravity disturbance and deflections of the vertical from EGM2008
+% and save it in the format read by fsnav_ins_gravity_egm08 plugin
+% input:
+%     coef_file   --- EGM2008 spherical harmonic coefficients file, e.g. EGM2008_to2190_TideFree (n m C S sigmaC sigmaS per line)
+%     lat         --- first and last node latitude [deg]
+%     lon         --- first and last node longitude [deg], increasing, may cross 180
+%     step        --- latitude and longitude grid steps [deg]
+%     nmax        --- maximum degree, up to 2190, about 180/step is enough for the grid resolution
+%     h           --- height above ellipsoid [m]
+%     tile        --- nodes per tile side, e.g. 32 (12 KB per tile)
+%     output_file --- output file path
+% output:
+%     dg          --- gravity disturbance [mGal], nlat x nlon
+%     xi          --- deflection of the vertical in the meridian [arcsec], nlat x nlon
+%     eta         --- deflection of the vertical in the prime vertical [arcsec], nlat x nlon
+% note:
+%     spherical harmonic synthesis at the geocentric radius and latitude of each node,
+%     with GRS-80 normal field (even zonal harmonics up to degree 20 and GM) subtracted;
+%     Legendre functions are scaled by 1e280 against underflow at high degrees,
+%     the terms still underflowing at high latitudes are negligible
+% example:
+%     egm08_grid('EGM2008_to2190_TideFree', [55 56.5], [36.5 38.5], [1 1]/60, 2190, 0, 32, 'egm08_moscow.grd');
+function [dg, xi, eta] = egm08_grid(coef_file, lat, lon, step, nmax, h, tile, output_file)
+
+	% EGM2008 constants
+	GM    = 3986004.415e8;   % m^3/s^2
+	a     = 6378136.3;       % m
+	% GRS-80 constants
+	GM0   = 3986005e8;       % m^3/s^2
+	a0    = 6378137;         % m
+	e2    = 0.00669438002290;
+	J2    = 108263e-8;
+	ge    = 9.7803267715;    % m/s^2
+	fg    = 5.302440112e-3;  % gravity flattening
+	% units
+	mgal   = 1e-5;           % m/s^2
+	arcsec = pi/180/3600;    % rad
+	scale  = 1e280;          % Legendre functions scale factor
+
+	% grid nodes
+	lat_n = lat(1):step(1):lat(2)+step(1)/2;
+	lon_n = lon(1):step(2):lon(2)+step(2)/2;
+	nlat  = length(lat_n);
+	nlon  = length(lon_n);
+	
+	% coefficients
+	fid = fopen(coef_file, 'r');
+	if fid < 0, error('Can not open coefficients file!\n'); end
+	txt = fread(fid, '*char')';
+	fclose(fid);
+	txt(txt == 'D' | txt == 'd') = 'E'; % Fortran exponents
+	c = sscanf(txt, '%f', [6 Inf])';
+	clear txt
+	c = c(c(:,1) <= nmax, :);
+	C = zeros(nmax+1, nmax+1); % C(n+1,m+1)
+	S = zeros(nmax+1, nmax+1);
+	C(sub2ind(size(C), c(:,1)+1, c(:,2)+1)) = c(:,3);
+	S(sub2ind(size(S), c(:,1)+1, c(:,2)+1)) = c(:,4);
+	clear c
+
+	% normal field subtracted, scaled to EGM2008 GM and a
+	C(1,1) = 1 - GM0/GM;
+	for k = 1:min(10, floor(nmax/2))
+		J2k = (-1)^(k+1)*3*e2^k/((2*k+1)*(2*k+3))*(1 - k + 5*k*J2/e2);
+		C(2*k+1,1) = C(2*k+1,1) + J2k/sqrt(4*k+1)*GM0/GM*(a0/a)^(2*k);
+	end
+
+	% Legendre recursion coefficients A(n+1,m+1), B(n+1,m+1), and derivative coefficients, 
+	% dP(n,m)/dphi = D1(n,m)*P(n,m-1) + D2(n,m)*P(n,m+1)
+	n = (0:nmax)';
+	m = 0:nmax;
+	[NN, MM] = ndgrid(n, m);
+	A  = zeros(nmax+1, nmax+1);
+	B  = zeros(nmax+1, nmax+1);
+	D1 = zeros(nmax+1, nmax+1);
+	D2 = zeros(nmax+1, nmax+1);
+	k = NN > MM;
+	A(k)  = sqrt((2*NN(k)-1).*(2*NN(k)+1)./((NN(k)-MM(k)).*(NN(k)+MM(k))));
+	k = NN > MM + 1;
+	B(k)  = sqrt((2*NN(k)+1).*(NN(k)+MM(k)-1).*(NN(k)-MM(k)-1)./((NN(k)-MM(k)).*(NN(k)+MM(k)).*(2*NN(k)-3)));
+	k = NN >= MM & MM > 0;
+	D1(k) = -0.5*sqrt((NN(k)+MM(k)).*(NN(k)-MM(k)+1));
+	D1(:,2) = sqrt(2)*D1(:,2);
+	k = NN > MM;
+	D2(k) = 0.5*sqrt((NN(k)-MM(k)).*(NN(k)+MM(k)+1));
+	D2(:,1) = sqrt(n.*(n+1)/2);
+	clear NN MM k
+
+	% longitude terms
+	CM = cos(lon_n'*pi/180*m);
+	SM = sin(lon_n'*pi/180*m);
+
+	dg  = zeros(nlat, nlon);
+	xi  = zeros(nlat, nlon);
+	eta = zeros(nlat, nlon);
+	for i = 1:nlat
+		% geocentric radius and latitude of the node
+		phi = lat_n(i)*pi/180;
+		N   = a0/sqrt(1 - e2*sin(phi)^2);
+		X   = (N + h)*cos(phi);
+		Z   = (N*(1 - e2) + h)*sin(phi);
+		r   = sqrt(X^2 + Z^2);
+		t   = Z/r; % sine of geocentric latitude
+		u   = X/r; % cosine of geocentric latitude
+		% normal gravity
+		gamma = ge*(1 + fg*sin(phi)^2 - 5.8e-6*sin(2*phi)^2) - 3.086e-6*h;
+		% fully normalized Legendre functions P(n+1,m+1), scaled, with an extra column for derivatives
+		P = zeros(nmax+1, nmax+2);
+		P(1,1) = scale;
+		for k = 1:nmax
+			P(k+1,k+1) = sqrt((2*k+1)/(2*k)*(1 + (k == 1)))*u*P(k,k);
+		end
+		P(2,1) = A(2,1)*t*P(1,1);
+		for k = 2:nmax
+			mm = 1:k;
+			P(k+1,mm) = A(k+1,mm).*t.*P(k,mm) - B(k+1,mm).*P(k-1,mm);
+		end
+		dP = D1.*[zeros(nmax+1,1) P(:,1:nmax)] + D2.*P(:,2:nmax+2);
+		P  = P(:,1:nmax+1);
+		% degree sums for each order
+		q    = (a/r).^n;
+		Pc   = C.*P;
+		Ps   = S.*P;
+		dPc  = C.*dP;
+		dPs  = S.*dP;
+		Gc   = ((n+1).*q)'*Pc;
+		Gs   = ((n+1).*q)'*Ps;
+		Xc   = q'*dPc;
+		Xs   = q'*dPs;
+		Ec   = (q'*Ps).*m;
+		Es   = -(q'*Pc).*m;
+		% order sums for each longitude
+		K = GM/r^2/scale;
+		dg (i,:) =  K*(CM*Gc' + SM*Gs')'/mgal;
+		xi (i,:) = -K/gamma*(CM*Xc' + SM*Xs')'/arcsec;
+		eta(i,:) = -K/gamma/u*(CM*Ec' + SM*Es')'/arcsec;
+	end
+
+	% save tiles of tile x tile nodes, row-major, node values interleaved, edge tiles padded
+	fid = fopen(output_file, 'w', 'ieee-le');
+	if fid < 0, error('Can not open output file!\n'); end
+	fwrite(fid, 'FSNAVEGM', 'char*1');
+	fwrite(fid, [1 tile nlat nlon], 'int32');
+	fwrite(fid, [lat_n(1) lon_n(1) step(1) step(2) h], 'double');
+	for ti = 1:ceil(nlat/tile)
+		for tj = 1:ceil(nlon/tile)
+			ii = (ti-1)*tile+1 : min(ti*tile, nlat);
+			jj = (tj-1)*tile+1 : min(tj*tile, nlon);
+			block = zeros(3, tile, tile); % (value, longitude, latitude) to be written value-first
+			block(1, 1:length(jj), 1:length(ii)) = dg (ii,jj)';
+			block(2, 1:length(jj), 1:length(ii)) = xi (ii,jj)';
+			block(3, 1:length(jj), 1:length(ii)) = eta(ii,jj)';
+			fwrite(fid, block, 'single');
+		end
+	end
+	fclose(fid);
+end
@@ -14,7 +14,7 @@
 #include "../../libs/ins/fsnav_ins_motion.h"
 
 // проверка версии ядра
-#define FSNAV_INS_FSNAV_BUS_VERSION_REQUIRED 12
+#define FSNAV_INS_FSNAV_BUS_VERSION_REQUIRED 20
 #if FSNAV_BUS_VERSION < FSNAV_INS_FSNAV_BUS_VERSION_REQUIRED
 	#error "fsnav bus version check failed, consider fetching the newest one"
 #endif
@@ -22,6 +22,15 @@
 #define FSNAV_INS_BUFFER_SIZE 4096
 #define BIT16
 
+// состояние файла для блочных плагинов ввода/вывода
+typedef struct {
+	FILE* fp;                            // указатель на файл
+	char  buffer[FSNAV_INS_BUFFER_SIZE]; // строковый буфер
+} fsnav_ins_file;
+
+// последовательность частных алгоритмов
+char fsnav_ins_add_plugins(void);
+char fsnav_ins_step_static(void);
 // частные алгоритмы приложения
 	// диспетчеризация
 void fsnav_ins_scheduler(void);
@@ -29,10 +38,15 @@ void fsnav_ins_scheduler(void);
 void fsnav_ins_step_sync              (void);
 void fsnav_ins_read_conv_input        (void);
 void fsnav_ins_read_raw_input         (void);
-void fsnav_ins_read_raw_input_temp    (void);
-void fsnav_ins_write_output           (void);
-void fsnav_ins_write_sensors          (void);
-void fsnav_ins_switch_imu_axes        (void);
+void   fsnav_ins_file_close             (void*);
+void   fsnav_ins_read_raw_input_temp_init(void*);
+size_t fsnav_ins_read_raw_input_temp     (void*, fsnav_imu_sample*, size_t);
+void   fsnav_ins_write_output_init       (void*);
+size_t fsnav_ins_write_output            (void*, fsnav_imu_sample*, size_t);
+void   fsnav_ins_write_sensors_init      (void*);
+size_t fsnav_ins_write_sensors           (void*, fsnav_imu_sample*, size_t);
+void fsnav_ins_switch_imu_axes_init   (void*);
+void fsnav_ins_switch_imu_axes        (void*);
 void fsnav_ins_print_progress         (void);
 	// калибровка
 void fsnav_ins_imu_calibration        (void);
@@ -42,17 +56,35 @@ void fsnav_ins_compensate_static_drift(void);
 void fsnav_ins_alignment_static_accs  (void);
 void fsnav_ins_alignment_static_const (void);
 void fsnav_ins_set_yaw_zero           (void);
-void fsnav_ins_attitude_madgwick      (void);
+void fsnav_ins_alignment_finished     (void);
+
+// матрица перестановки осей инерциальных датчиков
+static double fsnav_ins_imu_axes[9] = {0, 1, 0, 0, 0, 1, 1, 0, 0};
+
+// состояние комплементарного фильтра Махони
+static fsnav_ins_attitude_mahony_state fsnav_ins_mahony;
+
+// файлы ввода/вывода
+static fsnav_ins_file fsnav_ins_sensors_in;
+static fsnav_ins_file fsnav_ins_sensors_out;
+static fsnav_ins_file fsnav_ins_nav_out;
 
 void main(void)
 {
 	// конфигурационный файл
 	const char cfgname[] = "fsnav_ins.cfg";
+
+	// размер блока показаний, обрабатываемых за один вызов ядра
+	const char block_token[] = "block_size";
+	const int  block_default = 1;
+	const int  block_limit   = 65536;
 	
 	FILE* fp;
 	int i;
 	char c;
 	char* cfg;
+	char* cfg_ptr;
+	int block;
 
 	printf("fsnav_ins has started\n----\n");
 
@@ -93,38 +125,31 @@ void main(void)
 	fclose(fp);
 
 	// добавление частных алгоритмов
-	if (   !fsnav->add_plugin(fsnav_ins_step_sync              ) // ожидание метки времени шага навигационного решения
-	    || !fsnav->add_plugin(fsnav_ins_scheduler              ) // диспетчер
-	    || !fsnav->add_plugin(fsnav_ins_read_raw_input_temp    ) // считывание сырых показаний датчиков, температуры и их преобразование
-	    || !fsnav->add_plugin(fsnav_ins_imu_calibration_temp   ) // вычисление откалиброванных показаний датчиков (температурная модель)
-	    || !fsnav->add_plugin(fsnav_ins_switch_imu_axes        ) // перестановка осей инерциальных датчиков
-	    || !fsnav->add_plugin(fsnav_ins_write_sensors          ) // запись преобразованных показаний датчиков
-	    || !fsnav->add_plugin(fsnav_ins_gravity_normal         ) // модель поля силы тяжести: стандартная
-	    || !fsnav->add_plugin(fsnav_ins_gravity_constant       ) // модель поля силы тяжести: постоянная
-	    || !fsnav->add_plugin(fsnav_ins_alignment_static       ) // начальная выставка: по акселерометрам и гироскопам
-	    || !fsnav->add_plugin(fsnav_ins_alignment_static_accs  ) // начальная выставка: только по акселерометрам
-	    || !fsnav->add_plugin(fsnav_ins_set_yaw_zero           ) // обнуление угла курса
-	    || !fsnav->add_plugin(fsnav_ins_attitude_rodrigues     ) // ориентация
-	    || !fsnav->add_plugin(fsnav_ins_attitude_madgwick      ) // фильтр Мэджвика
-	    || !fsnav->add_plugin(fsnav_ins_motion_euler           ) // положение и скорость
-	    || !fsnav->add_plugin(fsnav_ins_motion_vertical_damping) // демпфирование в вертикальном канале
-	    || !fsnav->add_plugin(fsnav_ins_write_output           ) // запись навигационного решения
-	    || !fsnav->add_plugin(fsnav_ins_print_progress         ) // вывод на экран
-	    ) {
+	if (!fsnav_ins_add_plugins()) {
 		printf("error: couldn't add plugins.\n"); // ошибка добавления частных алгоритмов
 		return;									
 	}
 
 	// инициализация ядра
-	if (fsnav->init((char*)cfg))
-		while(fsnav->step()); // основной цикл
-
-	// ошибка инициализации
-	else {
-		printf("error: couldn't initialize.\n");
+	if (!fsnav->init((char*)cfg)) {
+		printf("error: couldn't initialize.\n"); // ошибка инициализации
 		return;
 	}
 
+	// поиск размера блока в конфигурации
+	cfg_ptr = fsnav_locate_token(block_token, fsnav->cfg_settings, fsnav->settings_length, '=');
+	if (cfg_ptr != NULL)
+		block = atoi(cfg_ptr);
+	if (cfg_ptr == NULL || block < 1 || block_limit < block)
+		block = block_default;
+
+	// основной цикл
+#ifdef FSNAV_INS_STATIC_PIPELINE
+	while(fsnav_step_n_ext((size_t)block, fsnav_ins_step_static)); // статически скомпилированная последовательность плагинов
+#else
+	while(fsnav->step_n((size_t)block));
+#endif
+
 	printf("\n----\nfsnav_ins has terminated\n");
 }
 
@@ -132,6 +157,96 @@ void main(void)
 
 
 
+
+// последовательность частных алгоритмов
+	/*
+		добавление плагинов на шину в порядке, заданном в fsnav_ins_pipeline.h
+		возвращаемое значение:
+			1 — плагины добавлены
+			0 — ошибка добавления
+	*/
+char fsnav_ins_add_plugins(void)
+{
+#define FSNAV_INS_PLUGIN(plugin) \
+	if (!fsnav->add_plugin(plugin)) \
+		return 0;
+#define FSNAV_INS_PLUGIN_EXT(init, step, terminate, context) \
+	if (!fsnav->add_plugin_ext(init, step, terminate, context)) \
+		return 0;
+#define FSNAV_INS_PLUGIN_BLOCK(init, block, terminate, context, role) \
+	if (!fsnav->add_plugin_block(init, block, terminate, context, role)) \
+		return 0;
+#include "fsnav_ins_pipeline.h"
+#undef FSNAV_INS_PLUGIN
+#undef FSNAV_INS_PLUGIN_EXT
+#undef FSNAV_INS_PLUGIN_BLOCK
+
+	return 1;
+}
+
+	/*
+		шаг по списку плагинов с прямыми вызовами функций, сгенерированный из fsnav_ins_pipeline.h,
+		заменяет fsnav->step() при фиксированной последовательности плагинов
+		и позволяет компилятору встраивать плагины друг в друга (сборка run_ins_static с LTO)
+		возвращаемое значение:
+			как у fsnav->step()
+		примечание:
+			инициализация, завершение работы и изменённый список плагинов обрабатываются ядром через fsnav_step_from
+	*/
+char fsnav_ins_step_static(void)
+{
+	// идентификаторы плагинов для проверки списка на шине
+#define FSNAV_INS_PLUGIN(plugin)                             (void(*)(void))plugin,
+#define FSNAV_INS_PLUGIN_EXT(init, step, terminate, context) (void(*)(void))step,
+#define FSNAV_INS_PLUGIN_BLOCK(init, block, terminate, context, role) (void(*)(void))block,
+	static void(*pipeline[])(void) = {
+#include "fsnav_ins_pipeline.h"
+	};
+#undef FSNAV_INS_PLUGIN
+#undef FSNAV_INS_PLUGIN_EXT
+#undef FSNAV_INS_PLUGIN_BLOCK
+	const size_t n = sizeof(pipeline)/sizeof(pipeline[0]);
+
+	static unsigned long revision = 0; // ревизия списка плагинов, для которой выполнено сопоставление
+	static char          mapped   = 0; // признак выполненного сопоставления
+	static size_t        map[sizeof(pipeline)/sizeof(pipeline[0])]; // индексы плагинов последовательности в списке на шине
+	static size_t        tail     = 0; // индекс первого плагина на шине, не вошедшего в последовательность
+
+	size_t k = 0;
+
+	// инициализация и завершение работы
+	if (fsnav->mode <= 0)
+		return fsnav_step_from(0);
+
+	// балансировка периодических плагинов, если включена
+	fsnav_balance_step();
+
+	// сопоставление последовательности со списком плагинов при его изменении
+	if (!mapped || revision != fsnav->core.revision) {
+		revision = fsnav->core.revision;
+		tail     = fsnav_step_static_map(pipeline, n, map);
+		mapped   = 1;
+	}
+
+	// прямые вызовы плагинов, удаленные и выведенные из работы плагины пропускаются
+#define FSNAV_INS_PLUGIN(plugin)                             FSNAV_STEP_STATIC_PLUGIN(k, map, revision, plugin())
+#define FSNAV_INS_PLUGIN_EXT(init, step, terminate, context) FSNAV_STEP_STATIC_PLUGIN(k, map, revision, step(context))
+#define FSNAV_INS_PLUGIN_BLOCK(init, block, terminate, context, role) FSNAV_STEP_STATIC_PLUGIN(k, map, revision, fsnav_step_block_entry(fsnav_step_static_i))
+#include "fsnav_ins_pipeline.h"
+#undef FSNAV_INS_PLUGIN
+#undef FSNAV_INS_PLUGIN_EXT
+#undef FSNAV_INS_PLUGIN_BLOCK
+
+	// плагины, не вошедшие в последовательность или добавленные после запуска
+	if (tail < fsnav->core.plugin_count)
+		return fsnav_step_from(tail);
+
+	return fsnav_step_end();
+}
+
+
+
+
 // диспетчеризация
 	/*
 		диспетчер выполнения плагинов и модификаций навигационного алгоритма
@@ -154,6 +269,25 @@ void main(void)
 				тип: число с плавающей точкой
 				диапазон: +0 до +inf
 				пример: {imu: madgwick_feedback_rate = 0.003}
+			mahony_kp — пропорциональный коэффициент комплементарного фильтра Махони, 1/сек (без фильтра Маджвика)
+				тип: число с плавающей точкой
+				диапазон: +0 до +inf
+				пример: {imu: mahony_kp = 0.1}
+			attitude_quaternion — флаг счисления ориентации по кватерниону
+				пример: {imu: attitude_quaternion}
+			coning_samples — число показаний на одно обновление ориентации с компенсацией конического движения
+				тип: натуральное число
+				диапазон: 1 до +inf
+				пример: {imu: coning_samples = 4}
+				скорость и положение при этом обновляются по приращениям с компенсацией скуллинга сразу после обновлений ориентации
+			sculling_rate — частота обновления скорости и положения по приращениям с компенсацией скуллинга, Гц
+				тип: число с плавающей точкой
+				диапазон: +0 до +inf
+				пример: {imu: sculling_rate = 200}
+			egm08_grid — имя файла сетки аномалий силы тяжести EGM2008 (без пробелов в имени), без флага g_const;
+			             если файл не открывается или не соответствует формату (в том числе порядку байтов), выводится ошибка и работа завершается
+				тип: строка
+				пример: {imu: egm08_grid = egm08_moscow.grd}
 		примечание:
 			флаги достаточно указать в конфигурацинной строке без указания значений
 	*/
@@ -164,21 +298,33 @@ void fsnav_ins_scheduler(void)
 		e2_token      [] = "e2_zero",    // имя параметра в строке конфигурации для обнуления эксцентриситета
 		g_token       [] = "g_const",    // имя параметра в строке конфигурации, определяющего режим счисления силы тяжести
 		accs_token    [] = "accs_align", // имя параметра в строке конфигурации для выставки по акселерометрам
-		yaw_token     [] = "yaw_zero";   // имя параметра в строке конфигурации для обнуления угла курса на этапе выставки
-		
-	static char yaw_zero; // флаг обнуления угла курса на этапе выставки
+		yaw_token     [] = "yaw_zero",   // имя параметра в строке конфигурации для обнуления угла курса на этапе выставки
+		balance_token [] = "balance";    // имя параметра в строке конфигурации для балансировки нагрузки периодических плагинов
 
 	const char    limit_token[] = "time_limit"; // имя параметра в строке конфигурации для ограничения по времени
 	const double  limit_default = DBL_MAX;      // стандартное ограничение по времени (без ограничения), сек
 	static double time_limit    = -1;
 
-	const char    t0_token[] = "alignment"; // имя параметра в строке конфигурации с временем выставки
-	const double  t0_default = 300;         // стандартное время выставки, сек
-	static double t0         = -1;
-
 	const char    madgwick_token[] = "madgwick_feedback_rate"; // имя параметра в строке конфигурации для счисления ориентации фильтром Мэджвика
 	static double madgwick_rate    = -1;                       // параметр настройки фильтра Маджвика, рад/сек 
 
+	const char    mahony_token[] = "mahony_kp"; // имя параметра в строке конфигурации для счисления ориентации фильтром Махони
+	static double mahony_kp      = -1;          // пропорциональный коэффициент фильтра Махони, 1/сек
+	char          att_filter;                   // флаг счисления ориентации с коррекцией по акселерометрам
+	char          coning = 0;                   // флаг счисления ориентации на пониженной частоте
+
+	const char    quat_token[] = "attitude_quaternion"; // имя флага в строке конфигурации для счисления ориентации по кватерниону
+
+	const char    coning_token[] = "coning_samples"; // имя параметра в строке конфигурации для счисления ориентации на пониженной частоте
+
+	const char    sculling_token[] = "sculling_rate"; // имя параметра в строке конфигурации для счисления скорости и положения на пониженной частоте
+	static double sculling_rate    = -1;              // частота обновления скорости и положения, Гц
+
+	const char    egm08_token[] = "egm08_grid"; // имя параметра в строке конфигурации с файлом сетки аномалий силы тяжести
+
+	const char    freq_token[] = "freq"; // имя параметра в строке конфигурации, содержащего частоту измерений
+	int           cycle;                 // период вызова плагина, шагов
+
 	char *cfg_ptr; // указатель на параметр в строке конфигурации
 
 	// инициализация
@@ -203,6 +349,8 @@ void fsnav_ins_scheduler(void)
 			fsnav->imu_const.e2 = 0;
 			printf("e2_zero\n");
 		}
+			// геодетические величины на шине пересчитываются с измененными константами
+		fsnav->imu->geo.valid = 0;
 		
 		// отключение плагинов в списке выполнения
 			// поиск флага постоянста силы тяжести
@@ -213,6 +361,12 @@ void fsnav_ins_scheduler(void)
 		}
 		else
 			fsnav->suspend_plugin(fsnav_ins_gravity_constant);
+			// поиск файла сетки аномалий силы тяжести
+		cfg_ptr = fsnav_locate_token(egm08_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
+		if (cfg_ptr != NULL && fsnav_locate_token(g_token, fsnav->cfg_settings, fsnav->settings_length, 0) == NULL)
+			printf("%s\n", egm08_token);
+		else
+			fsnav->suspend_plugin(fsnav_ins_gravity_egm08);
 			// поиск флага счисления ориентации фильтром Маджвика
 		cfg_ptr = fsnav_locate_token(madgwick_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
 		if (cfg_ptr != NULL) {
@@ -226,6 +380,65 @@ void fsnav_ins_scheduler(void)
 		}
 		else
 			fsnav->suspend_plugin(fsnav_ins_attitude_madgwick);
+			// поиск параметра счисления ориентации фильтром Махони
+		cfg_ptr = fsnav_locate_token(mahony_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
+		if (cfg_ptr != NULL && !(madgwick_rate > 0 && isfinite(madgwick_rate))) {
+			mahony_kp = atof(cfg_ptr); 
+			if (mahony_kp > 0 && isfinite(mahony_kp)) {
+				fsnav->suspend_plugin(fsnav_ins_attitude_rodrigues);
+				printf("%s = %g\n", mahony_token, mahony_kp);
+			}
+			else
+				fsnav->suspend_plugin((void(*)(void))fsnav_ins_attitude_mahony);
+		}
+		else
+			fsnav->suspend_plugin((void(*)(void))fsnav_ins_attitude_mahony);
+		att_filter = (madgwick_rate > 0 && isfinite(madgwick_rate)) || (mahony_kp > 0 && isfinite(mahony_kp));
+			// поиск числа показаний на одно обновление ориентации с компенсацией конического движения
+		cfg_ptr = fsnav_locate_token(coning_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
+		if (cfg_ptr != NULL && atoi(cfg_ptr) > 0 && !att_filter) {
+			fsnav->suspend_plugin(fsnav_ins_attitude_rodrigues);
+			printf("%s = %d\n", coning_token, atoi(cfg_ptr));
+			coning = 1;
+		}
+		else
+			fsnav->suspend_plugin(fsnav_ins_attitude_coning);
+			// поиск флага счисления ориентации по кватерниону
+		cfg_ptr = fsnav_locate_token(quat_token, fsnav->imu->cfg, fsnav->imu->cfglength, 0);
+		if (cfg_ptr != NULL && !att_filter) {
+			fsnav->suspend_plugin(fsnav_ins_attitude_rodrigues);
+			fsnav->suspend_plugin(fsnav_ins_attitude_coning);
+			printf("%s\n", quat_token);
+			coning = 0;
+		}
+		else
+			fsnav->suspend_plugin(fsnav_ins_attitude_quaternion);
+			// поиск частоты счисления скорости и положения по приращениям с компенсацией скуллинга
+		cfg_ptr = fsnav_locate_token(sculling_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
+		if (cfg_ptr != NULL)
+			sculling_rate = atof(cfg_ptr); 
+		if (sculling_rate > 0 && isfinite(sculling_rate)) {
+			fsnav->suspend_plugin(fsnav_ins_motion_euler);
+			printf("%s = %g\n", sculling_token, sculling_rate);
+			// вызов на пониженной частоте, приращения между вызовами накапливаются на шине
+			cfg_ptr = fsnav_locate_token(freq_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
+			cycle = (cfg_ptr != NULL) ? (int)floor(atof(cfg_ptr)/sculling_rate + 0.5) : 1;
+			if (cycle > 1 && !coning)
+				fsnav->reschedule_plugin(fsnav_ins_motion_sculling, cycle, 0);
+		}
+		else if (coning) {
+			// ориентация обновляется на пониженной частоте: скорость и положение — по приращениям, а не по устаревшей матрице ориентации на каждом шаге
+			fsnav->suspend_plugin(fsnav_ins_motion_euler);
+			printf("%s (%s)\n", sculling_token, coning_token);
+		}
+		else
+			fsnav->suspend_plugin(fsnav_ins_motion_sculling);
+			// при счислении ориентации на пониженной частоте скорость и положение обновляются сразу после обновления ориентации
+		if (coning)
+			fsnav->subscribe_plugin(fsnav_ins_motion_sculling, FSNAV_TOPIC_ATTITUDE);
+			// накопление приращений нужно только плагинам на пониженной частоте
+		if (!(sculling_rate > 0 && isfinite(sculling_rate)) && !coning)
+			fsnav->suspend_plugin(fsnav_accumulate_imu);
 			// поиск флага выставки по акселерометрам
 		cfg_ptr = fsnav_locate_token(accs_token, fsnav->cfg_settings, fsnav->settings_length, 0);
 		if (cfg_ptr != NULL) {
@@ -236,13 +449,17 @@ void fsnav_ins_scheduler(void)
 			fsnav->suspend_plugin(fsnav_ins_alignment_static_accs);
 			// поиск флага обнуления угла курса на этапе выставки
 		cfg_ptr = fsnav_locate_token(yaw_token, fsnav->cfg_settings, fsnav->settings_length, 0);
-		if (cfg_ptr != NULL) {
-			yaw_zero = 1;
+		if (cfg_ptr != NULL)
 			printf("yaw_zero\n");
-		}
-		else {
-			yaw_zero = 0;
+		else
 			fsnav->suspend_plugin(fsnav_ins_set_yaw_zero);
+			// переключение плагинов по окончании выставки — по сигналу от плагина выставки
+		fsnav->subscribe_plugin(fsnav_ins_alignment_finished, FSNAV_TOPIC_ALIGNMENT);
+			// поиск флага балансировки нагрузки периодических плагинов
+		cfg_ptr = fsnav_locate_token(balance_token, fsnav->cfg_settings, fsnav->settings_length, 0);
+		if (cfg_ptr != NULL) {
+			fsnav->balance_plugins(1);
+			printf("balance\n");
 		}
 
 		// временные параметры
@@ -252,12 +469,6 @@ void fsnav_ins_scheduler(void)
 			time_limit = atof(cfg_ptr);
 		if (cfg_ptr == NULL || time_limit <= 0)
 			time_limit = limit_default;
-			// поиск времени выставки в конфигурации
-		cfg_ptr = fsnav_locate_token(t0_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
-		if (cfg_ptr != NULL)
-			t0 = atof(cfg_ptr);
-		if (cfg_ptr == NULL || t0 <= 0)
-			t0 = t0_default;
 	}
 
 	// завершение работы
@@ -267,11 +478,31 @@ void fsnav_ins_scheduler(void)
 	else {
 		if (fsnav->imu->t > time_limit)
 			fsnav->mode = -1;
+	}
+}
 
-		if (fsnav->imu->t > t0 && yaw_zero) {
-			fsnav->suspend_plugin(fsnav_ins_set_yaw_zero);
-			yaw_zero = 0;
-		}
+	/*
+		переключение плагинов по окончании начальной выставки
+		использует:
+			сигнал FSNAV_TOPIC_ALIGNMENT, на который плагин подписывается диспетчером, 
+			вызывается один раз на шаге окончания выставки
+		изменяет:
+			список выполнения плагинов
+		параметры:
+			не использует параметров
+	*/
+void fsnav_ins_alignment_finished(void)
+{
+	// инициализация и завершение работы
+	if (fsnav->mode <= 0)
+		return;
+
+	// операции по сигналу
+	if (fsnav->core.current_topics & FSNAV_TOPIC_ALIGNMENT) {
+		// обнуление угла курса нужно только на этапе выставки
+		fsnav->retire_plugin(fsnav_ins_set_yaw_zero);
+		// плагин больше не нужен
+		fsnav->retire_plugin(fsnav_ins_alignment_finished);
 	}
 }
 
@@ -554,8 +785,53 @@ void fsnav_ins_read_raw_input(void)
 	}
 }
 
+	/*
+		открытие файла по имени из конфигурации, общая часть функций инициализации блочных плагинов ввода/вывода
+		вход:
+			fsnav_ins_file* file — состояние файла
+			const char* token    — имя параметра конфигурации с именем файла
+			char* cfg            — строка конфигурации
+			size_t cfglength     — длина строки конфигурации
+			const char* mode     — режим открытия файла
+		возвращаемое значение:
+			1 — файл открыт
+			0 — ошибка открытия, устанавливается fsnav->mode = -1
+	*/
+char fsnav_ins_file_open(fsnav_ins_file* file, const char* token, char* cfg, size_t cfglength, const char* mode)
+{
+	char *cfg_ptr; // указатель на параметр в строке конфигурации
+
+	// поиск имени файла в конфигурации
+	cfg_ptr = fsnav_locate_token(token, cfg, cfglength, '=');
+	if (cfg_ptr != NULL)
+		sscanf(cfg_ptr, "%s", file->buffer);
+	// открытие файла
+	file->fp = fopen(file->buffer, mode);
+	if (file->fp == NULL) {
+		printf("error: couldn't open %s file '%s'.\n", (mode[0] == 'r') ? "input" : "output", file->buffer);
+		fsnav->mode = -1;
+		return 0;
+	}
+	return 1;
+}
+
+	/*
+		закрытие файла, функция завершения работы блочных плагинов ввода/вывода
+		контекст:
+			указатель на состояние файла fsnav_ins_file
+	*/
+void fsnav_ins_file_close(void* context)
+{
+	fsnav_ins_file *file = (fsnav_ins_file*)context;
+
+	if (file->fp != NULL)
+		fclose(file->fp); // закрытие файла, если он был открыт
+	file->fp = NULL;
+}
+
 	/*	
 		чтение сырых показаний инерциальных датчиков ADIS16505-1 вместе с температурой из файла
+		блочный плагин ввода: показания считываются блоками и загружаются ядром на шину по одному на каждом шаге
 		использует:
 			не использует данные шины	
 		изменяет:
@@ -565,6 +841,8 @@ void fsnav_ins_read_raw_input(void)
 			fsnav->imu.f_valid
 			fsnav->imu.T
 			fsnav->imu.T_valid
+		контекст:
+			указатель на состояние файла fsnav_ins_file
 		параметры:
 			sensors_in — имя входного файла
 				тип: строка
@@ -572,17 +850,31 @@ void fsnav_ins_read_raw_input(void)
 				без пробелов в имени
 				с пробелом в конце
 	*/
-void fsnav_ins_read_raw_input_temp(void)
+void fsnav_ins_read_raw_input_temp_init(void* context)
 {
-	size_t i;
-
 	const char input_file_token[] = "sensors_in"; // имя параметра конфигурации с входным файлом
-	const int  n0 = 7;                            // требуемое количество параметров в строке входного файла
-														  
-	static FILE *fp = NULL;                       // указатель на файл
-	static char  buffer[FSNAV_INS_BUFFER_SIZE];    // строковый буфер
 
-	char       *cfg_ptr;        // указатель на параметр в строке конфигурации
+	fsnav_ins_file *file = (fsnav_ins_file*)context;
+
+	// проверка инерциальной подсистемы на шине
+	if (fsnav->imu == NULL)
+		return;
+
+	// открытие файла
+	if (!fsnav_ins_file_open(file, input_file_token, fsnav->cfg_settings, fsnav->settings_length, "r"))
+		return;
+	// считывание заголовка
+	fgets(file->buffer, FSNAV_INS_BUFFER_SIZE, file->fp);
+	// обеспечить завершение строки нулевым символом
+	file->buffer[FSNAV_INS_BUFFER_SIZE-1] = '\0';
+}
+
+size_t fsnav_ins_read_raw_input_temp(void* context, fsnav_imu_sample* samples, size_t n)
+{
+	size_t i, k;
+
+	fsnav_ins_file *file = (fsnav_ins_file*)context;
+
 	char       *tkn_ptr;        // указатель на токен в стоке файла
 	const char  delim[] = ",;"; // разделители
 
@@ -597,54 +889,21 @@ void fsnav_ins_read_raw_input_temp(void)
 	const double T_scale = 0.1;
 
 	// измерения
-	static int w_raw[3];
-	static int f_raw[3];
-	static int T;
-
-	// проверка инерциальной подсистемы на шине
-	if (fsnav->imu == NULL)
-		return;
+	int w_raw[3];
+	int f_raw[3];
+	int T;
 
-	// инициализация
-	if (fsnav->mode == 0) {
-		// поиск имени входного файла в конфигурации
-		cfg_ptr = fsnav_locate_token(input_file_token, fsnav->cfg_settings, fsnav->settings_length, '=');
-		if (cfg_ptr != NULL)
-			sscanf(cfg_ptr, "%s", buffer);
-		// открытие файла
-		fp = fopen(buffer, "r");
-		if (fp == NULL) {
-			printf("error: couldn't open input file '%s'.\n", buffer);
-			fsnav->mode = -1;
-			return;
-		}
-		// считывание заголовка
-		fgets(buffer, FSNAV_INS_BUFFER_SIZE, fp);
-		// обеспечить завершение строки нулевым символом
-		buffer[FSNAV_INS_BUFFER_SIZE-1] = '\0';
-	}
-
-	// завершение работы
-	else if (fsnav->mode < 0) {
-		if (fp != NULL)
-			fclose(fp); // закрытие файла, если он был открыт
-		return;
-	}
-
-	// основной цикл
-	else {
-		// сброс флагов достоверности показаний датчиков
-		fsnav->imu->w_valid = 0;
-		fsnav->imu->f_valid = 0;
+	for (k = 0; k < n; k++) {
 		// чтение строки из файла
-		if (fgets(buffer, FSNAV_INS_BUFFER_SIZE, fp) == NULL) {
-			fsnav->mode = -1; // завершение работы, если не удалось прочитать строку
-			return;
+		if (fgets(file->buffer, FSNAV_INS_BUFFER_SIZE, file->fp) == NULL) {
+			if (k == 0)
+				fsnav->mode = -1; // завершение работы, если не удалось прочитать ни одной строки
+			break;
 		}
 
 		// парсинг строки
 		// DIAG_STAT
-		tkn_ptr = strtok(buffer, delim);
+		tkn_ptr = strtok(file->buffer, delim);
 		// X_GYRO
 		tkn_ptr = strtok(NULL, delim);
 		w_raw[0] = atoi(tkn_ptr);
@@ -681,27 +940,33 @@ void fsnav_ins_read_raw_input_temp(void)
 
 		// умножение на масштабный коэффициент + перевод в радианы
 		for (i = 0; i < 3; i++) {
-			fsnav->imu->w [i] = w_raw[i] * w_scale / fsnav->imu_const.rad2deg;
-			fsnav->imu->f [i] = f_raw[i] * f_scale;
-			fsnav->imu->Tw[i] = T * T_scale;
-			fsnav->imu->Tf[i] = T * T_scale;
+			samples[k].w [i] = w_raw[i] * w_scale / fsnav->imu_const.rad2deg;
+			samples[k].f [i] = f_raw[i] * f_scale;
+			samples[k].Tw[i] = T * T_scale;
+			samples[k].Tf[i] = T * T_scale;
 		}
 
-		// установка флагов достоверности
-		fsnav->imu->w_valid  = 1;
-		fsnav->imu->f_valid  = 1;
-		fsnav->imu->Tw_valid = 1;
-		fsnav->imu->Tf_valid = 1;
+		// установка флагов достоверности, время задаётся плагином fsnav_ins_step_sync
+		samples[k].t_valid  = 0;
+		samples[k].w_valid  = 1;
+		samples[k].f_valid  = 1;
+		samples[k].Tw_valid = 1;
+		samples[k].Tf_valid = 1;
 	}
+
+	return k;
 }
 
 	/*
 		запись показаний датчиков в файл
+		блочный плагин вывода: показания сохраняются ядром на каждом шаге и записываются блоками
 		использует:
 			fsnav->imu->f
 			fsnav->imu->w
 		изменяет:
 			не изменяет данные шины
+		контекст:
+			указатель на состояние файла fsnav_ins_file
 		параметры:
 			sensors_out — имя выходного файла
 				тип: строка
@@ -709,67 +974,62 @@ void fsnav_ins_read_raw_input_temp(void)
 				без пробелов в имени
 				с пробелом в конце
 	*/
-void fsnav_ins_write_sensors(void)
-{
-	const char  sensors_file_token[] = "sensors_out";
-
 	// заголовок в выходном файле + количество выводимых символов всего и после запятой, для каждого параметра по порядку
-	const int   num_col  = 6;         
-	const char *header[] = {"w1[d/s]", "w2[d/s]", "w3[d/s]", "f1[m/s^2]", "f2[m/s^2]", "f3[m/s^2]"};
-	const int   fmt[]    = { 12,6,      12,6,      12,6,      12,6,        12,6,        12,6      };
+static const int   fsnav_ins_sensors_num_col  = 6;
+static const char *fsnav_ins_sensors_header[] = {"w1[d/s]", "w2[d/s]", "w3[d/s]", "f1[m/s^2]", "f2[m/s^2]", "f3[m/s^2]"};
+static const int   fsnav_ins_sensors_fmt[]    = { 12,6,      12,6,      12,6,      12,6,        12,6,        12,6      };
 
-	static FILE *fp = NULL;                    // указатель на файл
-	static char  buffer[FSNAV_INS_BUFFER_SIZE]; // строковый буфер
+void fsnav_ins_write_sensors_init(void* context)
+{
+	const char  sensors_file_token[] = "sensors_out";
 
-	char *cfg_ptr; // указатель на параметр в строке конфигурации
-	int   i, j;    // индексы
+	fsnav_ins_file *file = (fsnav_ins_file*)context;
+	int j; // индекс
 
 	// проверка инерциальной подсистемы на шине
 	if (fsnav->imu == NULL)
 		return;
 
-	// инициализация частного алгоритма
-	if (fsnav->mode == 0) {
-		// поиск имени выходного файла в конфигурации
-		cfg_ptr = fsnav_locate_token(sensors_file_token, fsnav->cfg, fsnav->cfglength, '=');
-		if (cfg_ptr != NULL)
-			sscanf(cfg_ptr, "%s", buffer);
-		// открытие файла
-		fp = fopen(buffer, "w");
-		if (fp == NULL) {
-			printf("error: couldn't open output file '%s'.\n", buffer);
-			fsnav->mode = -1;
-			return;
-		}		
-		// строка заголовка
-		fprintf(fp, "%%");
-		for (j = 0; j < num_col; j++)
-			fprintf(fp, "%-*s ", fmt[2*j], header[j]);
-	}
-
-	// завершение работы
-	else if (fsnav->mode < 0) {
-		if (fp != NULL)
-			fclose(fp);
+	// открытие файла
+	if (!fsnav_ins_file_open(file, sensors_file_token, fsnav->cfg, fsnav->cfglength, "w"))
 		return;
-	}
+	// строка заголовка
+	fprintf(file->fp, "%%");
+	for (j = 0; j < fsnav_ins_sensors_num_col; j++)
+		fprintf(file->fp, "%-*s ", fsnav_ins_sensors_fmt[2*j], fsnav_ins_sensors_header[j]);
+}
 
-	// операции на каждом шаге
-	else {
+size_t fsnav_ins_write_sensors(void* context, fsnav_imu_sample* samples, size_t n)
+{
+	const int *fmt = fsnav_ins_sensors_fmt;
+
+	fsnav_ins_file *file = (fsnav_ins_file*)context;
+	size_t k;    // номер показания в блоке
+	int    i, j; // индексы
+
+	if (file->fp == NULL)
+		return 0;
+
+	for (k = 0; k < n; k++) {
 		j = 0;
-		fprintf(fp, "\n");
-		for (i = 0; i < 3; i++) fprintf(fp, "%- *.*lf ", fmt[j], fmt[j+1], fsnav->imu->w[i]*fsnav->imu_const.rad2deg), j += 2;
-		for (i = 0; i < 3; i++) fprintf(fp, "%- *.*lf ", fmt[j], fmt[j+1], fsnav->imu->f[i]                        ), j += 2;
+		fprintf(file->fp, "\n");
+		for (i = 0; i < 3; i++) fprintf(file->fp, "%- *.*lf ", fmt[j], fmt[j+1], samples[k].w[i]*fsnav->imu_const.rad2deg), j += 2;
+		for (i = 0; i < 3; i++) fprintf(file->fp, "%- *.*lf ", fmt[j], fmt[j+1], samples[k].f[i]                        ), j += 2;
 	}
+
+	return n;
 }
 
 	/*
 		запись навигационного решения в файл
+		блочный плагин вывода: решение сохраняется ядром на каждом шаге и записывается блоками
 		использует:
 			fsnav->imu->t
 			fsnav->imu.sol
 		изменяет:
 			не изменяет данные шины
+		контекст:
+			указатель на состояние файла fsnav_ins_file
 		параметры:
 			out — имя выходного файла
 				тип: строка
@@ -777,102 +1037,89 @@ void fsnav_ins_write_sensors(void)
 				без пробелов в имени
 				с пробелом в конце
 	*/
-void fsnav_ins_write_output(void)
+	// заголовок в выходном фале + количество выводимых символо всего и после запятой, для каждого параметра по порядку
+static const int   fsnav_ins_output_num_col  = 10;
+static const char *fsnav_ins_output_header[] = {"time[s]", "lon[d]", "lat[d]", "hei[m]", "Ve[m/s]", "Vn[m/s]", "Vu[m/s]", "roll[d]", "pitch[d]", "heading[d]"};
+static const int   fsnav_ins_output_fmt[]    = { 11,5,      15,8,     15,8,     10,3,     10,4,      10,4,      10,4,      13,8,      12,8,       13,8       };
+
+void fsnav_ins_write_output_init(void* context)
 {
 	const char  nav_file_token[] = "nav_out";
 
-	// заголовок в выходном фале + количество выводимых символо всего и после запятой, для каждого параметра по порядку
-	const int   num_col  = 10;         
-	const char *header[] = {"time[s]", "lon[d]", "lat[d]", "hei[m]", "Ve[m/s]", "Vn[m/s]", "Vu[m/s]", "roll[d]", "pitch[d]", "heading[d]"};
-	const int   fmt[]    = { 11,5,      15,8,     15,8,     10,3,     10,4,      10,4,      10,4,      13,8,      12,8,       13,8       };
-	
-	static FILE *fp = NULL;                    // указатель на файл
-	static char  buffer[FSNAV_INS_BUFFER_SIZE]; // строковый буфер
-
-	char *cfg_ptr; // указатель на параметр в строке конфигурации
-	int   i, j;    // индексы
+	fsnav_ins_file *file = (fsnav_ins_file*)context;
+	int j; // индекс
 
 	// проверка инерциальной подсистемы на шине
 	if (fsnav->imu == NULL)
 		return;
 
-	// инициализация
-	if (fsnav->mode == 0) {
-		// поиск имени выходного файла в конфигурации
-		cfg_ptr = fsnav_locate_token(nav_file_token, fsnav->cfg, fsnav->cfglength, '=');
-		if (cfg_ptr != NULL)
-			sscanf(cfg_ptr, "%s", buffer);
-		// открытие файла
-		fp = fopen(buffer, "w");
-		if (fp == NULL) {
-			printf("error: couldn't open output file '%s'.\n", buffer);
-			fsnav->mode = -1;
-			return;
-		}		
-		// строка заголовка
-		fprintf(fp, "%%");
-		for (j = 0; j < num_col; j++)
-			fprintf(fp, "%-*s ", fmt[2*j], header[j]);
-	}
-
-	// завершение работы
-	else if (fsnav->mode < 0) {
-		if (fp != NULL)
-			fclose(fp);
+	// открытие файла
+	if (!fsnav_ins_file_open(file, nav_file_token, fsnav->cfg, fsnav->cfglength, "w"))
 		return;
-	}
+	// строка заголовка
+	fprintf(file->fp, "%%");
+	for (j = 0; j < fsnav_ins_output_num_col; j++)
+		fprintf(file->fp, "%-*s ", fsnav_ins_output_fmt[2*j], fsnav_ins_output_header[j]);
+}
 
-	// операции на каждом шаге
-	else {
-		// вывод навигационного решения в файл
+size_t fsnav_ins_write_output(void* context, fsnav_imu_sample* samples, size_t n)
+{
+	const int *fmt = fsnav_ins_output_fmt;
+
+	fsnav_ins_file *file = (fsnav_ins_file*)context;
+	fsnav_sol      *sol;  // навигационное решение
+	size_t k;             // номер решения в блоке
+	int    i, j;          // индексы
+
+	if (file->fp == NULL)
+		return 0;
+
+	// вывод навигационного решения в файл
+	for (k = 0; k < n; k++) {
+		sol = &(samples[k].sol);
 		j = 0;
-		                        fprintf(fp, "\n%- *.*lf ", fmt[j], fmt[j+1], fsnav->imu->t                                 ), j += 2;
-		for (i = 0; i < 2; i++) fprintf(fp,   "%- *.*lf ", fmt[j], fmt[j+1], fsnav->imu->sol.llh[i]*fsnav->imu_const.rad2deg), j += 2;
-		                        fprintf(fp,   "%- *.*lf ", fmt[j], fmt[j+1], fsnav->imu->sol.llh[2]                        ), j += 2;
-		for (i = 0; i < 3; i++) fprintf(fp,   "%- *.*lf ", fmt[j], fmt[j+1], fsnav->imu->sol.v  [i]                        ), j += 2;
-		for (i = 0; i < 3; i++) fprintf(fp,   "%- *.*lf ", fmt[j], fmt[j+1], fsnav->imu->sol.rpy[i]*fsnav->imu_const.rad2deg), j += 2;
+		                        fprintf(file->fp, "\n%- *.*lf ", fmt[j], fmt[j+1], samples[k].t                         ), j += 2;
+		for (i = 0; i < 2; i++) fprintf(file->fp,   "%- *.*lf ", fmt[j], fmt[j+1], sol->llh[i]*fsnav->imu_const.rad2deg), j += 2;
+		                        fprintf(file->fp,   "%- *.*lf ", fmt[j], fmt[j+1], sol->llh[2]                        ), j += 2;
+		for (i = 0; i < 3; i++) fprintf(file->fp,   "%- *.*lf ", fmt[j], fmt[j+1], sol->v  [i]                        ), j += 2;
+		fsnav_sol_get_rpy(sol); // углы ориентации по запросу
+		for (i = 0; i < 3; i++) fprintf(file->fp,   "%- *.*lf ", fmt[j], fmt[j+1], sol->rpy[i]*fsnav->imu_const.rad2deg), j += 2;
 	}
+
+	return n;
 }
 
 	/*
 		перестановка осей интерциальных датчиков к системе координат: первая ось — продольная, вторая ось — вертикальная, третья ось — по правому крылу.
+		плагин с раздельными функциями инициализации и шага
 		использует:
 			fsnav->imu->f
 			fsnav->imu->w
 		изменяет:
 			fsnav->imu->f
 			fsnav->imu->w
+		контекст:
+			указатель на матрицу перестановки осей 3x3
 		параметры:
 			не использует параметры
 	*/
-void fsnav_ins_switch_imu_axes(void)
+void fsnav_ins_switch_imu_axes_init(void* context)
 {
-	size_t i;
-	static double buf[3] = {0};
-	static double A  [9] = {0, 1, 0, 0, 0, 1, 1, 0, 0};
-
-	// проверка инерциальной подсистемы на шине
+	(void)context;
+	// отключение плагина, если инерциальная подсистема отсутствует на шине
 	if (fsnav->imu == NULL)
-		return;
-	
-	// инициализация
-	if (fsnav->mode == 0) {}
+		fsnav->suspend_plugin((void(*)(void))fsnav_ins_switch_imu_axes);
+}
 
-	// завершение работы
-	else if (fsnav->mode < 0) {}
-	
-	// операции на каждом шаге
-	else {
-		// гироскопы
-		for (i = 0; i < 3; i++)
-			buf[i] = fsnav->imu->w[i];
-		fsnav_linal_mmul(fsnav->imu->w, &A[0], &buf[0], 3, 3, 1);
+void fsnav_ins_switch_imu_axes(void* context)
+{
+	double *A = (double*)context;
 
-		// акселерометры
-		for (i = 0; i < 3; i++)
-			buf[i] = fsnav->imu->f[i];
-		fsnav_linal_mmul(fsnav->imu->f, &A[0], &buf[0], 3, 3, 1);
-	}
+	// гироскопы
+	fsnav_linal_mmul3x1(fsnav->imu->w, A, fsnav->imu->w);
+
+	// акселерометры
+	fsnav_linal_mmul3x1(fsnav->imu->f, A, fsnav->imu->f);
 }
 
 	/*
@@ -1176,13 +1423,13 @@ void fsnav_ins_imu_calibration_temp(void)
 
 		// калибровка гироскопов
 			// вычитание ошибки, связанной с перекосами и масштабами
-		fsnav_linal_mmul(&nu[0], &Theta[0], fsnav->imu->w, 3, 3, 1);
+		fsnav_linal_mmul3x1(&nu[0], &Theta[0], fsnav->imu->w);
 		for (i = 0; i < 3; i++)
 			fsnav->imu->w[i] -= nu[i];
 			// вычитание динамических дрейфов
 		for (i = 0; i < 3; i++)
 			f_g[i] =  fsnav->imu->f[i]/fabs(fsnav->imu->g[2]);
-		fsnav_linal_mmul(&nu[0], &D[0], &f_g[0], 3, 3, 1);
+		fsnav_linal_mmul3x1(&nu[0], &D[0], &f_g[0]);
 		for (i = 0; i < 3; i++)
 			fsnav->imu->w[i] -= nu[i];
 
@@ -1216,7 +1463,7 @@ void fsnav_ins_imu_calibration_temp(void)
 			fsnav->imu->f[i] -= df0[i];
 		}
 			// вычитание ошибки, связанной с перекосами и масштабами
-		fsnav_linal_mul_u(&df[0], fsnav->imu->f, &Gamma[0], 1, 3);
+		fsnav_linal_uT_mul3x1(&df[0], &Gamma[0], fsnav->imu->f);
 		for (i = 0; i < 3; i++)
 			fsnav->imu->f[i] -= df[i];
 	}
@@ -1361,9 +1608,12 @@ void fsnav_ins_alignment_static_accs(void) {
 
 	// операции на каждом шаге
 	else {
-		// проверка времени выставки
-		if (fsnav->imu->t > t0)
+		// проверка времени выставки, по окончании плагин выводится из работы
+		if (fsnav->imu->t > t0) {
+			fsnav->retire_plugin(fsnav_ins_alignment_static_accs);
+			fsnav->signal(FSNAV_TOPIC_ALIGNMENT);
 			return;
+		}
 		// обнуление флагов достоверности
 		fsnav->imu->sol.L_valid   = 0;
 		fsnav->imu->sol.q_valid   = 0;
@@ -1383,9 +1633,8 @@ void fsnav_ins_alignment_static_accs(void) {
 		// обновление матрицы ориентации
 		fsnav_linal_rpy2mat(fsnav->imu->sol.L, fsnav->imu->sol.rpy);
 		fsnav->imu->sol.L_valid = 1;
-		// обновление кватерниона
-		fsnav_linal_mat2quat(fsnav->imu->sol.q  , fsnav->imu->sol.L);
-		fsnav->imu->sol.q_valid = 1;
+		// кватернион вычисляется по запросу
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_RPY | FSNAV_SOL_L);
 		// обнуление скорости (поскольку предполагается статическая выставка)
 		for (i = 0; i < 3; i++)
 			fsnav->imu->sol.v[i] = 0;
@@ -1477,9 +1726,8 @@ void fsnav_ins_alignment_static_const(void)
 		// обновление матрицы ориентации
 		fsnav_linal_rpy2mat(fsnav->imu->sol.L, fsnav->imu->sol.rpy);
 		fsnav->imu->sol.L_valid = 1;
-		// обновление кватерниона
-		fsnav_linal_mat2quat(fsnav->imu->sol.q  , fsnav->imu->sol.L);
-		fsnav->imu->sol.q_valid = 1;
+		// кватернион вычисляется по запросу
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_RPY | FSNAV_SOL_L);
 		// обнуление скорости (поскольку предполагается статическая выставка)
 		for (i = 0; i < 3; i++)
 			fsnav->imu->sol.v[i] = 0;
@@ -1490,12 +1738,14 @@ void fsnav_ins_alignment_static_const(void)
 	/*
 		обнуление угла курса
 		использует:
-			не использует данные шины
+			fsnav->imu->sol.rpy (fsnav_sol_get_rpy)
 		изменяет:
 			fsnav->imu->sol.rpy_valid
 			fsnav->imu->sol.L_valid
+			fsnav->imu->sol.q_valid
 			fsnav->imu->sol.rpy[2]
 			fsnav->imu->sol.L
+			fsnav->imu->sol.q
 		параметры:
 			не использует параметров
 	*/
@@ -1513,6 +1763,10 @@ void fsnav_ins_set_yaw_zero(void)
 
 	// операции на каждом шаге
 	else {
+		// углы ориентации по текущему представлению
+		if (fsnav_sol_get_rpy(&(fsnav->imu->sol)) == NULL)
+			return;
+
 		// сброс флагов достоверности
 		fsnav->imu->sol.rpy_valid = 0;
 		fsnav->imu->sol.  L_valid = 0;
@@ -1521,181 +1775,9 @@ void fsnav_ins_set_yaw_zero(void)
 		fsnav->imu->sol.rpy[2] = 0.0;
 		fsnav_linal_rpy2mat(fsnav->imu->sol.L, fsnav->imu->sol.rpy);
 
-		// установка флагов достоверности
+		// установка флагов достоверности, кватернион вычисляется по запросу
 		fsnav->imu->sol.rpy_valid = 1;
 		fsnav->imu->sol.  L_valid = 1;
-	}
-}
-
-	/*
-		фильтр Маджвика для счисления ориентации
-		использует:
-			fsnav->imu->t
-			fsnav->imu->f
-			fsnav->imu->f_valid
-			fsnav->imu->w
-			fsnav->imu->w_valid
-			fsnav->imu->sol.L
-			fsnav->imu->sol.L_valid
-		изменяет:
-			fsnav->imu->sol.q
-			fsnav->imu->sol.q_valid
-			fsnav->imu->sol.rpy
-			fsnav->imu->sol.rpy_valid
-		параметры:
-			{imu: madgwick_feedback_rate} — параметр настройки фильтра Маджвика, градусы/сек
-				тип: число с плавающей точкой
-				диапазон: +0 до +inf
-				пример: {imu: madgwick_feedback_rate = 0.003}
-	*/
-void fsnav_ins_attitude_madgwick(void) {
-
-	static double t0 = -1;  // начальное время
-	static double
-		C[9],               // переходная матрица
-		*L;                 // указатель на матрицу ориентации навигационного решения
-
-	char *cfg_ptr;                      // указатель на параметр в строке конфигурации
-	const char madgwick_token[] = "madgwick_feedback_rate";
-	static double feedback_rate = -1;   // настраиваемый параметр, рад/сек, ~sqrt(3)*(остаточный дрейф гироскопов)
-	const double epsilon = 1.0/1048576; // 2^-20 ~ 1e-6 
-
-	double
-		a[3],
-		s,
-		dt,                         // шаг времени
-		w_madgwick[4],              // угловая скорость
-		a_madgwick[3],              // измерения акселерометров
-		J_madgwick[3][4],           // якобиан
-		f_madgwick[3],              // целевая функция
-		vector1_4[4],               // grad(f)
-		vector2_4[4];               // 2*dq/dt
-	size_t i;                       // индекс
-
-	// инициализация
-	if (fsnav->mode == 0) {
-
-		// проверка инерциальной подсистемы на шине
-		if (fsnav->imu == NULL)
-			return;
-		// сброс флагов достоверности
-		fsnav->imu->sol.q_valid = 0;
-		fsnav->imu->sol.L_valid = 0;
-		fsnav->imu->sol.rpy_valid = 0;
-		// указатель на матрицу ориентации imu->sol
-		L = fsnav->imu->sol.L;
-		// единичный кватернион
-		for (i = 1, fsnav->imu->sol.q[0] = 1; i < 4; i++)
-			fsnav->imu->sol.q[i] = 0;
-		fsnav->imu->sol.q_valid = 1;
-		// матрица ориентации
-		fsnav_linal_quat2mat(L, fsnav->imu->sol.q);
-		fsnav->imu->sol.L_valid = 1;
-		// углы ориентации, соответствующие матрице ориентации
-		fsnav_linal_mat2rpy(fsnav->imu->sol.rpy, L);
-		fsnav->imu->sol.rpy_valid = 1;
-		// обнуление начального времени
-		t0 = -1;
-
-		cfg_ptr = fsnav_locate_token(madgwick_token, fsnav->imu->cfg, fsnav->imu->cfglength, '=');
-		if (cfg_ptr != NULL)
-			feedback_rate = atof(cfg_ptr)/fsnav->imu_const.rad2deg;
-		else
-			return;
-
-	}
-
-	// завершение работы
-	else if (fsnav->mode < 0) {}
-	
-	// операции на каждом шаге
-	else {
-		// проверка достоверности необходимых данных
-		if (!fsnav->imu->sol.L_valid || !fsnav->imu->w_valid || !fsnav->imu->f_valid)
-			return;
-		// временнЫе переменные
-		if (t0 < 0) {
-			t0 = fsnav->imu->t;
-			return;
-		}
-		dt = fsnav->imu->t - t0;
-		t0 = fsnav->imu->t;
-
-		for (i = 0, w_madgwick[0] = 0; i < 3; i++)
-			w_madgwick[i+1] = fsnav->imu->w[i];
-
-		for (i = 0, w_madgwick[0] = 0; i < 3; i++)
-			a_madgwick[i] = fsnav->imu->f[i];
-
-		double g0 = 0;
-		double g1 = 0;
-		double g2 = 1.0;
-		// формирование целевой функции
-		s = fsnav_linal_vnorm(a_madgwick, 3);
-		f_madgwick[0] = 2.0*g0*(0.5 - fsnav->imu->sol.q[2]*fsnav->imu->sol.q[2] - fsnav->imu->sol.q[3]*fsnav->imu->sol.q[3])
-		              + 2.0*g1*(      fsnav->imu->sol.q[0]*fsnav->imu->sol.q[3] + fsnav->imu->sol.q[1]*fsnav->imu->sol.q[2])
-		              + 2.0*g2*(      fsnav->imu->sol.q[1]*fsnav->imu->sol.q[3] - fsnav->imu->sol.q[0]*fsnav->imu->sol.q[2]) - a_madgwick[0]/s;
-		f_madgwick[1] = 2.0*g0*(      fsnav->imu->sol.q[1]*fsnav->imu->sol.q[2] - fsnav->imu->sol.q[0]*fsnav->imu->sol.q[3])
-		              + 2.0*g1*(0.5 - fsnav->imu->sol.q[1]*fsnav->imu->sol.q[1] - fsnav->imu->sol.q[3]*fsnav->imu->sol.q[3])
-		              + 2.0*g2*(      fsnav->imu->sol.q[0]*fsnav->imu->sol.q[1] + fsnav->imu->sol.q[2]*fsnav->imu->sol.q[3]) - a_madgwick[1]/s;
-		f_madgwick[2] = 2.0*g0*(      fsnav->imu->sol.q[0]*fsnav->imu->sol.q[2] + fsnav->imu->sol.q[1]*fsnav->imu->sol.q[3])
-		              + 2.0*g1*(      fsnav->imu->sol.q[2]*fsnav->imu->sol.q[3] - fsnav->imu->sol.q[0]*fsnav->imu->sol.q[1])
-		              + 2.0*g2*(0.5 - fsnav->imu->sol.q[1]*fsnav->imu->sol.q[1] - fsnav->imu->sol.q[2]*fsnav->imu->sol.q[2]) - a_madgwick[2]/s;
-		// формирование якобиана
-		J_madgwick[0][0] =  2.0*g1*fsnav->imu->sol.q[3] - 2.0*g2*fsnav->imu->sol.q[2]; 
-		J_madgwick[0][1] =  2.0*g1*fsnav->imu->sol.q[2] + 2.0*g2*fsnav->imu->sol.q[3]; 
-		J_madgwick[0][2] = -4.0*g0*fsnav->imu->sol.q[2] + 2.0*g1*fsnav->imu->sol.q[1] - 2.0*g2*fsnav->imu->sol.q[0]; 
-		J_madgwick[0][3] = -4.0*g0*fsnav->imu->sol.q[3] + 2.0*g1*fsnav->imu->sol.q[0] + 2.0*g2*fsnav->imu->sol.q[1];
-		J_madgwick[1][0] = -2.0*g0*fsnav->imu->sol.q[3] + 2.0*g2*fsnav->imu->sol.q[1];
-		J_madgwick[1][1] =  2.0*g0*fsnav->imu->sol.q[2] - 4.0*g1*fsnav->imu->sol.q[1] + 2.0*g2*fsnav->imu->sol.q[0];
-		J_madgwick[1][2] =  2.0*g0*fsnav->imu->sol.q[1] + 2.0*g2*fsnav->imu->sol.q[3];
-		J_madgwick[1][3] = -2.0*g0*fsnav->imu->sol.q[0] - 4.0*g1*fsnav->imu->sol.q[3] + 2.0*g2*fsnav->imu->sol.q[2];
-		J_madgwick[2][0] =  2.0*g0*fsnav->imu->sol.q[2] - 2.0*g1*fsnav->imu->sol.q[1];
-		J_madgwick[2][1] =  2.0*g0*fsnav->imu->sol.q[3] - 2.0*g1*fsnav->imu->sol.q[0] - 4.0*g2*fsnav->imu->sol.q[1];
-		J_madgwick[2][2] =  2.0*g0*fsnav->imu->sol.q[0] + 2.0*g1*fsnav->imu->sol.q[3] - 4.0*g2*fsnav->imu->sol.q[2];
-		J_madgwick[2][3] =  2.0*g0*fsnav->imu->sol.q[1] + 2.0*g1*fsnav->imu->sol.q[2];
-		
-		for (i = 0; i < 4; i++)
-			vector1_4[i] = J_madgwick[0][i]*f_madgwick[0] + J_madgwick[1][i]*f_madgwick[1] + J_madgwick[2][i]*f_madgwick[2];
-
-		fsnav_linal_qmul(vector2_4, fsnav->imu->sol.q, w_madgwick);
-		// интегрирование
-		for (i = 0; i < 4; i++) // для избежания деления на ноль
-			fsnav->imu->sol.q[i] += 0.5*(vector2_4[i] - feedback_rate*vector1_4[i]/(epsilon + fsnav_linal_vnorm(vector1_4,4)))*dt;
-
-		// норма
-		s = fsnav_linal_vnorm(fsnav->imu->sol.q, 4);
-		for (i = 0; i < 4; i++)
-			fsnav->imu->sol.q[i] /= s;
-
-		// L = L(q)
-		fsnav_linal_quat2mat(L, fsnav->imu->sol.q);
-
-		// опорный трёхгранник
-		// a <- c = (W + u)*dt
-		for (i = 0; i < 3; i++)
-			a[i] = fsnav->imu->W_valid ? fsnav->imu->W[i] : 0;
-		if (fsnav->imu->sol.llh_valid) {
-			a[1] += fsnav->imu_const.u*cos(fsnav->imu->sol.llh[1]);
-			a[2] += fsnav->imu_const.u*sin(fsnav->imu->sol.llh[1]);
-		}
-		for (i = 0; i < 3; i++)
-			a[i] *= dt;
-		// L = L*(E + [c x]*sin(c)/|c| + [c x]^2*(1-cos(c))/|c|^2)^T
-		fsnav_linal_eul2mat(C, a);	// C = E + [c x]*sin(c)/|c| + [c x]^2*(1-cos(c))/|c|^2
-		for (i = 0; i < 9; i += 3) { // L = L*C^T
-			a[0] = L[i+0];
-			a[1] = L[i+1]; 
-			a[2] = L[i+2];
-			L[i+0] = a[0]*C[0] + a[1]*C[1] + a[2]*C[2];
-			L[i+1] = a[0]*C[3] + a[1]*C[4] + a[2]*C[5];
-			L[i+2] = a[0]*C[6] + a[1]*C[7] + a[2]*C[8];
-		}
-		// обновление кватерниона ориентации
-		fsnav_linal_mat2quat(fsnav->imu->sol.q, L);
-		fsnav->imu->sol.q_valid = 1;
-		// обновление углов ориентации
-		fsnav_linal_mat2rpy(fsnav->imu->sol.rpy, L);
-		fsnav->imu->sol.rpy_valid = 1;
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_RPY | FSNAV_SOL_L);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+/*
+	последовательность частных алгоритмов (плагинов) навигационного решения fsnav_ins
+
+	перед включением файла должны быть определены макросы:
+		FSNAV_INS_PLUGIN(plugin)                              — плагин с единственной функцией
+		FSNAV_INS_PLUGIN_EXT(init, step, terminate, context)  — плагин с раздельными функциями и контекстом
+		FSNAV_INS_PLUGIN_BLOCK(init, block, terminate, context, role) — блочный плагин ввода/вывода
+	файл включается дважды: для добавления плагинов на шину и для генерации статической функции шага,
+	поэтому порядок плагинов в обоих случаях совпадает
+*/
+
+FSNAV_INS_PLUGIN    (fsnav_ins_step_sync              ) // ожидание метки времени шага навигационного решения
+FSNAV_INS_PLUGIN    (fsnav_ins_scheduler              ) // диспетчер
+FSNAV_INS_PLUGIN_BLOCK(fsnav_ins_read_raw_input_temp_init, // считывание сырых показаний датчиков, температуры и их преобразование
+                       fsnav_ins_read_raw_input_temp, fsnav_ins_file_close, &fsnav_ins_sensors_in, FSNAV_BLOCK_INPUT)
+FSNAV_INS_PLUGIN    (fsnav_ins_imu_calibration_temp   ) // вычисление откалиброванных показаний датчиков (температурная модель)
+FSNAV_INS_PLUGIN_EXT(fsnav_ins_switch_imu_axes_init,    // перестановка осей инерциальных датчиков
+                     fsnav_ins_switch_imu_axes, NULL, fsnav_ins_imu_axes)
+FSNAV_INS_PLUGIN    (fsnav_accumulate_imu             ) // накопление приращений показаний датчиков для плагинов на пониженной частоте
+FSNAV_INS_PLUGIN_BLOCK(fsnav_ins_write_sensors_init,       // запись преобразованных показаний датчиков
+                       fsnav_ins_write_sensors, fsnav_ins_file_close, &fsnav_ins_sensors_out, FSNAV_BLOCK_OUTPUT)
+FSNAV_INS_PLUGIN    (fsnav_ins_gravity_normal         ) // модель поля силы тяжести: стандартная
+FSNAV_INS_PLUGIN    (fsnav_ins_gravity_constant       ) // модель поля силы тяжести: постоянная
+FSNAV_INS_PLUGIN    (fsnav_ins_gravity_egm08          ) // аномалии силы тяжести по сетке EGM2008
+FSNAV_INS_PLUGIN    (fsnav_ins_alignment_static       ) // начальная выставка: по акселерометрам и гироскопам
+FSNAV_INS_PLUGIN    (fsnav_ins_alignment_static_accs  ) // начальная выставка: только по акселерометрам
+FSNAV_INS_PLUGIN    (fsnav_ins_alignment_finished     ) // переключение плагинов по окончании выставки (по сигналу)
+FSNAV_INS_PLUGIN    (fsnav_ins_set_yaw_zero           ) // обнуление угла курса
+FSNAV_INS_PLUGIN    (fsnav_ins_attitude_rodrigues     ) // ориентация
+FSNAV_INS_PLUGIN    (fsnav_ins_attitude_quaternion    ) // ориентация по кватерниону
+FSNAV_INS_PLUGIN    (fsnav_ins_attitude_coning        ) // ориентация на пониженной частоте с компенсацией конического движения
+FSNAV_INS_PLUGIN    (fsnav_ins_attitude_madgwick      ) // фильтр Мэджвика
+FSNAV_INS_PLUGIN_EXT(fsnav_ins_attitude_mahony_init,    // комплементарный фильтр Махони
+                     fsnav_ins_attitude_mahony, NULL, &fsnav_ins_mahony)
+FSNAV_INS_PLUGIN    (fsnav_ins_motion_euler           ) // положение и скорость
+FSNAV_INS_PLUGIN    (fsnav_ins_motion_sculling        ) // положение и скорость на пониженной частоте по приращениям с компенсацией скуллинга
+FSNAV_INS_PLUGIN    (fsnav_ins_motion_vertical_damping) // демпфирование в вертикальном канале
+FSNAV_INS_PLUGIN_BLOCK(fsnav_ins_write_output_init,        // запись навигационного решения
+                       fsnav_ins_write_output, fsnav_ins_file_close, &fsnav_ins_nav_out, FSNAV_BLOCK_OUTPUT)
+FSNAV_INS_PLUGIN    (fsnav_ins_print_progress         ) // вывод на экран
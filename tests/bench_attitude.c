@@ -0,0 +1,154 @@
+// attitude plugins on the bus: Rodrigues' rotation formula against Madgwick and Mahony filters,
+// each one run alone on the same tilted sensor turning about the vertical, starting from level attitude:
+// the filters bring the estimated vertical to the specific force direction within their gains, Rodrigues' formula keeps the initial tilt
+
+#include <math.h>
+#include <stdio.h>
+
+#include "fsnav.h"
+#include "ins/fsnav_ins_attitude.h"
+#include "fsnav_test.h"
+
+#define FILTERS 3
+#define DT      0.01  // sample interval, s
+#define RATE    0.2   // angular rate about the vertical, rad/s
+#define ROLL    10    // sensor roll off level, deg
+#define PITCH   5     // sensor pitch, deg
+#define BETA    1     // Madgwick feedback rate, deg/s
+#define KP      0.5   // Mahony proportional gain, 1/s
+#define KI      0.001 // Mahony integral gain, 1/s^2
+
+static int repeat = 15;   // timing repetitions, alternating the plugins, the best one is taken
+static int steps  = 5000; // bus steps per repetition
+
+static fsnav_ins_attitude_mahony_state mahony; // Mahony filter context
+static double clock_k[FILTERS];               // time seen by each plugin, continuous over the repetitions
+static int    active;                         // plugin being run
+static double u[3];                           // vertical in the instrumental frame
+
+static void(*plugins[FILTERS])(void) = {
+	fsnav_ins_attitude_rodrigues,
+	fsnav_ins_attitude_madgwick,
+	(void(*)(void))fsnav_ins_attitude_mahony
+};
+static const char* names[FILTERS] = {"Rodrigues", "Madgwick", "Mahony"};
+
+	// tilted sensor turning about the vertical, specific force along the vertical
+static void imu_source(void)
+{
+	size_t i;
+
+	if (fsnav->mode <= 0 || fsnav->imu == NULL)
+		return;
+	clock_k[active] += DT;
+	fsnav->imu->t = clock_k[active];
+	for (i = 0; i < 3; i++) {
+		fsnav->imu->w[i] = RATE*u[i];
+		fsnav->imu->f[i] = fsnav->imu_const.ge*u[i];
+	}
+	fsnav->imu->w_valid = 1;
+	fsnav->imu->f_valid = 1;
+}
+
+	// time per bus step, nanoseconds, with one attitude plugin resumed and the others suspended,
+	// starting from level attitude with no integral correction; estimated vertical, the third column of the attitude matrix
+static double run(int k, double* v)
+{
+	double t, *L;
+	int i;
+
+	for (i = 0; i < FILTERS; i++)
+		(i == k) ? fsnav->resume_plugin(plugins[i]) : fsnav->suspend_plugin(plugins[i]);
+	active = k;
+	for (i = 1, fsnav->imu->sol.q[0] = 1; i < 4; i++)
+		fsnav->imu->sol.q[i] = 0;
+	fsnav->imu->sol.q_valid = 1;
+	fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_Q);
+	for (i = 0; i < 3; i++)
+		mahony.b[i] = 0;
+
+	t = fsnav_test_time();
+	for (i = 0; i < steps; i++)
+		fsnav->step();
+	t = (fsnav_test_time() - t)/steps*1e9;
+
+	L = fsnav_sol_get_L(&(fsnav->imu->sol));
+	for (i = 0; i < 3; i++)
+		v[i] = (L != NULL) ? L[3*i + 2] : NAN;
+	return t;
+}
+
+	// angle between unit vectors, rad
+static double angle(double* a, double* b)
+{
+	double c[3];
+
+	fsnav_linal_cross3x1(c, a, b);
+	return atan2(sqrt(c[0]*c[0] + c[1]*c[1] + c[2]*c[2]), a[0]*b[0] + a[1]*b[1] + a[2]*b[2]);
+}
+
+	// roll and pitch of a vertical in the instrumental frame, as fsnav_linal_mat2rpy takes them from the third column, rad
+static void roll_pitch(double* rp, double* v)
+{
+	rp[0] = -atan2(v[2], v[1]);
+	rp[1] =  atan2(v[0], sqrt(v[1]*v[1] + v[2]*v[2]));
+}
+
+int main(int argc, char** argv)
+{
+	char cfg[128];
+	double t[FILTERS], v[FILTERS][3], rp[2], rp_k[2], e[FILTERS], tk, tilt, T, tol[FILTERS], rpy[3], R[9], rad2deg;
+	int r, k, i;
+
+	if (argc > 1) // quick run, to check the results only
+		repeat = 1;
+	(void)argv;
+
+	sprintf(cfg, "{imu: madgwick_feedback_rate = %g, mahony_kp = %g, mahony_ki = %g}", (double)BETA, (double)KP, (double)KI);
+	fsnav->add_plugin(imu_source);
+	fsnav->add_plugin(fsnav_ins_attitude_rodrigues);
+	fsnav->add_plugin(fsnav_ins_attitude_madgwick);
+	fsnav->add_plugin_ext(fsnav_ins_attitude_mahony_init, fsnav_ins_attitude_mahony, NULL, &mahony);
+	fsnav->init(cfg);
+	fsnav->step(); // init cycle
+
+	// vertical of the sensor rolled and pitched off level, level being roll of -90 deg for the identity attitude
+	rad2deg = fsnav->imu_const.rad2deg;
+	rpy[0] = (ROLL - 90)/rad2deg, rpy[1] = PITCH/rad2deg, rpy[2] = 0;
+	fsnav_linal_rpy2mat(R, rpy);
+	for (i = 0; i < 3; i++)
+		u[i] = R[3*i + 2];
+	roll_pitch(rp, u);
+
+	for (r = 0; r < repeat; r++)
+		for (k = 0; k < FILTERS; k++) {
+			tk = run(k, v[k]);
+			if (r == 0 || tk < t[k])
+				t[k] = tk;
+		}
+
+	// initial tilt, then Madgwick correction at the feedback rate, to within a step of it,
+	// Mahony correction with the time constant 1/kp, less the slow integral mode of ki/kp^2 relative amplitude
+	tilt = acos(u[2]);
+	T    = steps*DT;
+	tol[0] = tilt;
+	tol[1] = ((tilt > BETA/rad2deg*T) ? tilt - BETA/rad2deg*T : 0) + 2*BETA/rad2deg*DT;
+	tol[2] = tilt*(exp(-KP*T) + 2*KI/(KP*KP));
+
+	printf("ns per bus step, %d steps at %.0f Hz, turn rate %.1f rad/s, sensor roll %d deg, pitch %d deg off level\n", steps, 1/DT, RATE, ROLL, PITCH);
+	printf("%-10s %8s %6s   %13s %13s %13s\n", "", "ns", "", "roll err,deg", "pitch err,deg", "tilt err,deg");
+	for (k = 0; k < FILTERS; k++) {
+		e[k] = angle(v[k], u);
+		roll_pitch(rp_k, v[k]);
+		printf("%-10s %8.1f (%4.2f)   %13.6f %13.6f %13.6f (tolerance %.6f)\n",
+			names[k], t[k], t[k]/t[0], (rp_k[0] - rp[0])*rad2deg, (rp_k[1] - rp[1])*rad2deg, e[k]*rad2deg, tol[k]*rad2deg);
+	}
+	fsnav_test_check(fabs(e[0] - tol[0]) < 1e-9, "Rodrigues' formula keeps the initial tilt turning about the vertical");
+	fsnav_test_check(e[1] < tol[1], "Madgwick filter brings the estimated vertical to the specific force direction");
+	fsnav_test_check(e[2] < tol[2], "Mahony filter brings the estimated vertical to the specific force direction");
+	fsnav_test_check(mahony.t0 == clock_k[2], "Mahony filter state is kept in its context");
+
+	fsnav->terminate();
+	fsnav->step();
+	return fsnav_test_result();
+}
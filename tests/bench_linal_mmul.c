@@ -0,0 +1,124 @@
+// matrix products in 4 x 4 register tiles (fsnav_linal_mmul_blocked, fsnav_linal_tile4x4) against element-wise loops,
+// GFLOP/s for square matrices, sizes not multiple of 4 included, results checked to be bitwise equal
+// the core is compiled into this program to reach the blocked kernel below FSNAV_LINAL_BLOCK_MIN
+
+#include "../libs/fsnav.c"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "fsnav_test.h"
+
+#define N_MAX 128
+#define SIZES 12
+
+static int    repeat = 11;  // timing repetitions, alternating element-wise and blocked products, the best one is taken
+static double flops  = 2e7; // floating point operations per repetition
+
+static double a[N_MAX*N_MAX], b[N_MAX*N_MAX], rn[N_MAX*N_MAX], rb[N_MAX*N_MAX];
+static volatile double sink;
+
+static double rnd(void) { return rand()/(RAND_MAX + 1.0) - 0.5; }
+
+	// element-wise product res[i*m+j] = sum(a[i*ar + p*ap]*b[j*bc + p*bp]), as in fsnav_linal_mmul below FSNAV_LINAL_BLOCK_MIN
+static void naive(double* res, double* a, size_t ar, size_t ap, double* b, size_t bc, size_t bp, size_t n, size_t m, size_t len)
+{
+	size_t i, j, p, ka, kb;
+
+	for (i = 0; i < n; i++)
+		for (j = 0; j < m; j++) {
+			ka = i*ar, kb = j*bc;
+			res[i*m+j] = a[ka]*b[kb];
+			for (ka += ap, kb += bp, p = 1; p < len; ka += ap, kb += bp, p++)
+				res[i*m+j] += a[ka]*b[kb];
+		}
+}
+static void (*volatile naive_p)(double*, double*, size_t, size_t, double*, size_t, size_t, size_t, size_t, size_t) = naive;
+static void (*volatile blocked_p)(double*, double*, size_t, size_t, double*, size_t, size_t, size_t, size_t, size_t) = fsnav_linal_mmul_blocked;
+
+	// GFLOP/s of a square n x n product
+static double run(int blocked, size_t n)
+{
+	const int calls = (int)(flops/(2.0*n*n*n)) + 1;
+	double t, acc = 0;
+	int c;
+
+	t = fsnav_test_time();
+	for (c = 0; c < calls; c++) {
+		if (blocked)
+			blocked_p(rb, a, n, 1, b, 1, n, n, n, n);
+		else
+			naive_p  (rn, a, n, 1, b, 1, n, n, n, n);
+		acc += blocked ? rb[0] : rn[0];
+	}
+	sink = acc;
+	return 2.0*n*n*n*calls/(fsnav_test_time() - t)*1e-9;
+}
+
+	// best GFLOP/s of element-wise and blocked products, measured alternately
+static void bench(size_t n, double* gn, double* gb)
+{
+	double g;
+	int r;
+
+	for (r = 0; r < repeat; r++) {
+		g = run(0, n);
+		if (r == 0 || g > *gn)
+			*gn = g;
+		g = run(1, n);
+		if (r == 0 || g > *gb)
+			*gb = g;
+	}
+}
+
+	// mmul, mmul1T and mmul2T of n x n1 and n1 x m matrices give bitwise equal results to element-wise loops, whether blocked or not
+static int equal(size_t n, size_t n1, size_t m)
+{
+	int ok = 1;
+
+	fsnav_linal_mmul  (rb, a, b, n, n1, m); // a: n x n1, b: n1 x m
+	naive             (rn, a, n1, 1, b, 1, m, n, m, n1);
+	ok &= memcmp(rb, rn, n*m*sizeof(double)) == 0;
+	fsnav_linal_mmul1T(rb, a, b, n1, n, m); // a: n1 x n, b: n1 x m
+	naive             (rn, a, 1, n, b, 1, m, n, m, n1);
+	ok &= memcmp(rb, rn, n*m*sizeof(double)) == 0;
+	fsnav_linal_mmul2T(rb, a, b, n, n1, m); // a: n x n1, b: m x n1
+	naive             (rn, a, n1, 1, b, n1, 1, n, m, n1);
+	ok &= memcmp(rb, rn, n*m*sizeof(double)) == 0;
+	fsnav_linal_mmul_blocked(rb, a, n1, 1, b, 1, m, n, m, n1);
+	naive                   (rn, a, n1, 1, b, 1, m, n, m, n1);
+	ok &= memcmp(rb, rn, n*m*sizeof(double)) == 0;
+
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	const size_t n[SIZES] = {4, 7, 8, 13, 16, 17, 23, 32, 45, 64, 97, 128};
+	double gn = 0, gb = 0;
+	size_t k, i, j, p;
+
+	if (argc > 1) { // quick run, to check the results only
+		repeat = 1;
+		flops  = 1;
+	}
+	(void)argv;
+	srand(38);
+	for (k = 0; k < N_MAX*N_MAX; k++) {
+		a[k] = rnd();
+		b[k] = rnd();
+	}
+
+	for (i = 1; i <= 37; i += 4)
+		for (j = 1; j <= 37; j += 3)
+			for (p = 1; p <= 37; p += 6)
+				fsnav_test_check(equal(i, p, j), "matrix products match element-wise loops bitwise");
+
+	printf("GFLOP/s, element-wise -> blocked (speedup), * for sizes blocked in the core\n");
+	for (k = 0; k < SIZES; k++) {
+		bench(n[k], &gn, &gb);
+		printf("%4u   %6.2f -> %6.2f (%4.2f)%c\n", (unsigned)n[k], gn, gb, gb/gn, (n[k] >= FSNAV_LINAL_BLOCK_MIN) ? '*' : ' ');
+	}
+
+	return fsnav_test_result();
+}
@@ -0,0 +1,172 @@
+// size-specialized square root Kalman kernels against the generic loops, n = FSNAV_LINAL_SIZE_MIN..FSNAV_LINAL_SIZE_MAX,
+// to choose the sizes each kernel is specialized for in the core (marked with *)
+// the core is compiled into this program to reach the kernel bodies
+
+#include "../libs/fsnav.c"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "fsnav_test.h"
+
+#define N_MAX   FSNAV_LINAL_SIZE_MAX
+#define U_MAX   (N_MAX*(N_MAX+1)/2)
+#define KERNELS 5     // uuT, chol, residual check, update, gated update
+
+static int repeat = 21;    // timing repetitions, alternating generic and specialized kernels, the best one is taken
+static int calls  = 20000; // calls per repetition
+
+	// generic kernels, n taken at run time, called through volatile pointers, so that the compiler cannot specialize them for a constant n
+static void   generic_uuT   (double* res, double* u, size_t n)                                                            FSNAV_LINAL_UUT_BODY(n)
+static void   generic_chol  (double* S, double* P, size_t n)                                                              FSNAV_LINAL_CHOL_BODY(n)
+static char   generic_check (double* x, double* S, double z, double* h, double sigma, double k_sigma, size_t n)            FSNAV_LINAL_CHECK_RESIDUAL_BODY(n)
+static double generic_update(double* x, double* S, double* K, double z, double* h, double sigma, size_t n)                FSNAV_LINAL_KALMAN_UPDATE_BODY(n)
+static char   generic_gated (double* x, double* S, double* K, double* nu, double z, double* h, double sigma, double k_sigma, size_t n) FSNAV_LINAL_KALMAN_UPDATE_GATED_BODY(n)
+static void  (*volatile uuT_g)   (double*, double*, size_t)                                                 = generic_uuT;
+static void  (*volatile chol_g)  (double*, double*, size_t)                                                 = generic_chol;
+static char  (*volatile check_g) (double*, double*, double, double*, double, double, size_t)                = generic_check;
+static double(*volatile update_g)(double*, double*, double*, double, double*, double, size_t)               = generic_update;
+static char  (*volatile gated_g) (double*, double*, double*, double*, double, double*, double, double, size_t) = generic_gated;
+
+	// specialized kernels for all sizes, whether dispatched by the core or not
+#define BENCH_UUT_N(N)      static void   FSNAV_LINAL_SIZES_CAT(bench_uuT_, N)   (double* res, double* u) FSNAV_LINAL_UUT_BODY(N)
+#define BENCH_CHOL_N(N)     static void   FSNAV_LINAL_SIZES_CAT(bench_chol_, N)  (double* S, double* P) FSNAV_LINAL_CHOL_BODY(N)
+#define BENCH_CHECK_N(N)    static char   FSNAV_LINAL_SIZES_CAT(bench_check_, N) (double* x, double* S, double z, double* h, double sigma, double k_sigma) FSNAV_LINAL_CHECK_RESIDUAL_BODY(N)
+#define BENCH_UPDATE_N(N)   static double FSNAV_LINAL_SIZES_CAT(bench_update_, N)(double* x, double* S, double* K, double z, double* h, double sigma) FSNAV_LINAL_KALMAN_UPDATE_BODY(N)
+#define BENCH_GATED_N(N)    static char   FSNAV_LINAL_SIZES_CAT(bench_gated_, N) (double* x, double* S, double* K, double* nu, double z, double* h, double sigma, double k_sigma) FSNAV_LINAL_KALMAN_UPDATE_GATED_BODY(N)
+#define BENCH_UUT_PTR(N)    FSNAV_LINAL_SIZES_CAT(bench_uuT_, N),
+#define BENCH_CHOL_PTR(N)   FSNAV_LINAL_SIZES_CAT(bench_chol_, N),
+#define BENCH_CHECK_PTR(N)  FSNAV_LINAL_SIZES_CAT(bench_check_, N),
+#define BENCH_UPDATE_PTR(N) FSNAV_LINAL_SIZES_CAT(bench_update_, N),
+#define BENCH_GATED_PTR(N)  FSNAV_LINAL_SIZES_CAT(bench_gated_, N),
+FSNAV_LINAL_SIZES(BENCH_UUT_N)
+FSNAV_LINAL_SIZES(BENCH_CHOL_N)
+FSNAV_LINAL_SIZES(BENCH_CHECK_N)
+FSNAV_LINAL_SIZES(BENCH_UPDATE_N)
+FSNAV_LINAL_SIZES(BENCH_GATED_N)
+static void  (*const uuT_s[])   (double*, double*)                                                 = { FSNAV_LINAL_SIZES(BENCH_UUT_PTR) };
+static void  (*const chol_s[])  (double*, double*)                                                 = { FSNAV_LINAL_SIZES(BENCH_CHOL_PTR) };
+static char  (*const check_s[]) (double*, double*, double, double*, double, double)                = { FSNAV_LINAL_SIZES(BENCH_CHECK_PTR) };
+static double(*const update_s[])(double*, double*, double*, double, double*, double)               = { FSNAV_LINAL_SIZES(BENCH_UPDATE_PTR) };
+static char  (*const gated_s[]) (double*, double*, double*, double*, double, double*, double, double) = { FSNAV_LINAL_SIZES(BENCH_GATED_PTR) };
+
+static double x0[N_MAX], S0[U_MAX], P0[U_MAX], h[N_MAX]; // test data
+static double x[N_MAX], S[U_MAX], K[N_MAX], P[U_MAX];    // working copies
+static volatile double sink;
+
+static double rnd(void) { return rand()/(RAND_MAX + 1.0) - 0.5; }
+
+	// well-conditioned upper-triangular factor with positive diagonal, and its square
+static void data(size_t n)
+{
+	size_t i, j, k;
+
+	for (i = 0, k = 0; i < n; i++)
+		for (j = i; j < n; j++, k++)
+			S0[k] = (i == j) ? 1 + rnd() : 0.3*rnd();
+	for (i = 0; i < n; i++) {
+		x0[i] = rnd();
+		h [i] = rnd();
+	}
+	generic_uuT(P0, S0, n);
+}
+
+	// time per call, nanoseconds, for a kernel, specialized or generic
+static double run(int kernel, int specialized, size_t n)
+{
+	const size_t m = n - FSNAV_LINAL_SIZE_MIN, nu = n*(n+1)/2;
+	double t, acc = 0;
+	int c;
+
+	t = fsnav_test_time();
+	for (c = 0; c < calls; c++) {
+		if (kernel >= 3) { // updates overwrite their state, restored on every call
+			memcpy(S, S0, nu*sizeof(double));
+			memcpy(x, x0, n *sizeof(double));
+		}
+		switch (kernel) {
+		case 0: if (specialized) uuT_s [m](P, S0); else uuT_g (P, S0, n); acc += P[0]; break;
+		case 1: if (specialized) chol_s[m](P, P0); else chol_g(P, P0, n); acc += P[0]; break;
+		case 2: acc += specialized ? check_s [m](x0, S0, 0.1, h, 0.5, 3)        : check_g (x0, S0, 0.1, h, 0.5, 3, n);        break;
+		case 3: acc += specialized ? update_s[m](x, S, K, 0.1, h, 0.5)          : update_g(x, S, K, 0.1, h, 0.5, n);          break;
+		case 4: acc += specialized ? gated_s [m](x, S, K, NULL, 0.1, h, 0.5, 3) : gated_g (x, S, K, NULL, 0.1, h, 0.5, 3, n); break;
+		}
+	}
+	sink = acc;
+	return (fsnav_test_time() - t)/calls*1e9;
+}
+
+	// best times per call of generic and specialized kernels, nanoseconds, measured alternately
+static void bench(int kernel, size_t n, double* tg, double* ts)
+{
+	double t;
+	int r;
+
+	for (r = 0; r < repeat; r++) {
+		t = run(kernel, 0, n);
+		if (r == 0 || t < *tg)
+			*tg = t;
+		t = run(kernel, 1, n);
+		if (r == 0 || t < *ts)
+			*ts = t;
+	}
+}
+
+	// core routines give bitwise equal results to the generic kernels, whether dispatched to specialized instances or not
+static int equal(size_t n)
+{
+	const size_t nu = n*(n+1)/2;
+	double xs[N_MAX], Ss[U_MAX], Ks[N_MAX], Ps[U_MAX], zs, zg, nus, nug;
+	int ok = 1;
+
+	fsnav_linal_uuT(Ps, S0, n);
+	generic_uuT(P, S0, n);
+	ok &= memcmp(Ps, P, nu*sizeof(double)) == 0;
+	fsnav_linal_chol(Ps, P0, n);
+	generic_chol(P, P0, n);
+	ok &= memcmp(Ps, P, nu*sizeof(double)) == 0;
+	ok &= fsnav_linal_check_measurement_residual(x0, S0, 0.1, h, 0.5, 3, n) == generic_check(x0, S0, 0.1, h, 0.5, 3, n);
+	memcpy(Ss, S0, nu*sizeof(double)); memcpy(xs, x0, n*sizeof(double));
+	memcpy(S , S0, nu*sizeof(double)); memcpy(x , x0, n*sizeof(double));
+	zs = fsnav_linal_kalman_update(xs, Ss, Ks, 0.1, h, 0.5, n);
+	zg = generic_update(x, S, K, 0.1, h, 0.5, n);
+	ok &= zs == zg && memcmp(xs, x, n*sizeof(double)) == 0 && memcmp(Ss, S, nu*sizeof(double)) == 0 && memcmp(Ks, K, n*sizeof(double)) == 0;
+	memcpy(Ss, S0, nu*sizeof(double)); memcpy(xs, x0, n*sizeof(double));
+	memcpy(S , S0, nu*sizeof(double)); memcpy(x , x0, n*sizeof(double));
+	ok &= fsnav_linal_kalman_update_gated(xs, Ss, Ks, &nus, 0.1, h, 0.5, 3, n) == generic_gated(x, S, K, &nug, 0.1, h, 0.5, 3, n);
+	ok &= nus == nug && memcmp(xs, x, n*sizeof(double)) == 0 && memcmp(Ss, S, nu*sizeof(double)) == 0 && memcmp(Ks, K, n*sizeof(double)) == 0;
+
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	const char*  names[KERNELS] = {"uuT", "chol", "check", "update", "gated"};
+	const size_t limit[KERNELS] = {FSNAV_LINAL_SIZE_MAX, FSNAV_LINAL_CHOL_SIZE_MAX, FSNAV_LINAL_SIZE_MAX, FSNAV_LINAL_UPDATE_SIZE_MAX, FSNAV_LINAL_SIZE_MAX};
+	double tg = 0, ts = 0;
+	size_t n;
+	int kernel;
+
+	if (argc > 1) { // quick run, to check the results only
+		repeat = 1;
+		calls  = 10;
+	}
+	(void)argv;
+	srand(31);
+	printf("ns per call, generic -> specialized (speedup), * for sizes specialized in the core\n   n");
+	for (kernel = 0; kernel < KERNELS; kernel++)
+		printf(" %26s", names[kernel]);
+	printf("\n");
+	for (n = FSNAV_LINAL_SIZE_MIN; n <= FSNAV_LINAL_SIZE_MAX; n++) {
+		data(n);
+		fsnav_test_check(equal(n), "core routines match generic kernels bitwise");
+		printf("%4u", (unsigned)n);
+		for (kernel = 0; kernel < KERNELS; kernel++) {
+			bench(kernel, n, &tg, &ts);
+			printf("   %7.1f -> %7.1f (%4.2f)%c", tg, ts, tg/ts, (n <= limit[kernel]) ? '*' : ' ');
+		}
+		printf("\n");
+	}
+
+	return fsnav_test_result();
+}
@@ -0,0 +1,176 @@
+// U-D factor Kalman filter (Bierman update, Thornton prediction) against the square root forms
+// (Carlson update, Householder triangularization prediction) on the same data, covariances checked to agree
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fsnav.h"
+#include "fsnav_test.h"
+
+#define N_MAX 21
+#define M_MAX 11
+#define U_MAX (N_MAX*(N_MAX+1)/2)
+#define SIZES 4
+#define TOL   1e-12 // relative difference of covariances, to the largest diagonal element
+
+static int repeat = 21;    // timing repetitions, alternating the forms, the best one is taken
+static int calls  = 20000; // calls per repetition
+
+static double x0[N_MAX], S0[U_MAX], P0[U_MAX], U0[U_MAX], D0[N_MAX]; // test data: state, factors, covariance
+static double h[N_MAX], F[N_MAX*N_MAX], q2[M_MAX], Qh[M_MAX*(M_MAX+1)/2];
+static double x[N_MAX], S[U_MAX], U[U_MAX], D[N_MAX], K[N_MAX];       // working copies
+static double W[N_MAX*(N_MAX+M_MAX)];                                // workspace for both predictions
+static volatile double sink;
+
+static double rnd(void) { return rand()/(RAND_MAX + 1.0) - 0.5; }
+
+	// P = U*diag(D)*U^T, upper-triangular parts lined in one-dimensional arrays
+static void udT(double* P, double* Uf, double* Df, size_t n)
+{
+	size_t i, j, k, p;
+
+	for (i = 0, p = 0; i < n; i++)
+		for (j = i; j < n; j++, p++)
+			for (k = j, P[p] = 0; k < n; k++)
+				P[p] += Uf[i*(2*n-i+1)/2 + k-i]*Df[k]*Uf[j*(2*n-j+1)/2 + k-j];
+}
+
+	// maximum difference of the covariances from the Cholesky and U-D factors, relative to the largest diagonal element
+static double mismatch(double* Sf, double* Uf, double* Df, size_t n)
+{
+	double Ps[U_MAX], Pu[U_MAX], d = 0, a = 0;
+	size_t i, p;
+
+	fsnav_linal_uuT(Ps, Sf, n);
+	udT(Pu, Uf, Df, n);
+	for (p = 0; p < n*(n+1)/2; p++)
+		if (fabs(Ps[p] - Pu[p]) > d)
+			d = fabs(Ps[p] - Pu[p]);
+	for (i = 0; i < n; i++)
+		if (Ps[i*(2*n-i+1)/2] > a)
+			a = Ps[i*(2*n-i+1)/2];
+	return d/a;
+}
+
+	// random covariance, sparse measurement (three nonzeros), dense transition near identity, noise in the first m states
+static void data(size_t n, size_t m)
+{
+	size_t i, j, k;
+
+	for (i = 0, k = 0; i < n; i++)
+		for (j = i; j < n; j++, k++)
+			S0[k] = (i == j) ? 1 + rnd() : 0.3*rnd();
+	fsnav_linal_uuT(P0, S0, n);
+	fsnav_linal_ud(U0, D0, P0, n);
+	for (i = 0; i < n; i++) {
+		x0[i] = rnd();
+		h [i] = 0;
+		for (j = 0; j < n; j++)
+			F[i*n+j] = (i == j) + 0.1*rnd();
+	}
+	h[0] = 1; h[n/2] = rnd(); h[n-1] = rnd();
+	for (i = 0, k = 0; i < m; i++) {
+		q2[i] = 0.01*(1 + rnd());
+		for (j = i; j < m; j++, k++)
+			Qh[k] = (i == j) ? sqrt(q2[i]) : 0;
+	}
+}
+
+	// time per call, nanoseconds: update or prediction, square root (Carlson, Householder) or U-D form
+static double run(int predict, int ud, size_t n, size_t m)
+{
+	const size_t nu = n*(n+1)/2;
+	double t, acc = 0;
+	int c;
+
+	t = fsnav_test_time();
+	for (c = 0; c < calls; c++) {
+		memcpy(x, x0, n*sizeof(double));
+		if (ud) {
+			memcpy(U, U0, nu*sizeof(double));
+			memcpy(D, D0, n *sizeof(double));
+			if (predict)
+				fsnav_linal_ud_predict(x, U, D, F, NULL, q2, W, n, m);
+			else
+				acc += fsnav_linal_ud_update(x, U, D, K, 0.1, h, 0.5, n);
+			acc += D[0];
+		}
+		else {
+			memcpy(S, S0, nu*sizeof(double));
+			if (predict)
+				fsnav_linal_kalman_predict_F(x, S, F, NULL, Qh, W, n, m);
+			else
+				acc += fsnav_linal_kalman_update(x, S, K, 0.1, h, 0.5, n);
+			acc += S[0];
+		}
+	}
+	sink = acc;
+	return (fsnav_test_time() - t)/calls*1e9;
+}
+
+	// best times per call of the square root and U-D forms, nanoseconds, measured alternately
+static void bench(int predict, size_t n, size_t m, double* ts, double* tu)
+{
+	double t;
+	int r;
+
+	for (r = 0; r < repeat; r++) {
+		t = run(predict, 0, n, m);
+		if (r == 0 || t < *ts)
+			*ts = t;
+		t = run(predict, 1, n, m);
+		if (r == 0 || t < *tu)
+			*tu = t;
+	}
+}
+
+	// both forms give the same state and covariance after a prediction followed by an update
+static int agree(size_t n, size_t m)
+{
+	double xs[N_MAX], dz_s, dz_u, d = 0;
+	size_t i;
+	int ok;
+
+	memcpy(x , x0, n*sizeof(double));
+	memcpy(xs, x0, n*sizeof(double));
+	memcpy(S , S0, n*(n+1)/2*sizeof(double));
+	memcpy(U , U0, n*(n+1)/2*sizeof(double));
+	memcpy(D , D0, n*sizeof(double));
+	ok = mismatch(S, U, D, n) < TOL;
+	fsnav_linal_kalman_predict_F(xs, S, F, NULL, Qh, W, n, m);
+	fsnav_linal_ud_predict      (x , U, D, F, NULL, q2, W, n, m);
+	ok &= mismatch(S, U, D, n) < TOL;
+	dz_s = fsnav_linal_kalman_update(xs, S, K, 0.1, h, 0.5, n);
+	dz_u = fsnav_linal_ud_update    (x , U, D, K, 0.1, h, 0.5, n);
+	ok &= mismatch(S, U, D, n) < TOL && fabs(dz_s - dz_u) < TOL;
+	for (i = 0; i < n; i++)
+		if (fabs(xs[i] - x[i]) > d)
+			d = fabs(xs[i] - x[i]);
+	return ok && d < TOL;
+}
+
+int main(int argc, char** argv)
+{
+	const size_t n[SIZES] = {3, 9, 15, 21}, m[SIZES] = {2, 5, 8, 11};
+	double ts = 0, tu = 0, ps = 0, pu = 0;
+	size_t k;
+
+	if (argc > 1) { // quick run, to check the results only
+		repeat = 1;
+		calls  = 10;
+	}
+	(void)argv;
+	srand(34);
+	printf("ns per call, square root -> U-D (speedup)\n   n   m               update (Carlson -> Bierman)   predict (Householder -> Thornton)\n");
+	for (k = 0; k < SIZES; k++) {
+		data(n[k], m[k]);
+		fsnav_test_check(agree(n[k], m[k]), "U-D and square root forms give the same state and covariance");
+		bench(0, n[k], m[k], &ts, &tu);
+		bench(1, n[k], m[k], &ps, &pu);
+		printf("%4u%4u   %9.1f -> %9.1f (%4.2f)      %9.1f -> %9.1f (%4.2f)\n", (unsigned)n[k], (unsigned)m[k], ts, tu, ts/tu, ps, pu, ps/pu);
+	}
+
+	return fsnav_test_result();
+}
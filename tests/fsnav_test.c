@@ -0,0 +1,53 @@
+// FSNAV checks and benchmarks, common functions
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "fsnav_test.h"
+
+int fsnav_test_failures = 0;
+
+	/*
+		check a condition, report if it fails
+		input:
+			int         cond --- condition to check
+			const char* what --- description of the check
+		return value:
+			the condition
+	*/
+int fsnav_test_check(int cond, const char* what)
+{
+	if (!cond) {
+		fprintf(stderr, "FAILED: %s\n", what);
+		fsnav_test_failures++;
+	}
+	return cond;
+}
+
+	/*
+		read monotonic clock for benchmarks
+		return value:
+			time in seconds from an arbitrary origin
+	*/
+double fsnav_test_time(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + 1e-9*(double)t.tv_nsec;
+}
+
+	/*
+		report the result of a check program
+		return value:
+			exit code: 0 if all checks passed, 1 otherwise
+	*/
+int fsnav_test_result(void)
+{
+	if (fsnav_test_failures > 0)
+		fprintf(stderr, "%d check(s) failed\n", fsnav_test_failures);
+	else
+		printf("all checks passed\n");
+	return fsnav_test_failures > 0;
+}
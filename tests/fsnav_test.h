@@ -0,0 +1,12 @@
+// FSNAV checks and benchmarks, common declarations
+
+#ifndef FSNAV_TEST_H_
+#define FSNAV_TEST_H_
+
+extern int fsnav_test_failures; // number of failed checks
+
+int    fsnav_test_check (int cond, const char* what); // check a condition and report if it fails, input: condition, description, output: the condition
+double fsnav_test_time  (void                     ); // read monotonic clock for benchmarks,                                     output: time in seconds from an arbitrary origin
+int    fsnav_test_result(void                     ); // report the result of a check program,                                  output: exit code, 0 if all checks passed
+
+#endif
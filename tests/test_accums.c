@@ -0,0 +1,85 @@
+// increment accumulators: those of consumers retired or removed from the execution list are dropped,
+// at the end of the step for retired ones and at once for removed ones, the remaining consumer keeps integrating
+
+#include <stdio.h>
+
+#include "fsnav.h"
+#include "fsnav_test.h"
+
+static size_t step_no;                // number of regular steps taken
+static fsnav_accum *acc_a, *acc_b, *acc_c; // accumulators of the consumers
+
+static void imu_source(void)
+{
+	if (fsnav->mode <= 0 || fsnav->imu == NULL)
+		return;
+	step_no++;
+	fsnav->imu->t += 0.01;
+	fsnav->imu->w[0] = 0; fsnav->imu->w[1] = 0; fsnav->imu->w[2] = 0.1;
+	fsnav->imu->f[0] = 0; fsnav->imu->f[1] = 0; fsnav->imu->f[2] = 9.8;
+	fsnav->imu->w_valid = 1;
+	fsnav->imu->f_valid = 1;
+}
+
+	// consumers only attach their accumulators, never reset them
+static void consumer_a(void)
+{
+	if (fsnav->mode == 0)
+		acc_a = fsnav->attach_accum(consumer_a, 0);
+}
+
+static void consumer_b(void)
+{
+	if (fsnav->mode == 0)
+		acc_b = fsnav->attach_accum(consumer_b, 2);
+}
+
+static void consumer_c(void* context)
+{
+	(void)context;
+	if (fsnav->mode == 0)
+		acc_c = fsnav->attach_accum((void(*)(void))consumer_c, 0);
+}
+
+int main(void)
+{
+	char cfg[] = "{imu: }";
+	size_t count_init, count_retired, count_retired_after, count_removed, n_before;
+
+	fsnav->add_plugin(imu_source);
+	fsnav->add_plugin(fsnav_accumulate_imu);
+	fsnav->add_plugin(consumer_a);
+	fsnav->add_plugin(consumer_b);
+	fsnav->add_plugin_ext(consumer_c, consumer_c, NULL, NULL);
+	fsnav->init(cfg);
+	fsnav->step(); // init cycle
+	count_init = fsnav->core.accum_count;
+	fsnav->step();
+	fsnav->step();
+
+	// retired consumer with separate callbacks: its accumulator is kept until the end of the step
+	fsnav->retire_plugin((void(*)(void))consumer_c);
+	count_retired = fsnav->core.accum_count;
+	fsnav->step();
+	count_retired_after = fsnav->core.accum_count;
+
+	// removed consumer: its accumulator is dropped at once
+	fsnav->remove_plugin(consumer_b);
+	count_removed = fsnav->core.accum_count;
+	n_before = acc_a->n;
+	fsnav->step();
+	fsnav->step();
+
+	printf("accumulators: %u after init, %u with a consumer retired, %u after the step, %u with a consumer removed\n",
+		(unsigned)count_init, (unsigned)count_retired, (unsigned)count_retired_after, (unsigned)count_removed);
+	fsnav_test_check(count_init == 3 && acc_a != NULL && acc_b != NULL && acc_c != NULL, "each consumer gets an accumulator");
+	fsnav_test_check(count_retired == 3, "accumulator of a retired consumer is kept until the end of the step");
+	fsnav_test_check(count_retired_after == 2, "accumulator of a retired consumer is dropped at the end of the step");
+	fsnav_test_check(count_removed == 1 && fsnav->core.accums[0] == acc_a, "accumulator of a removed consumer is dropped at once");
+	fsnav_test_check(acc_a->n == n_before + 2, "remaining consumer keeps integrating");
+
+	fsnav->terminate();
+	while (fsnav->step()); // termination cycle, the execution list is freed
+	fsnav_test_check(fsnav->core.accum_count == 0, "accumulators are freed at termination");
+	return fsnav_test_result();
+}
@@ -0,0 +1,120 @@
+// load balancing of scheduled plugins: shift assignment from measured and preset costs
+
+#include <stdio.h>
+
+#include "fsnav.h"
+#include "fsnav_test.h"
+
+static volatile double sink; // keeps busy loops from being optimized out
+
+static void spin(int n) { int k; double s = 0; for (k = 0; k < n; k++) s += k*1e-9; sink = s; }
+static void p0(void) { if (fsnav->mode > 0) spin(2000); }
+static void p1(void) { if (fsnav->mode > 0) spin(2000); }
+static void p2(void) { if (fsnav->mode > 0) spin(2000); }
+static void p3(void) { if (fsnav->mode > 0) spin(2000); }
+
+	/*
+		set preset costs and shifts of the scheduled plugins and rebalance
+		input:
+			const double* cost  --- costs, seconds, negative to leave the plugin unmeasured
+			const int*    shift --- shifts given by the user
+	*/
+static void rebalance(const double* cost, const int* shift)
+{
+	size_t i;
+
+	for (i = 0; i < fsnav->core.plugin_count; i++) {
+		fsnav->core.plugins[i].shift      = shift[i];
+		fsnav->core.plugins[i].cost       = cost[i] > 0 ? cost[i] : 0;
+		fsnav->core.plugins[i].cost_count = cost[i] > 0 ? FSNAV_BALANCE_SAMPLES : 0;
+		fsnav->core.plugins[i].cost_runs  = cost[i] < 0 ? 0 : FSNAV_BALANCE_RUNS;
+	}
+	fsnav->core.balance = 1;
+	fsnav->core.balance_pending = 1;
+	fsnav_balance_step();
+}
+
+static int shifts_equal(const int* shift)
+{
+	size_t i;
+
+	for (i = 0; i < fsnav->core.plugin_count; i++)
+		if (fsnav->core.plugins[i].shift != shift[i])
+			return 0;
+	return 1;
+}
+
+static int shifts_distinct(void)
+{
+	size_t i, j;
+
+	for (i = 0; i < fsnav->core.plugin_count; i++)
+		for (j = 0; j < i; j++)
+			if (fsnav->core.plugins[i].shift == fsnav->core.plugins[j].shift)
+				return 0;
+	return 1;
+}
+
+int main(void)
+{
+	const int user[4] = {1, 3, 2, 0}, zero[4] = {0, 0, 0, 0};
+	const double none[4] = {0, 0, 0, 0}, equal[4] = {1e-7, 1e-7, 1e-7, 1e-7}, heavy[4] = {3e-7, 1e-7, 1e-7, 1e-7};
+	const double close_[4] = {1.00e-7, 1.01e-7, 0.99e-7, 1.02e-7}, unmeasured[4] = {-1, -1, -1, -1};
+	size_t i, k;
+
+	fsnav->schedule_plugin(p0, 4, 0);
+	fsnav->schedule_plugin(p1, 4, 0);
+	fsnav->schedule_plugin(p2, 4, 0);
+	fsnav->schedule_plugin(p3, 4, 0);
+	fsnav->init("");
+
+	// no measurable cost: the given shifts are kept
+	rebalance(none, user);
+	fsnav_test_check(shifts_equal(user), "zero costs keep the given shifts");
+	rebalance(none, zero);
+	fsnav_test_check(shifts_equal(zero), "zero costs keep the given shifts, even if shared");
+
+	// equal costs: one plugin per tick, the given shifts kept when they are already balanced
+	rebalance(equal, zero);
+	fsnav_test_check(shifts_distinct(), "equal costs are spread over ticks");
+	rebalance(equal, user);
+	fsnav_test_check(shifts_equal(user), "balanced given shifts are kept for equal costs");
+	rebalance(close_, user);
+	fsnav_test_check(shifts_equal(user), "balanced given shifts are kept for costs within the margin");
+
+	// unmeasured plugins are placed as if of equal cost
+	rebalance(unmeasured, zero);
+	fsnav_test_check(shifts_distinct(), "unmeasured plugins are spread over ticks");
+
+	// cycle 2: the heavy plugin alone on one tick, the rest on the other
+	for (i = 0; i < 4; i++)
+		fsnav->core.plugins[i].cycle = 2;
+	rebalance(heavy, zero);
+	for (i = 1, k = 0; i < 4; i++)
+		k += fsnav->core.plugins[i].shift != fsnav->core.plugins[0].shift;
+	fsnav_test_check(k == 3, "a heavy plugin is left alone on its tick");
+	for (i = 0; i < 4; i++)
+		fsnav->core.plugins[i].cycle = 4;
+
+	// measured with the core clock: nonzero costs, one plugin per tick
+	for (i = 0; i < 4; i++) {
+		fsnav->core.plugins[i].shift      = 0;
+		fsnav->core.plugins[i].tick       = 0;
+		fsnav->core.plugins[i].cost       = 0;
+		fsnav->core.plugins[i].cost_count = 0;
+		fsnav->core.plugins[i].cost_runs  = 0;
+	}
+	fsnav->balance_plugins(1);
+	for (k = 0; k < 4*FSNAV_BALANCE_RUNS; k++)
+		fsnav->step();
+	for (i = 0; i < 4; i++)
+		fsnav_test_check(FSNAV_BALANCE_MEASURED(fsnav->core.plugins + i) && fsnav->core.plugins[i].cost > 0, "plugin cost is measured");
+	fsnav_test_check(fsnav->core.balance_pending == 0, "rebalancing is done once all plugins are measured");
+	fsnav_test_check(shifts_distinct(), "measured equal plugins are spread over ticks");
+	printf("measured costs: %.0f %.0f %.0f %.0f ns, shifts %d %d %d %d\n",
+		fsnav->core.plugins[0].cost*1e9, fsnav->core.plugins[1].cost*1e9, fsnav->core.plugins[2].cost*1e9, fsnav->core.plugins[3].cost*1e9,
+		fsnav->core.plugins[0].shift, fsnav->core.plugins[1].shift, fsnav->core.plugins[2].shift, fsnav->core.plugins[3].shift);
+
+	fsnav->terminate();
+	return fsnav_test_result();
+}
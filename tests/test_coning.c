@@ -0,0 +1,131 @@
+// coning compensated attitude at a reduced rate: under classical coning motion every update of
+// fsnav_ins_attitude_coning, N = 1..4 and 6 samples per update, follows a fine-step Rodrigues' reference
+// far closer than Rodrigues' formula at every sample, and is signalled with FSNAV_TOPIC_ATTITUDE once per N samples
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fsnav.h"
+#include "ins/fsnav_ins_attitude.h"
+#include "fsnav_test.h"
+
+#define SAMPLES 1200   // sensor samples, divisible by every N checked
+#define DT      0.0005 // sample interval, s
+#define FINE    1024   // reference steps per sample
+#define OMEGA   (2*3.14159265358979323846*20) // coning frequency, rad/s
+#define HALF    0.01   // coning half-angle, rad
+#define TOL     1e-8   // attitude matrix elements to the reference, coning compensated
+
+static size_t step_no;                 // number of regular steps taken
+static size_t substeps;                // bus steps per sample
+static size_t updates;                 // FSNAV_TOPIC_ATTITUDE signals
+static size_t updated[SAMPLES + 2];    // sample steps the attitude is updated on, in order
+static double L[SAMPLES + 2][9];       // attitude matrix by sample step
+
+	// classical coning, angular rate averaged over each step: integrated exactly over [(step-2)*h, (step-1)*h],
+	// so that the first step, taken by the plugins to start, carries no rotation
+static void imu_source(void)
+{
+	const double h = DT/substeps, s = sin(HALF), c = 2*sin(HALF/2)*sin(HALF/2);
+	double t0, t1;
+
+	if (fsnav->mode <= 0 || fsnav->imu == NULL)
+		return;
+	step_no++;
+	t0 = (step_no > 1) ? (step_no - 2)*h : 0;
+	t1 = (step_no > 1) ? (step_no - 1)*h : 0;
+	fsnav->imu->t = t1;
+	fsnav->imu->w[0] = -c*OMEGA;
+	fsnav->imu->w[1] =  s*(cos(OMEGA*t1) - cos(OMEGA*t0))/h;
+	fsnav->imu->w[2] =  s*(sin(OMEGA*t1) - sin(OMEGA*t0))/h;
+	fsnav->imu->w_valid = 1;
+}
+
+	// attitude at every sample step
+static void observer(void)
+{
+	double *Ls;
+
+	if (fsnav->mode <= 0 || (step_no - 1)%substeps != 0 || (step_no - 1)/substeps > SAMPLES)
+		return;
+	Ls = fsnav_sol_get_L(&(fsnav->imu->sol));
+	if (Ls != NULL)
+		memcpy(L[(step_no - 1)/substeps + 1], Ls, sizeof(L[0]));
+}
+
+	// attitude update notifications
+static void on_attitude(void)
+{
+	if (fsnav->mode <= 0)
+		return;
+	if (updates < SAMPLES + 2)
+		updated[updates] = step_no;
+	updates++;
+}
+
+	// run an attitude plugin over the samples, taken in a given number of steps each
+static void run(char* cfg, void(*attitude)(void), size_t steps_per_sample)
+{
+	step_no  = 0;
+	substeps = steps_per_sample;
+	updates  = 0;
+	fsnav->add_plugin(imu_source);
+	fsnav->add_plugin(attitude);
+	fsnav->add_plugin(observer);
+	fsnav->add_plugin(on_attitude);
+	fsnav->subscribe_plugin(on_attitude, FSNAV_TOPIC_ATTITUDE);
+	fsnav->init(cfg);
+	fsnav->step(); // init cycle
+	while (step_no < SAMPLES*substeps + 1)
+		fsnav->step();
+	fsnav->terminate();
+	while (fsnav->step()); // termination cycle, the execution list is freed
+}
+
+	// maximum difference of attitude matrix elements to the reference, at the given sample steps, or at every one
+static double mismatch(double (*L_ref)[9], size_t* steps, size_t n)
+{
+	double d = 0;
+	size_t k, s, i;
+
+	for (k = 0; k < n; k++) {
+		s = (steps != NULL) ? steps[k] : k + 2;
+		for (i = 0; s <= SAMPLES + 1 && i < 9; i++)
+			if (!(fabs(L[s][i] - L_ref[s][i]) <= d))
+				d = fabs(L[s][i] - L_ref[s][i]);
+	}
+	return d;
+}
+
+int main(void)
+{
+	static double L_ref[SAMPLES + 2][9];
+	const int N[] = {1, 2, 3, 4, 6};
+	char cfg[64], cfg_rodrigues[] = "{imu: }";
+	double d, d_rodrigues;
+	size_t j, k;
+	char what[96];
+
+	// reference: Rodrigues' formula at FINE steps per sample, then at every sample
+	run(cfg_rodrigues, fsnav_ins_attitude_rodrigues, FINE);
+	memcpy(L_ref, L, sizeof(L));
+	run(cfg_rodrigues, fsnav_ins_attitude_rodrigues, 1);
+	d_rodrigues = mismatch(L_ref, NULL, SAMPLES);
+	printf("attitude to the fine-step reference, %d Hz coning at %g rad, %g Hz samples: Rodrigues at every sample %.2e\n",
+		(int)(OMEGA/2/3.14159265358979323846 + 0.5), HALF, 1/DT, d_rodrigues);
+
+	for (j = 0; j < sizeof(N)/sizeof(N[0]); j++) {
+		sprintf(cfg, "{imu: coning_samples = %d}", N[j]);
+		run(cfg, fsnav_ins_attitude_coning, 1);
+		d = mismatch(L_ref, updated, (updates < SAMPLES + 2) ? updates : SAMPLES + 2);
+		printf("coning, N = %d: %.2e over %u updates\n", N[j], d, (unsigned)updates);
+		sprintf(what, "coning compensated attitude follows the reference, N = %d", N[j]);
+		fsnav_test_check(d < TOL && d < d_rodrigues/100, what);
+		sprintf(what, "attitude update is signalled once per N samples, N = %d", N[j]);
+		for (k = 0; k < updates && k < SAMPLES + 2 && updated[k] == (k + 1)*N[j] + 1; k++);
+		fsnav_test_check(updates == SAMPLES/N[j] && k == updates, what);
+	}
+
+	return fsnav_test_result();
+}
@@ -0,0 +1,102 @@
+// normal gravity: incremental updates against exact evaluation at every sample over the same trajectory,
+// within the documented bound 0.5*(tol/a)^2, with latitude and altitude jumps forcing exact re-evaluation
+
+#include <math.h>
+#include <stdio.h>
+
+#include "fsnav.h"
+#include "ins/fsnav_ins_gravity.h"
+#include "fsnav_test.h"
+
+#define STEPS 40000
+#define DT    0.01 // sample interval, s
+
+static const size_t jumps[] = {10000, 20000, 25000, 30000}; // steps with a jump of coordinates
+
+static size_t step_no;            // number of regular steps taken
+static double g[STEPS][2];        // northern and vertical gravity components by step
+
+	// climbing and descending flight northwards at 250 m/s from 5 deg, then at about 45 deg after a latitude jump, with altitude jumps
+static void imu_source(void)
+{
+	double t, lat, h;
+
+	if (fsnav->mode <= 0 || fsnav->imu == NULL || step_no >= STEPS)
+		return;
+	t   = step_no*DT;
+	lat = 5/fsnav->imu_const.rad2deg + 250*t/fsnav->imu_const.a;  // along the meridian
+	h   = 5000 - 4500*cos(0.05*t);                                 // 0.5..9.5 km, up to 225 m/s
+	if (step_no >= jumps[0]) lat += 40/fsnav->imu_const.rad2deg;   // 40 deg north
+	if (step_no >= jumps[1]) h   += 3000;                          // 3 km up
+	if (step_no >= jumps[2]) lat -= 1500/fsnav->imu_const.a;       // 1.5 km south, just past the largest tolerance
+	if (step_no >= jumps[3]) h   -= 1500;                          // 1.5 km down, just past the largest tolerance
+	fsnav->imu->sol.llh[0] = 0.65;
+	fsnav->imu->sol.llh[1] = lat;
+	fsnav->imu->sol.llh[2] = h;
+	fsnav->imu->sol.llh_valid = 1;
+}
+
+static void observer(void)
+{
+	if (fsnav->mode <= 0 || step_no >= STEPS)
+		return;
+	g[step_no][0] = fsnav->imu->g_valid ? fsnav->imu->g[1] : NAN;
+	g[step_no][1] = fsnav->imu->g_valid ? fsnav->imu->g[2] : NAN;
+	step_no++;
+}
+
+	// gravity over the trajectory with a given tolerance of incremental updates, meters
+static void run(double tol)
+{
+	char cfg[64];
+
+	sprintf(cfg, "{imu: gravity_tolerance = %.0f}", tol);
+	step_no = 0;
+	fsnav->add_plugin(imu_source);
+	fsnav->add_plugin(fsnav_ins_gravity_normal);
+	fsnav->add_plugin(observer);
+	fsnav->init(cfg);
+	fsnav->step(); // init cycle
+	while (step_no < STEPS)
+		fsnav->step();
+	fsnav->terminate();
+	while (fsnav->step()); // termination cycle, the execution list is freed
+}
+
+int main(void)
+{
+	static double g_exact[STEPS][2];
+	const double tol[] = {100, 1000};
+	double bound, err, a;
+	size_t i, j, k, incremental;
+	char what[96];
+
+	run(0);
+	for (k = 0; k < STEPS; k++)
+		g_exact[k][0] = g[k][0], g_exact[k][1] = g[k][1];
+	a = fsnav->imu_const.a;
+
+	for (i = 0; i < sizeof(tol)/sizeof(tol[0]); i++) {
+		run(tol[i]);
+		bound = 0.5*(tol[i]/a)*(tol[i]/a);
+		err = 0;
+		incremental = 0;
+		for (k = 0; k < STEPS; k++)
+			for (j = 0; j < 2; j++) {
+				if (!(fabs(g[k][j] - g_exact[k][j]) <= err))
+					err = fabs(g[k][j] - g_exact[k][j]);
+				incremental += g[k][j] != g_exact[k][j];
+			}
+		printf("tolerance %5.0f m: maximum error %.2e m/s^2, bound %.2e m/s^2, %u incremental components\n", tol[i], err, bound, (unsigned)incremental);
+		sprintf(what, "incremental gravity is within 0.5*(tol/a)^2 of the exact one, tol %.0f m", tol[i]);
+		fsnav_test_check(err <= bound, what);
+		sprintf(what, "gravity is updated incrementally, tol %.0f m", tol[i]);
+		fsnav_test_check(incremental > STEPS/2, what);
+		for (j = 0; j < sizeof(jumps)/sizeof(jumps[0]); j++) {
+			sprintf(what, "coordinate jump at step %u forces exact evaluation, tol %.0f m", (unsigned)jumps[j], tol[i]);
+			fsnav_test_check(g[jumps[j]][0] == g_exact[jumps[j]][0] && g[jumps[j]][1] == g_exact[jumps[j]][1], what);
+		}
+	}
+
+	return fsnav_test_result();
+}
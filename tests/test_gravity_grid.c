@@ -0,0 +1,104 @@
+// EGM2008 grid: a valid grid is applied, grids that can't be opened or mismatch the format
+// (signature, version, byte order, header, size) request termination
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fsnav.h"
+#include "ins/fsnav_ins_gravity.h"
+#include "fsnav_test.h"
+
+#define GRID "test_gravity_grid.grd"
+
+static double g_up; // vertical gravity after the first regular step
+
+	// level sensor at 55.5 deg north, 37.5 deg east, within the grid
+static void imu_source(void)
+{
+	if (fsnav->mode <= 0 || fsnav->imu == NULL)
+		return;
+	fsnav->imu->sol.llh[0] = 37.5/fsnav->imu_const.rad2deg;
+	fsnav->imu->sol.llh[1] = 55.5/fsnav->imu_const.rad2deg;
+	fsnav->imu->sol.llh[2] = 0;
+	fsnav->imu->sol.llh_valid = 1;
+}
+
+static void observer(void)
+{
+	if (fsnav->mode > 0)
+		g_up = fsnav->imu->g[2];
+}
+
+	// 3 x 3 nodes from 55 deg north, 37 deg east, 0.5 deg steps, in 2 x 2 tiles of 2 x 2 nodes, all nodes 10 mGal, no deflections;
+	// fields to spoil: signature, version bytes in the file order, tile size, number of float values dropped from the end
+static void write_grid(const char* signature, const unsigned char* version, int T, size_t drop)
+{
+	const int    n[3] = {0, 3, 3};
+	const double v[5] = {55, 37, 0.5, 0.5, 0};
+	float  node[3] = {10, 0, 0};
+	size_t k;
+	FILE  *fp = fopen(GRID, "wb");
+
+	fwrite(signature, 1, 8, fp);
+	fwrite(version, 1, 4, fp);
+	fwrite(&T, 4, 1, fp);
+	fwrite(n + 1, 4, 2, fp);
+	fwrite(v, 8, 5, fp);
+	for (k = 0; k < 16 - drop; k++)
+		fwrite(node, sizeof(float), 3, fp);
+	fclose(fp);
+}
+
+	// run a few steps with the grid (NULL for none), 1 if the bus keeps running
+static int run(const char* grid)
+{
+	char cfg[128];
+	int  k, ok;
+
+	if (grid == NULL)
+		sprintf(cfg, "{imu: lat = 55.5}");
+	else
+		sprintf(cfg, "{imu: lat = 55.5, egm08_grid = %s}", grid);
+	fsnav->add_plugin(imu_source);
+	fsnav->add_plugin(fsnav_ins_gravity_normal);
+	fsnav->add_plugin(fsnav_ins_gravity_egm08);
+	fsnav->add_plugin(observer);
+	fsnav->init(cfg);
+	fsnav->step(); // init cycle
+	ok = fsnav->mode >= 0;
+	for (k = 0; k < 3 && fsnav->mode >= 0; k++)
+		fsnav->step();
+	fsnav->terminate();
+	while (fsnav->step()); // termination cycle, the execution list is freed
+	return ok;
+}
+
+int main(void)
+{
+	const unsigned char le[4] = {1, 0, 0, 0}, be[4] = {0, 0, 0, 1}, v2[4] = {2, 0, 0, 0};
+	double g_normal;
+
+	fsnav_test_check(run(NULL), "no grid, normal gravity only");
+	g_normal = g_up;
+	fsnav_test_check(!run("none.grd"), "missing grid requests termination");
+
+	write_grid("FSNAVEGM", le, 2, 0);
+	fsnav_test_check(run(GRID), "valid grid is accepted");
+	printf("vertical gravity: normal %.7f, with the grid %.7f m/s^2\n", g_normal, g_up);
+	fsnav_test_check(fabs(g_up - (g_normal - 10e-5)) < 1e-12, "grid disturbance is applied");
+
+	write_grid("FSNAVEGX", le, 2, 0);
+	fsnav_test_check(!run(GRID), "signature mismatch requests termination");
+	write_grid("FSNAVEGM", be, 2, 0);
+	fsnav_test_check(!run(GRID), "grid of other byte order requests termination");
+	write_grid("FSNAVEGM", v2, 2, 0);
+	fsnav_test_check(!run(GRID), "version mismatch requests termination");
+	write_grid("FSNAVEGM", le, 0, 0);
+	fsnav_test_check(!run(GRID), "header mismatch requests termination");
+	write_grid("FSNAVEGM", le, 2, 1);
+	fsnav_test_check(!run(GRID), "truncated grid requests termination");
+
+	remove(GRID);
+	return fsnav_test_result();
+}
@@ -0,0 +1,96 @@
+// Kalman filter bank: each filter of a bank gives bitwise the same result as the single filter routines,
+// for full chunks of filters, a tail only (nf below the chunk), both together, zero measurement noise and zero pivots
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fsnav.h"
+#include "fsnav_test.h"
+
+#define N_MAX  17
+#define U_MAX  (N_MAX*(N_MAX+1)/2)
+#define NF_MAX 24
+
+static double xb[N_MAX*NF_MAX], Sb[U_MAX*NF_MAX], Kb[N_MAX*NF_MAX], hb[N_MAX*NF_MAX], q2b[N_MAX*NF_MAX]; // bank
+static double zb[NF_MAX], sigma[NF_MAX], L[NF_MAX];
+static double x[NF_MAX][N_MAX], S[NF_MAX][U_MAX], K[NF_MAX][N_MAX], h[NF_MAX][N_MAX], q2[NF_MAX][N_MAX]; // single filters
+static double z[NF_MAX];
+
+static double rnd(void) { return rand()/(RAND_MAX + 1.0) - 0.5; }
+
+	// random filters, every third one with zero measurement noise, every fifth one with a zero pivot in the last state
+static void data(size_t n, size_t m, size_t nf)
+{
+	size_t i, j, k, p;
+
+	for (k = 0; k < nf; k++) {
+		for (i = 0, p = 0; i < n; i++)
+			for (j = i; j < n; j++, p++)
+				S[k][p] = (i == j) ? 1 + rnd() : 0.3*rnd();
+		if (k%5 == 4 && m < n)
+			S[k][p-1] = 0;
+		for (i = 0; i < n; i++) {
+			x [k][i] = rnd();
+			h [k][i] = (i%3 == 1) ? 0 : rnd();
+			q2[k][i] = (i < m) ? 0.01*(1 + rnd()) : 0;
+		}
+		z    [k] = rnd();
+		sigma[k] = (k%3 == 2) ? 0 : 0.5 + rnd();
+		fsnav_linal_bank_set(xb, Sb, x[k], S[k], n, nf, k);
+		for (i = 0; i < n; i++) {
+			hb [i*nf + k] = h [k][i];
+			q2b[i*nf + k] = q2[k][i];
+		}
+		zb[k] = z[k];
+	}
+}
+
+	// bank update and prediction against fsnav_linal_kalman_update_gated (gate wide open) and fsnav_linal_kalman_predict_I_diag
+static int equal(size_t n, size_t m, size_t nf)
+{
+	double xk[N_MAX], Sk[U_MAX], Kk[N_MAX], xu[N_MAX], Su[U_MAX], Ku[N_MAX], dz;
+	const size_t nu = n*(n+1)/2;
+	size_t k, i;
+	int ok = 1;
+
+	data(n, m, nf);
+	fsnav_linal_bank_update(xb, Sb, Kb, L, zb, hb, sigma, n, nf);
+	for (k = 0; k < nf; k++) {
+		memcpy(xu, x[k], n *sizeof(double));
+		memcpy(Su, S[k], nu*sizeof(double));
+		dz = fsnav_linal_kalman_update(xu, Su, Ku, z[k], h[k], sigma[k], n);
+		ok &= fsnav_linal_kalman_update_gated(x[k], S[k], K[k], NULL, z[k], h[k], sigma[k], HUGE_VAL, n);
+		fsnav_linal_bank_get(xk, Sk, xb, Sb, n, nf, k);
+		for (i = 0; i < n; i++)
+			Kk[i] = Kb[i*nf + k];
+		ok &= memcmp(xk, x[k], n*sizeof(double)) == 0 && memcmp(Sk, S[k], nu*sizeof(double)) == 0 && memcmp(Kk, K[k], n*sizeof(double)) == 0;
+		ok &= memcmp(xu, x[k], n*sizeof(double)) == 0 && memcmp(Su, S[k], nu*sizeof(double)) == 0 && zb[k] == dz;
+	}
+	fsnav_linal_bank_predict_I_diag(Sb, q2b, n, m, nf);
+	for (k = 0; k < nf; k++) {
+		fsnav_linal_kalman_predict_I_diag(S[k], q2[k], n, m);
+		fsnav_linal_bank_get(NULL, Sk, xb, Sb, n, nf, k);
+		ok &= memcmp(Sk, S[k], nu*sizeof(double)) == 0;
+	}
+
+	return ok;
+}
+
+int main(void)
+{
+	const size_t n[] = {1, 2, 3, 5, 9, 17}, nf[] = {1, 7, 8, 13, 16, 24}; // nf = 1, 7 tail only, 8, 16, 24 full chunks only
+	size_t i, j, m;
+	char what[64];
+
+	srand(40);
+	for (i = 0; i < sizeof(n)/sizeof(n[0]); i++)
+		for (j = 0; j < sizeof(nf)/sizeof(nf[0]); j++)
+			for (m = (n[i] > 1) ? n[i]-1 : 1; m <= n[i]; m++) {
+				sprintf(what, "bank matches single filters, n %u, m %u, nf %u", (unsigned)n[i], (unsigned)m, (unsigned)nf[j]);
+				fsnav_test_check(equal(n[i], m, nf[j]), what);
+			}
+
+	return fsnav_test_result();
+}
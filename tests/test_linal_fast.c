@@ -0,0 +1,149 @@
+// polynomial (fast math) rotation and arctangent routines against libm over their whole argument range:
+// quadrant and octant edges, reduction boundaries, special values, pitch close to +-90 deg
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "fsnav.h"
+#include "fsnav_test.h"
+
+#define EUL2MAT_TOL 4e-16  // fsnav_linal_eul2mat_fast elements to the exact values
+#define ATAN2_TOL   6e-16  // fsnav_linal_atan2_fast to the exact value, rad
+#define MAT2RPY_TOL 1.5e-15 // fsnav_linal_mat2rpy_fast to fsnav_linal_mat2rpy, rad
+
+static const long double pi = 3.141592653589793238462643383279502884L;
+
+static double err_eul2mat, err_atan2, err_mat2rpy; // maximum errors
+static int    special_ok = 1;                      // special values passed to libm
+
+	// exact rotation matrix for e in long double: sin|e|/|e| and (1-cos|e|)/|e|^2 = 2*sin^2(|e|/2)/|e|^2 without cancellation
+static void eul2mat_exact(long double* R, double* e)
+{
+	long double e1 = (long double)e[0]*e[0], e2 = (long double)e[1]*e[1], e3 = (long double)e[2]*e[2], t, s, c;
+
+	t = sqrtl(e1 + e2 + e3);
+	if (t == 0)
+		s = 1, c = 0.5L;
+	else
+		s = sinl(t)/t, c = 2*sinl(t/2)*sinl(t/2)/(t*t);
+	R[0] =  1 - (e2 + e3)*c;         R[1] =  e[2]*s + e[0]*e[1]*c; R[2] = -e[1]*s + e[2]*e[0]*c;
+	R[3] = -e[2]*s + e[0]*e[1]*c;    R[4] =  1 - (e3 + e1)*c;      R[5] =  e[0]*s + e[1]*e[2]*c;
+	R[6] =  e[1]*s + e[2]*e[0]*c;    R[7] = -e[0]*s + e[1]*e[2]*c; R[8] =  1 - (e1 + e2)*c;
+}
+
+static void check_eul2mat(double e0, double e1, double e2)
+{
+	double e[3], R[9];
+	long double Rx[9];
+	int i;
+
+	e[0] = e0, e[1] = e1, e[2] = e2;
+	fsnav_linal_eul2mat_fast(R, e);
+	eul2mat_exact(Rx, e);
+	for (i = 0; i < 9; i++)
+		if (fabsl(R[i] - Rx[i]) > err_eul2mat)
+			err_eul2mat = (double)fabsl(R[i] - Rx[i]);
+}
+
+static void check_atan2(double y, double x)
+{
+	double a = fsnav_linal_atan2_fast(y, x), b = atan2(y, x);
+
+	if (!(fabs(x) > 0 && fabs(y) > 0) || !(fabs(x) + fabs(y) <= DBL_MAX)) { // zeros, infinities, NaN: libm result, bitwise
+		special_ok &= (isnan(a) && isnan(b)) || (a == b && signbit(a) == signbit(b));
+		return;
+	}
+	if (fabsl(a - atan2l(y, x)) > err_atan2)
+		err_atan2 = (double)fabsl(a - atan2l(y, x));
+}
+
+static void check_mat2rpy(double roll, double pitch, double yaw)
+{
+	double rpy[3], R[9], a[3], b[3];
+	int i;
+
+	rpy[0] = roll, rpy[1] = pitch, rpy[2] = yaw;
+	fsnav_linal_rpy2mat(R, rpy);
+	fsnav_linal_mat2rpy_fast(a, R);
+	fsnav_linal_mat2rpy     (b, R);
+	for (i = 0; i < 3; i++)
+		if (fabs(a[i] - b[i]) > err_mat2rpy)
+			err_mat2rpy = fabs(a[i] - b[i]);
+}
+
+int main(void)
+{
+	const double tg15 = 0.267949192431122706472553658494127633, pi_d = (double)pi;
+	const double edge[] = {0, 1, -1, 1e-300, 1e-8, 0.5, tg15, 1 - 1e-16, 1 + 1e-16, 1e8, 1e300, DBL_MAX, HUGE_VAL, -HUGE_VAL, NAN};
+	const double near[] = {0, 1e-16, 1e-12, 1e-8, 1e-6, 1e-4, 1e-2, 0.1, 0.5236}; // pi/2 - |pitch|, the last one below 30 deg
+	const size_t ne = sizeof(edge)/sizeof(edge[0]), nn = sizeof(near)/sizeof(near[0]);
+	double t, r, u, v, w;
+	size_t i, j, k;
+
+	// eul2mat: |e| from 0 to 1.25 (past the polynomial range), all directions, along axes and diagonals, at |e| = 1
+	for (i = 0; i <= 500; i++)
+		for (j = 0; j < 100; j++)
+			for (k = 0; k < 20; k++) {
+				r = 1.25*i/500, u = 2*pi_d*j/100, v = pi_d*(k + 0.5)/20;
+				check_eul2mat(r*sin(v)*cos(u), r*sin(v)*sin(u), r*cos(v));
+			}
+	for (i = 0; i < 3; i++)
+		for (r = 1e-12; r < 1.3; r *= 1.5) {
+			double e[3] = {0, 0, 0};
+			e[i] = r;
+			check_eul2mat(e[0], e[1], e[2]);
+			check_eul2mat(-e[0], -e[1], -e[2]);
+			check_eul2mat(r/sqrt(3), -r/sqrt(3), r/sqrt(3));
+		}
+	check_eul2mat(1, 0, 0);
+	check_eul2mat(nextafter(1, 2), 0, 0);
+	check_eul2mat(0.6, 0.8, 0);
+
+	// atan2: full circle at radii from tiny to huge, both sides of the octant (|x| = |y|) and reduction (tan 15 deg) boundaries
+	for (t = 1e-300; t < 1e300; t *= 1e30)
+		for (i = 0; i < 50000; i++) {
+			u = -pi_d + 2*pi_d*(i + 0.5)/50000;
+			check_atan2(t*sin(u), t*cos(u));
+		}
+	for (i = 0; i < 8; i++)
+		for (k = 0; k < 64; k++) {
+			u = (i & 1) ? -1 : 1, v = (i & 2) ? -1 : 1, w = (i & 4) ? tg15 : 1;
+			r = w;
+			for (j = 0; j < k; j++)
+				r = nextafter(r, (k & 1) ? 2 : 0);
+			check_atan2(u*r, v);
+			check_atan2(v, u*r);
+		}
+	for (i = 0; i < ne; i++)
+		for (j = 0; j < ne; j++) {
+			check_atan2( edge[i],  edge[j]);
+			check_atan2(-edge[i],  edge[j]);
+			check_atan2( edge[i], -edge[j]);
+			check_atan2(-edge[i], -edge[j]);
+		}
+
+	// mat2rpy: all roll and yaw quadrants, pitch over -90..90 deg, including both branches and pitch close to +-90 deg
+	for (i = 0; i <= 36; i++)
+		for (j = 0; j <= 36; j++)
+			for (k = 0; k <= 90; k++) {
+				u = -pi_d + 2*pi_d*i/36, w = -pi_d + 2*pi_d*j/36, v = -pi_d/2 + pi_d*k/90;
+				check_mat2rpy(u, v, w);
+				check_mat2rpy(u + 1e-3, v, w - 1e-3);
+			}
+	for (i = 0; i <= 36; i++)
+		for (j = 0; j <= 36; j++)
+			for (k = 0; k < nn; k++) {
+				u = -pi_d + 2*pi_d*i/36 + 0.01, w = -pi_d + 2*pi_d*j/36 + 0.02;
+				check_mat2rpy(u, pi_d/2 - near[k], w);
+				check_mat2rpy(u, near[k] - pi_d/2, w);
+			}
+
+	printf("maximum errors: eul2mat_fast %.2e, atan2_fast %.2e, mat2rpy_fast to mat2rpy %.2e\n", err_eul2mat, err_atan2, err_mat2rpy);
+	fsnav_test_check(err_eul2mat <= EUL2MAT_TOL, "eul2mat_fast is within its documented bound");
+	fsnav_test_check(err_atan2   <= ATAN2_TOL  , "atan2_fast is within its documented bound");
+	fsnav_test_check(err_mat2rpy <= MAT2RPY_TOL, "mat2rpy_fast is within its documented bound of mat2rpy");
+	fsnav_test_check(special_ok, "atan2_fast returns libm results for zeros, infinities and NaN");
+
+	return fsnav_test_result();
+}
@@ -0,0 +1,143 @@
+// quaternion attitude: fsnav_ins_attitude_quaternion follows fsnav_ins_attitude_rodrigues on the same angular rate stream
+// with Earth rate on; quaternion kernels: products with a conjugated operand, normalization on both sides of the Newton step bound
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fsnav.h"
+#include "ins/fsnav_ins_attitude.h"
+#include "fsnav_test.h"
+
+#define STEPS  60000 // sensor samples per run
+#define DT     0.01  // sample interval, s
+#define TOL    1e-8  // attitude matrix elements to Rodrigues' formula, deg
+
+static size_t step_no;   // number of regular steps taken
+static int    llh_on;    // coordinates valid (1), Earth rate applied, or not (0)
+static double L[9];      // attitude matrix after the last step
+
+	// sensor tumbling about all its axes at 55 deg north, 37 deg east, navigation frame slowly turning in addition to the Earth rate
+static void imu_source(void)
+{
+	double t;
+
+	if (fsnav->mode <= 0 || fsnav->imu == NULL)
+		return;
+	step_no++;
+	t = step_no*DT;
+	fsnav->imu->t = t;
+	fsnav->imu->w[0] = 0.3*sin(0.7*t);
+	fsnav->imu->w[1] = 0.2*cos(1.3*t);
+	fsnav->imu->w[2] = 0.1 + 0.05*sin(0.2*t);
+	fsnav->imu->w_valid = 1;
+	fsnav->imu->W[0] = -2e-5; fsnav->imu->W[1] = 3e-5; fsnav->imu->W[2] = 1e-5;
+	fsnav->imu->W_valid = 1;
+	fsnav->imu->sol.llh[0] = 37/fsnav->imu_const.rad2deg;
+	fsnav->imu->sol.llh[1] = 55/fsnav->imu_const.rad2deg;
+	fsnav->imu->sol.llh[2] = 0;
+	fsnav->imu->sol.llh_valid = llh_on;
+}
+
+static void observer(void)
+{
+	double *Ls;
+
+	if (fsnav->mode <= 0)
+		return;
+	Ls = fsnav_sol_get_L(&(fsnav->imu->sol));
+	if (Ls != NULL)
+		memcpy(L, Ls, sizeof(L));
+}
+
+	// run an attitude plugin over the samples, attitude matrix at the end
+static void run(char* cfg, void(*attitude)(void), double* L_end)
+{
+	step_no = 0;
+	fsnav->add_plugin(imu_source);
+	fsnav->add_plugin(attitude);
+	fsnav->add_plugin(observer);
+	fsnav->init(cfg);
+	fsnav->step(); // init cycle
+	while (step_no < STEPS)
+		fsnav->step();
+	memcpy(L_end, L, sizeof(L));
+	fsnav->terminate();
+	while (fsnav->step()); // termination cycle, the execution list is freed
+}
+
+	// maximum difference of matrix elements
+static double mismatch(double* A, double* B, size_t n)
+{
+	double d = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		if (!(fabs(A[i] - B[i]) <= d))
+			d = fabs(A[i] - B[i]);
+	return d;
+}
+
+	// quaternion of a given squared norm, normalized, the resulting norm less 1
+static double qnormalize_error(double n2)
+{
+	double q[4] = {0.8, -0.36, 0.48, 0}, k = sqrt(n2);
+	int i;
+
+	for (i = 0; i < 4; i++)
+		q[i] *= k;
+	fsnav_linal_qnormalize(q);
+	return sqrt(q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3]) - 1;
+}
+
+int main(void)
+{
+	char cfg[] = "{imu: }", cfg_fast[] = "{imu: fast_math}";
+	const double eps = 1.0/0x0100, under = eps*(1 - 1.0/0x0400), over = eps*(1 + 1.0/0x0400); // Newton step bound 2^-8 and |n2 - 1| around it
+	double L_r[9], L_q[9], L_e[9], d, d_fast, d_earth, rad2deg;
+	double q[4] = {0.5, -0.1, 0.7, 0.5}, r[4] = {-0.3, 0.9, 0.2, 0.25}, qc[4], rc[4], a[4], b[4];
+	double e_under[2], e_over[2];
+	int i;
+
+	// quaternion against Rodrigues' formula, libm and fast routines, then quaternion without Earth rate
+	llh_on = 1;
+	run(cfg, fsnav_ins_attitude_rodrigues, L_r);
+	run(cfg, fsnav_ins_attitude_quaternion, L_q);
+	rad2deg = fsnav->imu_const.rad2deg;
+	d = mismatch(L_r, L_q, 9)*rad2deg;
+	run(cfg_fast, fsnav_ins_attitude_rodrigues, L_r);
+	run(cfg_fast, fsnav_ins_attitude_quaternion, L_e);
+	d_fast = mismatch(L_r, L_e, 9)*rad2deg;
+	llh_on = 0;
+	run(cfg, fsnav_ins_attitude_quaternion, L_e);
+	d_earth = mismatch(L_q, L_e, 9)*rad2deg;
+	printf("quaternion to Rodrigues' attitude over %d samples: %.2e deg, fast math %.2e deg, Earth rate effect %.2e deg\n",
+		STEPS, d, d_fast, d_earth);
+	fsnav_test_check(d < TOL, "quaternion attitude follows Rodrigues' formula with Earth rate on");
+	fsnav_test_check(d_fast < TOL, "quaternion attitude follows Rodrigues' formula with Earth rate on, fast math");
+	fsnav_test_check(d_earth > 1e4*TOL, "Earth rate is applied to the quaternion attitude");
+
+	// products with a conjugated operand against explicit conjugates
+	qc[0] = q[0], rc[0] = r[0];
+	for (i = 1; i < 4; i++)
+		qc[i] = -q[i], rc[i] = -r[i];
+	fsnav_linal_qmul1C(a, q, r);
+	fsnav_linal_qmul  (b, qc, r);
+	fsnav_test_check(mismatch(a, b, 4) < 4*DBL_EPSILON, "fsnav_linal_qmul1C matches the product with the first quaternion conjugated");
+	fsnav_linal_qmul2C(a, q, r);
+	fsnav_linal_qmul  (b, q, rc);
+	fsnav_test_check(mismatch(a, b, 4) < 4*DBL_EPSILON, "fsnav_linal_qmul2C matches the product with the second quaternion conjugated");
+
+	// normalization: a Newton step with 3/8*(n2 - 1)^2 residual within 2^-8 of unit norm, exact beyond
+	e_under[0] = qnormalize_error(1 - under), e_under[1] = qnormalize_error(1 + under);
+	e_over [0] = qnormalize_error(1 - over ), e_over [1] = qnormalize_error(1 + over );
+	printf("normalized quaternion norm less 1, |n2 - 1| just under 2^-8: %.2e %.2e, just over: %.2e %.2e\n",
+		e_under[0], e_under[1], e_over[0], e_over[1]);
+	for (i = 0; i < 2; i++) {
+		fsnav_test_check(fabs(e_under[i]) <= 3.0/8*under*under*1.01 + 4*DBL_EPSILON, "Newton step normalization is within its residual bound just under 2^-8");
+		fsnav_test_check(fabs(e_over[i]) <= 4*DBL_EPSILON, "normalization is exact just over 2^-8");
+	}
+
+	return fsnav_test_result();
+}
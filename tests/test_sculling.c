@@ -0,0 +1,169 @@
+// reduced-rate navigation with sculling compensation: updates resume after invalid sensor samples,
+// and under sculling motion the updates follow full-rate navigation, while the same increments without compensation do not
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fsnav.h"
+#include "ins/fsnav_ins_attitude.h"
+#include "ins/fsnav_ins_gravity.h"
+#include "ins/fsnav_ins_motion.h"
+#include "fsnav_test.h"
+
+#define STEPS   2000  // sensor samples per run
+#define DT      0.005 // sample interval, s
+#define N       10    // samples per reduced-rate navigation update
+#define OMEGA   (2*3.14159265358979323846*5) // vibration frequency, rad/s
+#define ANGLE   0.002 // angular vibration amplitude about the instrumental x axis, rad, small for the first order rotation terms of the compensation
+#define ACCEL   5     // linear vibration amplitude along the instrumental y axis, in phase with the angle, m/s^2
+#define TOL_V   1e-4  // velocity to full-rate navigation, m/s
+
+static size_t step_no;             // number of regular steps taken
+static int    dropouts;            // static sensor with invalid samples (1) or sculling motion (0)
+static char   updated[STEPS + 1];  // navigation update flags by step
+static double llh[STEPS + 1][3];   // coordinates by step
+static double v  [STEPS + 1][3];   // velocity by step
+static double dv [STEPS + 1][3];   // rotation and sculling compensation applied up to the step, navigation frame
+static fsnav_accum* acc;           // observer's own increment accumulator, read on navigation updates
+static double L0[9];               // attitude matrix at the last navigation update
+
+	// dropouts: level, non-rotating sensor with vertical specific force off the gravity, invalid specific force on step 20 and angular rate on step 40;
+	// otherwise: angular vibration about x and linear vibration along y in phase, sampled at the middle of each interval
+static void imu_source(void)
+{
+	size_t i;
+	double t;
+
+	if (fsnav->mode <= 0 || fsnav->imu == NULL)
+		return;
+	step_no++;
+	fsnav->imu->t += dropouts ? 0.01 : DT;
+	if (dropouts) {
+		for (i = 0; i < 9; i++)
+			fsnav->imu->sol.L[i] = (i%4 == 0);
+		fsnav->imu->sol.L_valid = 1;
+		fsnav_sol_set_att(&(fsnav->imu->sol), FSNAV_SOL_L);
+		fsnav->imu->w[0] = 0; fsnav->imu->w[1] = 0; fsnav->imu->w[2] = 0;
+		fsnav->imu->f[0] = 0; fsnav->imu->f[1] = 0; fsnav->imu->f[2] = 10;
+		fsnav->imu->w_valid = step_no != 40;
+		fsnav->imu->f_valid = step_no != 20;
+		return;
+	}
+	t = (step_no - 0.5)*DT;
+	fsnav->imu->w[0] = ANGLE*OMEGA*cos(OMEGA*t); fsnav->imu->w[1] = 0;                    fsnav->imu->w[2] = 0;
+	fsnav->imu->f[0] = 0;                        fsnav->imu->f[1] = ACCEL*sin(OMEGA*t);   fsnav->imu->f[2] = 9.81;
+	fsnav->imu->w_valid = 1;
+	fsnav->imu->f_valid = 1;
+}
+
+	// navigation update detection by a change of coordinates,
+	// compensation L0^T*((a x v)/2 + s) over the same intervals as the sculling plugin, from the observer's own accumulator
+static void observer(void)
+{
+	double c[3], d[3], *L;
+	size_t i;
+
+	if (fsnav->mode == 0)
+		acc = fsnav->attach_accum(observer, 0);
+	if (fsnav->mode <= 0 || step_no > STEPS)
+		return;
+	updated[step_no] = memcmp(llh[step_no-1], fsnav->imu->sol.llh, sizeof(llh[0])) != 0;
+	memcpy(llh[step_no], fsnav->imu->sol.llh, sizeof(llh[0]));
+	memcpy(v  [step_no], fsnav->imu->sol.v  , sizeof(v  [0]));
+	memcpy(dv [step_no], dv[step_no-1]      , sizeof(dv [0]));
+	L = fsnav_sol_get_L(&(fsnav->imu->sol));
+	if (acc == NULL || L == NULL || (step_no > 1 && !updated[step_no]))
+		return;
+	if (step_no > 1) {
+		fsnav_linal_cross3x1(c, acc->a, acc->v);
+		for (i = 0; i < 3; i++)
+			c[i] = c[i]/2 + acc->s[i];
+		fsnav_linal_mmul1T3x1(d, L0, c);
+		for (i = 0; i < 3; i++)
+			dv[step_no][i] += d[i];
+	}
+	fsnav->reset_accum(acc);
+	memcpy(L0, L, sizeof(L0));
+}
+
+	// run the sensor over a motion plugin, output at every step
+static void run(char* cfg, void(*motion)(void), size_t steps)
+{
+	step_no = 0;
+	memset(updated, 0, sizeof(updated));
+	memset(dv, 0, sizeof(dv));
+	fsnav->add_plugin(imu_source);
+	fsnav->add_plugin(fsnav_accumulate_imu);
+	fsnav->add_plugin(fsnav_ins_gravity_normal);
+	if (!dropouts)
+		fsnav->add_plugin(fsnav_ins_attitude_rodrigues);
+	fsnav->add_plugin(motion);
+	fsnav->add_plugin(observer);
+	fsnav->init(cfg);
+	fsnav->step(); // init cycle
+	memcpy(llh[0], fsnav->imu->sol.llh, sizeof(llh[0]));
+	while (step_no < steps)
+		fsnav->step();
+	fsnav->terminate();
+	while (fsnav->step()); // termination cycle, the execution list is freed
+}
+
+static size_t updates(size_t from, size_t to)
+{
+	size_t k, n = 0;
+
+	for (k = from; k <= to; k++)
+		n += updated[k];
+	return n;
+}
+
+	// maximum velocity difference to a reference over the navigation updates, with the compensation (1) or without it (0), m/s
+static double mismatch(double (*v_ref)[3], int compensated)
+{
+	double d = 0, e;
+	size_t k, i;
+
+	for (k = 1; k <= STEPS; k++)
+		for (i = 0; updated[k] && i < 3; i++) {
+			e = fabs(v[k][i] - (compensated ? 0 : dv[k][i]) - v_ref[k][i]);
+			if (!(e <= d))
+				d = e;
+		}
+	return d;
+}
+
+int main(void)
+{
+	static double v_ref[STEPS + 1][3];
+	char cfg_dropouts[] = "{imu: sculling_rate = 20, lat = 55}", cfg_full[] = "{imu: lat = 55}", cfg[64];
+	double d_sculling, d_plain;
+	size_t k;
+
+	// 100 Hz samples, navigation updates every 5 samples, invalid samples
+	dropouts = 1;
+	run(cfg_dropouts, fsnav_ins_motion_sculling, 80);
+	printf("navigation updates: steps 1..19 %u, 21..39 %u, 41..80 %u\n",
+		(unsigned)updates(1, 19), (unsigned)updates(21, 39), (unsigned)updates(41, 80));
+	fsnav_test_check(updates(1, 19) >= 3, "navigation is updated before the invalid samples");
+	fsnav_test_check(updates(21, 39) >= 3, "navigation updates resume after an invalid specific force sample");
+	fsnav_test_check(updates(41, 80) >= 7, "navigation updates resume after an invalid angular rate sample");
+	fsnav_test_check(!updated[20] && !updated[40], "no navigation update on an invalid sample");
+
+	// sculling motion: full-rate Euler navigation as the reference, then sculling every N samples
+	dropouts = 0;
+	run(cfg_full, fsnav_ins_motion_euler, STEPS);
+	for (k = 0; k <= STEPS; k++)
+		v_ref[k][0] = v[k][0], v_ref[k][1] = v[k][1], v_ref[k][2] = v[k][2];
+	sprintf(cfg, "{imu: sculling_rate = %g, lat = 55}", 1/(N*DT));
+	run(cfg, fsnav_ins_motion_sculling, STEPS);
+	d_sculling = mismatch(v_ref, 1);
+	d_plain    = mismatch(v_ref, 0);
+	printf("sculling motion, velocity to full-rate navigation over %u updates: %.2e m/s, %.2e m/s without compensation\n",
+		(unsigned)updates(1, STEPS), d_sculling, d_plain);
+	fsnav_test_check(updates(1, STEPS) >= STEPS/N - 1, "sculling navigation is updated every N samples");
+	fsnav_test_check(d_sculling < TOL_V, "sculling navigation follows full-rate navigation under sculling motion");
+	fsnav_test_check(d_plain > 10*TOL_V, "the same increments without compensation depart from full-rate navigation");
+
+	return fsnav_test_result();
+}
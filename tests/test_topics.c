@@ -0,0 +1,97 @@
+// bus topics: subscribed plugins are called once per signal, on their scheduled ticks
+
+#include <stdio.h>
+
+#include "fsnav.h"
+#include "ins/fsnav_ins_alignment.h"
+#include "fsnav_test.h"
+
+static size_t step_no;    // number of regular steps taken
+static size_t signals;    // number of signals emitted by the producer
+static size_t calls_each; // calls of the subscriber called every tick
+static size_t calls_odd;  // calls of the subscriber scheduled on odd ticks
+static size_t calls_aligned;  // calls of the alignment subscriber
+static size_t aligned_step;   // step of the alignment signal handling
+static unsigned int topics_seen; // topics passed to subscribers
+
+static void producer(void)
+{
+	if (fsnav->mode <= 0)
+		return;
+	step_no++;
+	// signal on steps 3, 8, 9 and twice on step 12
+	if (step_no == 3 || step_no == 8 || step_no == 9 || step_no == 12) {
+		fsnav->signal(FSNAV_TOPIC_GNSS);
+		signals++;
+	}
+	if (step_no == 12)
+		fsnav->signal(FSNAV_TOPIC_GNSS);
+}
+
+static void subscriber_each(void)
+{
+	if (fsnav->mode <= 0)
+		return;
+	calls_each++;
+	topics_seen |= fsnav->core.current_topics;
+}
+
+static void subscriber_odd(void)
+{
+	if (fsnav->mode <= 0)
+		return;
+	calls_odd++;
+}
+
+static void imu_source(void)
+{
+	if (fsnav->mode <= 0 || fsnav->imu == NULL)
+		return;
+	fsnav->imu->t += 0.01;
+	fsnav->imu->w[0] = 0; fsnav->imu->w[1] = 4e-5; fsnav->imu->w[2] = 6e-5;
+	fsnav->imu->f[0] = 0; fsnav->imu->f[1] = 0; fsnav->imu->f[2] = 9.8;
+	fsnav->imu->w_valid = 1;
+	fsnav->imu->f_valid = 1;
+}
+
+static void alignment_subscriber(void)
+{
+	if (fsnav->mode <= 0)
+		return;
+	calls_aligned++;
+	aligned_step = step_no;
+	fsnav_test_check(fsnav->core.current_topics == FSNAV_TOPIC_ALIGNMENT, "alignment subscriber gets the alignment topic");
+	fsnav_test_check(fsnav->imu->sol.L_valid, "attitude is valid when alignment is signalled");
+}
+
+int main(void)
+{
+	size_t k;
+	char cfg[] = "{imu: alignment = 0.1}";
+
+	// synthetic producer and subscribers, alignment plugin signalling its completion at t > 0.1, on step 11
+	fsnav->add_plugin(producer);
+	fsnav->add_plugin(subscriber_each);
+	fsnav->schedule_plugin(subscriber_odd, 2, 1);
+	fsnav->add_plugin(imu_source);
+	fsnav->add_plugin(fsnav_ins_alignment_static);
+	fsnav->add_plugin(alignment_subscriber);
+	fsnav->subscribe_plugin(subscriber_each, FSNAV_TOPIC_GNSS);
+	fsnav->subscribe_plugin(subscriber_odd, FSNAV_TOPIC_GNSS | FSNAV_TOPIC_AIR);
+	fsnav->subscribe_plugin(alignment_subscriber, FSNAV_TOPIC_ALIGNMENT);
+	fsnav->init(cfg);
+	for (k = 0; k < 50; k++)
+		fsnav->step();
+
+	// signals on steps 3, 8, 9, 12, the odd-tick subscriber is due on steps 1, 3, 5, ...: called on 3, 9 (for 8 and 9) and 13
+	fsnav_test_check(calls_each == signals, "every-tick subscriber is called exactly once per signalling step");
+	fsnav_test_check(calls_odd  == 3, "scheduled subscriber merges signals between its ticks");
+	fsnav_test_check(topics_seen == FSNAV_TOPIC_GNSS, "subscriber sees the signalled topic only");
+	fsnav_test_check(calls_aligned == 1, "alignment subscriber is called exactly once");
+	fsnav_test_check(aligned_step == 11, "alignment subscriber is called on the step alignment ends");
+	printf("signals %u, every-tick subscriber calls %u, odd-tick subscriber calls %u, alignment subscriber calls %u on step %u\n", 
+		(unsigned)signals, (unsigned)calls_each, (unsigned)calls_odd, (unsigned)calls_aligned, (unsigned)aligned_step);
+
+	fsnav->terminate();
+	return fsnav_test_result();
+}